@@ -1,11 +1,15 @@
 #include <CLI/CLI.hpp>
+#include <algorithm>
 #include <htslib/faidx.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <artic/amplitig.hpp>
 #include <artic/log.hpp>
 #include <artic/primerScheme.hpp>
+#include <artic/primerScreen.hpp>
+#include <artic/schemeDetector.hpp>
 #include <artic/softmask.hpp>
 #include <artic/vcfCheck.hpp>
 #include <artic/version.hpp>
@@ -34,7 +38,9 @@ int main(int argc, char** argv)
     CLI::App* getterCmd = app.add_subcommand("get_scheme", "Download an ARTIC primer scheme and reference sequence");
     CLI::App* validatorCmd = app.add_subcommand("validate_scheme", "Validate an amplicon scheme for compliance with ARTIC standards");
     CLI::App* vcfFilterCmd = app.add_subcommand("check_vcf", "Check a VCF file based on primer scheme info and user-defined cut offs");
-    //CLI::App* amplitigCmd = app.add_subcommand("get_amplitigs", "Generate amplitigs from a reference alignment");
+    CLI::App* amplitigCmd = app.add_subcommand("get_amplitigs", "Bin amplicon reads to their amplicons using primer k-mers");
+    CLI::App* detectorCmd = app.add_subcommand("detect_scheme", "Detect the primer scheme used for a sample from the primer k-mers at its read ends");
+    CLI::App* screenCmd = app.add_subcommand("screen_primers", "Screen the primer binding sites of a scheme against a collection of genomes to find primers at risk of dropout");
 
     // set up a struct to pass arguments
     // TODO: have a constructor for defaults?
@@ -47,14 +53,44 @@ int main(int argc, char** argv)
     std::string outFileName;
     unsigned int minMAPQ = 15;
     unsigned int normalise = 100;
-    //unsigned int kmerSize = 11;
-    //float kmerMatches = 0.4;
+    unsigned int kmerSize = 11;
+    float kmerMatches = 0.4;
+    unsigned int numThreads = std::max(1U, std::thread::hardware_concurrency());
+    std::string fastqPrefix;
+    unsigned int compressionThreads = 2;
+    unsigned int decompressionThreads = 2;
+    unsigned int endWindow = 0;
+    std::vector<std::string> seeds;
+    bool binByPool = false;
+    bool trimPrimers = false;
+    bool splitChimeras = false;
+    bool minimizerFallback = false;
+    bool abundance = false;
+    unsigned int minimizerKmerSize = 15;
+    unsigned int minimizerWindow = 10;
+    float minimizerMatch = 0.1;
+    unsigned int maxDepth = 0;
+    unsigned int minReadLength = 100;
+    unsigned int maxReadLength = 0;
+    bool reservoir = false;
+    uint64_t seed = 0;
+    std::string amplitigPrefix;
+    std::string watchDir;
+    std::string snapshotFile = "amplitigs.snapshot.json";
+    unsigned int targetDepth = 0;
+    unsigned int idleTimeout = 0;
+    unsigned int snapshotInterval = 30;
+    unsigned int graphKmerSize = 15;
+    unsigned int minKmerCount = 3;
     bool primerStart = false;
     bool removeBadPairs = false;
     bool noReadGroups = false;
     bool verbose = false;
     softmaskCmd->add_option("-b,--inputFile", inputFile, "The input BAM file (will try STDIN if not provided)");
-    softmaskCmd->add_option("scheme", schemeArgs.schemeFile, "The ARTIC primer scheme")->required()->check(CLI::ExistingFile);
+    auto softmaskSchemeGroup = softmaskCmd->add_option_group("scheme", "A scheme file or a builtin scheme (one is required)");
+    softmaskSchemeGroup->add_option("scheme", schemeArgs.schemeFile, "The ARTIC primer scheme")->check(CLI::ExistingFile);
+    softmaskSchemeGroup->add_option("--builtin-scheme", schemeArgs.builtinScheme, "Use a builtin ARTIC primer scheme instead of a scheme file (e.g. scov2/v3)");
+    softmaskSchemeGroup->require_option(1);
     softmaskCmd->add_option("--minMAPQ", minMAPQ, "A minimum MAPQ threshold for processing alignments (default = 15)");
     softmaskCmd->add_option("--normalise", normalise, "Subsample to N coverage per strand (default = 100, deactivate with 0)");
     softmaskCmd->add_option("--report", outFileName, "Output an align_trim report to file");
@@ -64,13 +100,77 @@ int main(int argc, char** argv)
     softmaskCmd->add_flag("--verbose", verbose, "Output debugging information to STDERR");
 
     // add amplitig options and flags
-    /*
-    amplitigCmd->add_option("-i,--fastqFiles", inputFiles, "The input FASTQ files")->required();
-    amplitigCmd->add_option("scheme", schemeArgs.schemeFile, "The ARTIC primer scheme")->required()->check(CLI::ExistingFile);
-    amplitigCmd->add_option("-r,--refSeq", schemeArgs.refSeqFile, "The reference sequence for the primer scheme (FASTA format)")->required();
+    auto fastqFiles = amplitigCmd->add_option("-i,--fastqFiles", inputFiles, "The input FASTQ files")->check(CLI::ExistingFile);
+    auto watch = amplitigCmd->add_option("-w,--watch", watchDir, "Watch a directory for new FASTQ files (e.g. MinKNOW output) instead of reading the input files")->check(CLI::ExistingDirectory)->excludes(fastqFiles);
+    amplitigCmd->add_option("--snapshot", snapshotFile, "The JSON snapshot of the amplicon counts to rewrite while watching (default = amplitigs.snapshot.json)")->needs(watch);
+    amplitigCmd->add_option("--targetDepth", targetDepth, "Stop watching once every amplicon has this many reads (default = 0, no target)")->needs(watch);
+    amplitigCmd->add_option("--idleTimeout", idleTimeout, "Stop watching if no new FASTQ files arrive for this many seconds (default = 0, no timeout)")->needs(watch);
+    amplitigCmd->add_option("--snapshotInterval", snapshotInterval, "The number of seconds between snapshots while watching (default = 30)")->needs(watch);
+    auto amplitigSchemeGroup = amplitigCmd->add_option_group("scheme", "A scheme file or a builtin scheme (one is required)");
+    amplitigSchemeGroup->add_option("scheme", schemeArgs.schemeFile, "The ARTIC primer scheme")->check(CLI::ExistingFile);
+    amplitigSchemeGroup->add_option("--builtin-scheme", schemeArgs.builtinScheme, "Use a builtin ARTIC primer scheme instead of a scheme file (e.g. scov2/v3)");
+    amplitigSchemeGroup->require_option(1);
+    amplitigCmd->add_option("-r,--refSeq", schemeArgs.refSeqFile, "The reference sequence for the primer scheme (FASTA format)")->required()->check(CLI::ExistingFile);
     amplitigCmd->add_option("-k,--kmerSize", kmerSize, "The k-mer size to use (default = 11)");
     amplitigCmd->add_option("-m,--kmerMatches", kmerMatches, "The proportion of primer k-mers required to match to a read (default = 0.4)");
-    */
+    amplitigCmd->add_option("-t,--threads", numThreads, "The number of binning threads to use (default = all available)");
+    amplitigCmd->add_option("--decompressionThreads", decompressionThreads, "The number of threads to use for decompressing BGZF input (default = 2)");
+    amplitigCmd->add_option("--seeds", seeds, "Use spaced seed patterns for the primer k-mers instead of contiguous k-mers (e.g. 110111010111011), overrides -k");
+    amplitigCmd->add_flag("--splitChimeras", splitChimeras, "Split reads containing more than one amplicon (e.g. ligation concatemers) into a sub-read per amplicon");
+    auto fallback = amplitigCmd->add_flag("--minimizerFallback", minimizerFallback, "Bin reads without intact primers by matching their minimizers to the amplicon inserts");
+    amplitigCmd->add_option("--minimizerKmerSize", minimizerKmerSize, "The k-mer size to use for the insert minimizers (default = 15)")->needs(fallback);
+    amplitigCmd->add_option("--minimizerWindow", minimizerWindow, "The number of k-mers in each minimizer window (default = 10)")->needs(fallback);
+    amplitigCmd->add_option("--minimizerMatch", minimizerMatch, "The proportion of read minimizers required to match an amplicon insert (default = 0.1)")->needs(fallback);
+    amplitigCmd->add_option("--minReadLength", minReadLength, "Drop reads shorter than this (default = 100)");
+    amplitigCmd->add_option("--maxReadLength", maxReadLength, "Drop reads longer than this (default = 0, 10% longer than the longest amplicon in the scheme)");
+    amplitigCmd->add_option("--endWindow", endWindow, "Only search this many bases at each read end for primers, scanning the whole read if no amplicon is found (default = 0, always scan the whole read)");
+    auto fastqOut = amplitigCmd->add_option("-o,--fastqOut", fastqPrefix, "If provided, will write binned reads to compressed FASTQ files using this prefix (<prefix>.<amplicon>.fastq.gz)");
+    amplitigCmd->add_flag("--binByPool", binByPool, "Write one FASTQ file per primer pool instead of per amplicon")->needs(fastqOut);
+    amplitigCmd->add_flag("--trimPrimers", trimPrimers, "Trim the primers, and any adapter beyond them, from the reads written to FASTQ")->needs(fastqOut);
+    auto depthCap = amplitigCmd->add_option("--normalise", maxDepth, "Only write up to N reads per amplicon strand to FASTQ (default = 0, no cap)")->needs(fastqOut);
+    auto reservoirFlag = amplitigCmd->add_flag("--reservoir", reservoir, "Write a random sample of reads for amplicon strands over the --normalise cap, instead of the first reads")->needs(depthCap);
+    amplitigCmd->add_option("--seed", seed, "The seed used for --reservoir sampling (default = 0)")->needs(reservoirFlag);
+    auto amplitigOut = amplitigCmd->add_option("--amplitigs", amplitigPrefix, "If provided, will build an amplitig for each amplicon and stitch them into a draft genome (<prefix>.amplitigs.fasta and <prefix>.draft.fasta)");
+    amplitigCmd->add_option("--graphKmerSize", graphKmerSize, "The k-mer size to use for the amplitig graphs (default = 15)")->needs(amplitigOut);
+    amplitigCmd->add_option("--minKmerCount", minKmerCount, "The number of times a k-mer must be seen for it to be used in an amplitig (default = 3)")->needs(amplitigOut);
+    amplitigCmd->add_flag("--abundance", abundance, "Write a report of the reads per amplicon and per pool instead of the read assignments")->excludes(fastqOut)->excludes(amplitigOut);
+    amplitigCmd->add_option("--compressionThreads", compressionThreads, "The number of threads to use for FASTQ compression (default = 2)")->needs(fastqOut);
+
+    // add detector options and flags
+    std::vector<std::string> candidateSchemes;
+    std::vector<std::string> candidateBuiltins;
+    unsigned int detectorKmerSize = 15;
+    unsigned int detectorWindow = 100;
+    unsigned int minHits = 3;
+    uint64_t maxReads = 10000;
+    detectorCmd->add_option("-i,--fastqFiles", inputFiles, "The input FASTQ files")->required()->check(CLI::ExistingFile);
+    detectorCmd->add_option("schemes", candidateSchemes, "The candidate ARTIC primer schemes")->check(CLI::ExistingFile);
+    detectorCmd->add_option("--builtin-schemes", candidateBuiltins, "Builtin ARTIC primer schemes to use as candidates (default = all builtin schemes if no scheme files are given)");
+    detectorCmd->add_option("-r,--refSeq", schemeArgs.refSeqFile, "The reference sequence shared by the candidate schemes (FASTA format)")->required()->check(CLI::ExistingFile);
+    detectorCmd->add_option("-k,--kmerSize", detectorKmerSize, "The k-mer size to use (default = 15)");
+    detectorCmd->add_option("--endWindow", detectorWindow, "The number of bases to search for primers at each read end (default = 100)");
+    detectorCmd->add_option("--minHits", minHits, "The number of read ends a primer k-mer must be found at to count (default = 3)");
+    detectorCmd->add_option("-n,--maxReads", maxReads, "The number of reads to sample from the start of the input (default = 10000, 0 for all reads)");
+
+    // add screen options and flags
+    std::vector<std::string> genomeFiles;
+    unsigned int searchWindow = 100;
+    unsigned int threePrimeBases = 5;
+    unsigned int threePrimeWeight = 3;
+    unsigned int riskScore = 3;
+    float riskProportion = 0.01;
+    auto screenSchemeGroup = screenCmd->add_option_group("scheme", "A scheme file or a builtin scheme (one is required)");
+    screenSchemeGroup->add_option("scheme", schemeArgs.schemeFile, "The ARTIC primer scheme")->check(CLI::ExistingFile);
+    screenSchemeGroup->add_option("--builtin-scheme", schemeArgs.builtinScheme, "Use a builtin ARTIC primer scheme instead of a scheme file (e.g. scov2/v3)");
+    screenSchemeGroup->require_option(1);
+    screenCmd->add_option("-r,--refSeq", schemeArgs.refSeqFile, "The reference sequence for the primer scheme (FASTA format)")->required()->check(CLI::ExistingFile);
+    screenCmd->add_option("-g,--genomes", genomeFiles, "The genome files to screen (FASTA format, in the same orientation as the reference)")->required()->check(CLI::ExistingFile);
+    screenCmd->add_option("-t,--threads", numThreads, "The number of screening threads to use (default = all available)");
+    screenCmd->add_option("--searchWindow", searchWindow, "The number of bases either side of each primer site to search in a genome (default = 100)");
+    screenCmd->add_option("--threePrimeBases", threePrimeBases, "The number of bases at the 3' end of a primer where edits count extra (default = 5)");
+    screenCmd->add_option("--threePrimeWeight", threePrimeWeight, "The weight of an edit in the 3' bases of a primer (default = 3)");
+    screenCmd->add_option("--riskScore", riskScore, "The weighted edit score at which a primer is at risk of dropout for a genome (default = 3)");
+    screenCmd->add_option("--riskProportion", riskProportion, "The proportion of genomes that must be at risk for a primer to be reported (default = 0.01)");
 
     // add get options and flags
     getterCmd->add_option("scheme", schemeArgs.schemeName, "The name of the scheme to download (ebola|nipah|scov2)")->required();
@@ -78,7 +178,10 @@ int main(int argc, char** argv)
     getterCmd->add_option("-o,--outDir", schemeArgs.outDir, "The directory to write the scheme and reference sequence to");
 
     // add validator options and flags
-    validatorCmd->add_option("scheme", schemeArgs.schemeFile, "The primer scheme to validate")->required()->check(CLI::ExistingFile);
+    auto validatorSchemeGroup = validatorCmd->add_option_group("scheme", "A scheme file or a builtin scheme (one is required)");
+    validatorSchemeGroup->add_option("scheme", schemeArgs.schemeFile, "The primer scheme to validate")->check(CLI::ExistingFile);
+    validatorSchemeGroup->add_option("--builtin-scheme", schemeArgs.builtinScheme, "Validate a builtin ARTIC primer scheme instead of a scheme file (e.g. scov2/v3)");
+    validatorSchemeGroup->require_option(1);
     validatorCmd->add_option("-o,--outputPrimerSeqs", schemeArgs.primerSeqsFile, "If provided, will write primer sequences as multiFASTA (requires --refSeq to be provided)");
     validatorCmd->add_option("-r,--refSeq", schemeArgs.refSeqFile, "The reference sequence for the primer scheme (FASTA format)");
     validatorCmd->add_option("--outputInserts", schemeArgs.insertsFile, "If provided, will write primer scheme inserts as BED (exluding primer sequences)");
@@ -88,7 +191,10 @@ int main(int argc, char** argv)
     std::string vcfOut;
     float minVarQual = 10.0;
     vcfFilterCmd->add_option("vcf", vcfIn, "The input VCF file to filter")->required()->check(CLI::ExistingFile);
-    vcfFilterCmd->add_option("scheme", schemeArgs.schemeFile, "The primer scheme to use")->required()->check(CLI::ExistingFile);
+    auto vcfFilterSchemeGroup = vcfFilterCmd->add_option_group("scheme", "A scheme file or a builtin scheme (one is required)");
+    vcfFilterSchemeGroup->add_option("scheme", schemeArgs.schemeFile, "The primer scheme to use")->check(CLI::ExistingFile);
+    vcfFilterSchemeGroup->add_option("--builtin-scheme", schemeArgs.builtinScheme, "Use a builtin ARTIC primer scheme instead of a scheme file (e.g. scov2/v3)");
+    vcfFilterSchemeGroup->require_option(1);
     vcfFilterCmd->add_option("-o,--summaryOut", outFileName, "Summary of variant checks will be written here (TSV format)")->required();
     vcfFilterCmd->add_option("--vcfOut", vcfOut, "If provided, will write variants that pass checks to this file");
     vcfFilterCmd->add_option("-q,--minQual", minVarQual, "Minimum quality score to keep a variant (default = 10)");
@@ -107,16 +213,32 @@ int main(int argc, char** argv)
     // add the amplitigger callback
     // 1. vadlidate the primer scheme
     // 2. collect the primer k-mers
-    // 2. run the amplitiger
-    /*
+    // 3. run the amplitigger
     amplitigCmd->callback([&]() {
         artic::Log::Init("get_amplitigs");
         LOG_TRACE("starting amplitigger");
         auto ps = artic::ValidateScheme(schemeArgs);
-        auto amplitigger = artic::Amplitigger(&ps, schemeArgs.refSeqFile, inputFiles, kmerSize, kmerMatches);
-        amplitigger.Run();
+        artic::Amplitigger amplitigger(&ps, schemeArgs.refSeqFile, inputFiles, kmerSize, kmerMatches, numThreads);
+        if (!seeds.empty())
+            amplitigger.SetSpacedSeeds(seeds);
+        amplitigger.SetReadLengthLimits(minReadLength, maxReadLength);
+        amplitigger.SetEndWindow(endWindow);
+        amplitigger.SetDecompressionThreads(decompressionThreads);
+        amplitigger.SetChimeraSplitting(splitChimeras);
+        amplitigger.SetAbundanceReport(abundance);
+        if (minimizerFallback)
+            amplitigger.SetMinimizerFallback(minimizerKmerSize, minimizerWindow, minimizerMatch);
+        if (!fastqPrefix.empty())
+            amplitigger.SetFastqOutput(fastqPrefix, binByPool ? artic::BinOutput::pool : artic::BinOutput::amplicon, compressionThreads);
+        amplitigger.SetPrimerTrimming(trimPrimers);
+        amplitigger.SetDepthCap(maxDepth, reservoir ? artic::DepthCapMode::reservoir : artic::DepthCapMode::firstN, seed);
+        if (!amplitigPrefix.empty())
+            amplitigger.SetConsensusOutput(amplitigPrefix, graphKmerSize, minKmerCount);
+        if (!watchDir.empty())
+            amplitigger.Watch(watchDir, snapshotFile, targetDepth, idleTimeout, snapshotInterval);
+        else
+            amplitigger.Run();
     });
-    */
 
     // add the getter callback
     // 1. download the scheme
@@ -136,6 +258,76 @@ int main(int argc, char** argv)
         artic::ValidateScheme(schemeArgs);
     });
 
+    // add the detector callback
+    // 1. load the candidate schemes
+    // 2. collect their primer k-mers
+    // 3. stream a sample of reads through the detector
+    detectorCmd->callback([&]() {
+        artic::Log::Init("detect_scheme");
+        LOG_TRACE("starting primer scheme detector");
+        std::vector<artic::PrimerScheme> schemes;
+        std::vector<std::string> names;
+        for (const auto& schemeFile : candidateSchemes)
+        {
+            schemes.emplace_back(schemeFile);
+            names.emplace_back(schemeFile);
+        }
+        if (candidateSchemes.empty() && candidateBuiltins.empty())
+            for (const auto& builtin : artic::BUILTIN_SCHEMES)
+                candidateBuiltins.emplace_back(builtin.name);
+        for (const auto& name : candidateBuiltins)
+        {
+            auto builtin = artic::FindBuiltinScheme(name);
+            if (!builtin)
+                throw std::runtime_error("builtin scheme not found - " + name);
+            schemes.emplace_back(*builtin);
+            names.emplace_back(name);
+        }
+        if (schemes.size() < 2)
+            throw std::runtime_error("at least two candidate schemes are needed to detect a scheme, add scheme files or more --builtin-schemes");
+        LOG_TRACE("collecting primer k-mers");
+        artic::RefStore reference(schemeArgs.refSeqFile);
+        artic::SchemeDetector detector(schemes, names, reference, detectorKmerSize, detectorWindow, minHits);
+        LOG_TRACE("\tcandidate schemes:\t{}", detector.GetNumSchemes());
+        LOG_TRACE("\ttotal primer k-mers:\t{}", detector.GetNumKmers());
+        LOG_TRACE("\tk-mer index size:\t{} bytes", detector.GetMemoryUsage());
+        LOG_TRACE("processing");
+        for (const auto& file : inputFiles)
+        {
+            if (maxReads != 0 && detector.GetNumReads() >= maxReads)
+                break;
+            LOG_TRACE("\treading file:\t{}", file);
+            detector.AddReads(file, maxReads);
+        }
+        auto scores = detector.GetScores();
+        std::cout << "#scheme\tkmers\tseen\tcontainment\tscore\n";
+        for (const auto& score : scores)
+            std::cout << detector.GetSchemeName(score.schemeID) << "\t" << score.numKmers << "\t" << score.numSeen << "\t" << score.containment << "\t" << score.score << "\n";
+        LOG_TRACE("finished processing reads");
+        LOG_TRACE("\ttotal reads sampled:\t{}", detector.GetNumReads());
+        LOG_TRACE("\tbest matching scheme:\t{}", detector.GetSchemeName(scores.front().schemeID));
+        auto confidence = detector.GetConfidence();
+        LOG_TRACE("\tconfidence:\t{}", confidence);
+        if (confidence < 0.9)
+            LOG_WARN("low confidence in the best matching scheme, check the scheme scores");
+    });
+
+    // add the screen callback
+    // 1. validate the primer scheme
+    // 2. encode the primer sites
+    // 3. run the screen
+    screenCmd->callback([&]() {
+        artic::Log::Init("screen_primers");
+        LOG_TRACE("starting primer screen");
+        auto ps = artic::ValidateScheme(schemeArgs);
+        artic::PrimerScreen screen(&ps, schemeArgs.refSeqFile, genomeFiles, numThreads);
+        screen.SetSearchWindow(searchWindow);
+        screen.SetThreePrimeWeighting(threePrimeBases, threePrimeWeight);
+        screen.SetRiskScore(riskScore);
+        screen.SetRiskProportion(riskProportion);
+        screen.Run();
+    });
+
     // add the vcfFilter callback
     // 1. run the vcf filterer
     vcfFilterCmd->callback([&]() {
@@ -0,0 +1,104 @@
+#include <unordered_map>
+
+#include "ampliconMinimizerIndex.hpp"
+
+// AMPLICON_MINIMIZER_BUCKET_SEED is mixed in to the minimizers before they are bucketed, as the minimizers all have low hashes.
+const artic::kmer_t AMPLICON_MINIMIZER_BUCKET_SEED = 0x9e3779b97f4a7c15ULL;
+
+// AmpliconMinimizerIndex constructor (builds the index from the amplicon inserts of a scheme).
+artic::AmpliconMinimizerIndex::AmpliconMinimizerIndex(const artic::PrimerScheme& primerScheme, const artic::RefStore& reference, uint32_t kSize, uint32_t wSize)
+    : _kSize(kSize), _wSize(wSize), _numShared(0), _numDropped(0)
+{
+    if (_kSize == 0 || _kSize > MAX_K_SIZE)
+        throw std::runtime_error("k-mer size must be > 0 and <= " + std::to_string(MAX_K_SIZE));
+    if (_wSize == 0)
+        throw std::runtime_error("minimizer window size must be > 0");
+    if (primerScheme.GetNumAmplicons() >= UINT16_MAX)
+        throw std::runtime_error("too many amplicons in scheme for the minimizer index: " + std::to_string(primerScheme.GetNumAmplicons()));
+
+    // collect the amplicons for each insert minimizer, only counting a minimizer once per amplicon
+    // (an ID of UINT16_MAX marks a repeated minimizer, seen on both strands, in more than two amplicons or in two that don't overlap)
+    std::unordered_map<kmer_t, AmpliconMinimizer> minimizerMap;
+    std::vector<std::pair<int64_t, int64_t>> inserts(primerScheme.GetNumAmplicons() + 1);
+    std::vector<artic::Kmer> minimizers;
+    std::string seq;
+    for (unsigned int id = 1; id <= primerScheme.GetNumAmplicons(); id++)
+    {
+        inserts[id] = primerScheme.GetAmplicon(id).GetMinSpan();
+        reference.GetSeq(primerScheme.GetReferenceName(), inserts[id].first, inserts[id].second, seq);
+        minimizers.clear();
+        artic::GetMinimizers(seq.c_str(), seq.size(), _kSize, _wSize, minimizers);
+        for (const auto& minimizer : minimizers)
+        {
+            auto it = minimizerMap.find(minimizer.kmer);
+            if (it == minimizerMap.end())
+            {
+                minimizerMap.emplace(minimizer.kmer, AmpliconMinimizer{minimizer.kmer, uint16_t(id), NO_AMPLICON, minimizer.forward});
+                continue;
+            }
+            auto& entry = it->second;
+            if (entry.ampliconID == UINT16_MAX)
+                continue;
+            if (entry.forward != minimizer.forward)
+            {
+                entry.ampliconID = entry.sharedID = UINT16_MAX;
+                continue;
+            }
+            if (entry.ampliconID == id || entry.sharedID == id)
+                continue;
+            const auto& first = inserts[entry.ampliconID];
+            if (entry.sharedID == NO_AMPLICON && first.second > inserts[id].first && inserts[id].second > first.first)
+                entry.sharedID = id;
+            else
+                entry.ampliconID = entry.sharedID = UINT16_MAX;
+        }
+    }
+
+    // keep the minimizers in one or two amplicons, counting them for each amplicon
+    _ampliconCounts.assign(primerScheme.GetNumAmplicons() + 1, 0);
+    std::vector<AmpliconMinimizer> entries;
+    entries.reserve(minimizerMap.size());
+    for (const auto& minimizer : minimizerMap)
+    {
+        const auto& entry = minimizer.second;
+        if (entry.ampliconID == UINT16_MAX)
+        {
+            _numDropped++;
+            continue;
+        }
+        _ampliconCounts[entry.ampliconID]++;
+        if (entry.sharedID != NO_AMPLICON)
+        {
+            _ampliconCounts[entry.sharedID]++;
+            _numShared++;
+        }
+        entries.emplace_back(entry);
+    }
+    _minimizers = artic::KmerTable<AmpliconMinimizer>(std::move(entries), _kSize, AMPLICON_MINIMIZER_BUCKET_SEED);
+}
+
+// GetKmerSize returns the minimizer k-mer size.
+uint32_t artic::AmpliconMinimizerIndex::GetKmerSize(void) const { return _kSize; }
+
+// GetWindowSize returns the number of k-mers in each minimizer window.
+uint32_t artic::AmpliconMinimizerIndex::GetWindowSize(void) const { return _wSize; }
+
+// GetNumMinimizers returns the number of minimizers in the index.
+std::size_t artic::AmpliconMinimizerIndex::GetNumMinimizers(void) const { return _minimizers.GetEntries().size(); }
+
+// GetNumMinimizers returns the number of indexed minimizers for an amplicon (including those shared with a neighbouring amplicon).
+uint32_t artic::AmpliconMinimizerIndex::GetNumMinimizers(unsigned int ampliconID) const
+{
+    if (ampliconID == NO_AMPLICON || ampliconID >= _ampliconCounts.size())
+        throw std::runtime_error("amplicon ID not found in minimizer index: " + std::to_string(ampliconID));
+    return _ampliconCounts[ampliconID];
+}
+
+// GetNumShared returns the number of minimizers shared by two amplicons.
+std::size_t artic::AmpliconMinimizerIndex::GetNumShared(void) const { return _numShared; }
+
+// GetNumDropped returns the number of minimizers that were dropped as repeats.
+std::size_t artic::AmpliconMinimizerIndex::GetNumDropped(void) const { return _numDropped; }
+
+// GetMemoryUsage returns the number of bytes used by the index.
+std::size_t artic::AmpliconMinimizerIndex::GetMemoryUsage(void) const { return _minimizers.GetMemoryUsage() + (_ampliconCounts.size() * sizeof(uint32_t)); }
@@ -0,0 +1,75 @@
+#ifndef AMPLICONMINIMIZERINDEX_H
+#define AMPLICONMINIMIZERINDEX_H
+
+#include <vector>
+
+#include "kmerTable.hpp"
+#include "kmers.hpp"
+#include "primerKmerIndex.hpp"
+#include "primerScheme.hpp"
+#include "refStore.hpp"
+
+namespace artic
+{
+    // AmpliconMinimizer is a minimizer from the amplicon inserts and the amplicon(s) it came from.
+    struct AmpliconMinimizer
+    {
+        kmer_t kmer;         // the canonical minimizer k-mer
+        uint16_t ampliconID; // the amplicon the minimizer came from
+        uint16_t sharedID;   // the other amplicon if the minimizer is in the overlap of two amplicons (NO_AMPLICON if unique)
+        bool forward;        // true if the canonical minimizer is on the reference strand
+    };
+
+    //******************************************************************************
+    // AmpliconMinimizerIndex is a static lookup of the (w,k)-minimizers along each amplicon insert, used to bin reads without intact primers.
+    //
+    // NOTES:
+    // * inserts are taken from the reference, between the primers of each amplicon (GetMinSpan)
+    // * neighbouring amplicons overlap, so a minimizer found in two overlapping amplicons is kept and records both of them,
+    //   minimizers found in amplicons that don't overlap, in more than two amplicons or on both strands are repeats and are dropped
+    // * each amplicon keeps a count of its indexed minimizers (unique and shared)
+    // * the minimizers are held in a KmerTable, so the index is read-only once built and can be shared between threads
+    // * the minimizers are chosen by their k-mer hash, so the KmerTable is seeded to bucket them by a different hash
+    //******************************************************************************
+    class AmpliconMinimizerIndex
+    {
+    public:
+        // AmpliconMinimizerIndex constructor (builds the index from the amplicon inserts of a scheme).
+        AmpliconMinimizerIndex(const PrimerScheme& primerScheme, const RefStore& reference, uint32_t kSize, uint32_t wSize);
+
+        // GetKmerSize returns the minimizer k-mer size.
+        uint32_t GetKmerSize(void) const;
+
+        // GetWindowSize returns the number of k-mers in each minimizer window.
+        uint32_t GetWindowSize(void) const;
+
+        // GetNumMinimizers returns the number of minimizers in the index.
+        std::size_t GetNumMinimizers(void) const;
+
+        // GetNumMinimizers returns the number of indexed minimizers for an amplicon (including those shared with a neighbouring amplicon).
+        uint32_t GetNumMinimizers(unsigned int ampliconID) const;
+
+        // GetNumShared returns the number of minimizers shared by two amplicons.
+        std::size_t GetNumShared(void) const;
+
+        // GetNumDropped returns the number of minimizers that were dropped as repeats.
+        std::size_t GetNumDropped(void) const;
+
+        // GetMemoryUsage returns the number of bytes used by the index.
+        std::size_t GetMemoryUsage(void) const;
+
+        // Find returns the index entry for a minimizer, or nullptr if the minimizer is not in the index.
+        inline const AmpliconMinimizer* Find(kmer_t kmer) const { return _minimizers.Find(kmer); }
+
+    private:
+        uint32_t _kSize;                          // the minimizer k-mer size
+        uint32_t _wSize;                          // the number of k-mers in each minimizer window
+        std::size_t _numShared;                   // the number of minimizers shared by two amplicons
+        std::size_t _numDropped;                  // the number of repeated minimizers that were dropped
+        KmerTable<AmpliconMinimizer> _minimizers; // the minimizers
+        std::vector<uint32_t> _ampliconCounts;    // the number of indexed minimizers for each amplicon (indexed by amplicon ID)
+    };
+
+} // namespace artic
+
+#endif
@@ -1,18 +1,39 @@
 #include <algorithm>
 #include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <kseq++/seqio.hpp>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
 #include <utility>
 
 #include "amplitig.hpp"
+#include "dirWatcher.hpp"
+#include "fastqReader.hpp"
 #include "kmers.hpp"
 #include "log.hpp"
 
 using namespace klibpp;
 
+// hashReadName returns a seeded hash of a read name, used to pick reads when reservoir sampling.
+static inline uint64_t hashReadName(const std::string& name, uint64_t seed)
+{
+    uint64_t hash = 14695981039346656037ULL ^ seed;
+    for (auto c : name)
+        hash = (hash ^ uint8_t(c)) * 1099511628211ULL;
+    return artic::HashKmer(hash, artic::MAX_K_SIZE);
+}
+
 // Amplitigger constructor.
-artic::Amplitigger::Amplitigger(artic::PrimerScheme* primerScheme, const std::string& refFile, const std::vector<std::string> inputFiles, unsigned int kmerSize, float kmerMatch)
-    : _primerScheme(primerScheme), _refFile(refFile), _inputFiles(inputFiles), _kmerSize(kmerSize), _minPrimerKmers(kmerMatch)
+artic::Amplitigger::Amplitigger(const artic::PrimerScheme* primerScheme, const std::string& refFile, const std::vector<std::string> inputFiles, unsigned int kmerSize, float kmerMatch, unsigned int numThreads, std::ostream& output)
+    : _primerScheme(primerScheme), _refFile(refFile), _inputFiles(inputFiles), _output(&output), _decompressionPool(nullptr), _kmerSize(kmerSize), _minPrimerKmers(kmerMatch), _numThreads(numThreads), _endWindow(0), _binOutput(BinOutput::none), _compressionThreads(1), _decompressionThreads(1), _trimPrimers(false), _maxDepth(0), _depthCapMode(DepthCapMode::firstN), _depthCapSeed(0), _graphKmerSize(0), _minKmerCount(0), _splitChimeras(false), _minMinimizers(0), _abundanceReport(false), _collectHits(false), _targetDepth(0), _idleTimeout(0), _snapshotInterval(0)
 {
 
     // check the params
@@ -20,205 +41,1287 @@ artic::Amplitigger::Amplitigger(artic::PrimerScheme* primerScheme, const std::st
         throw std::runtime_error("requested k-mer size greater than maximum allowed size (" + std::to_string(MAX_K_SIZE) + ")");
     if (_kmerSize > _primerScheme->GetMinPrimerLen())
         throw std::runtime_error("requested k-mer size greater than the smallest primer in scheme (" + std::to_string(_primerScheme->GetMinPrimerLen()) + ")");
-    if (_inputFiles.size() == 0)
-        throw std::runtime_error("no FASTQ files provided");
+    if (_numThreads == 0)
+        throw std::runtime_error("number of threads must be > 0");
 
-    // TODO: collect thresholds from user?
-    _minReadLength = 100;
-    _maxReadLength = _primerScheme->GetMaxAmpliconSpan() + (0.10 * _primerScheme->GetMaxAmpliconSpan());
+    // drop reads shorter than 100 bases or more than 10% longer than the longest amplicon, unless set otherwise
+    SetReadLengthLimits(100, 0);
 
     // get the holders ready
-    _readCounter = 0;
-    _droppedLong = 0;
-    _droppedShort = 0;
-    _droppedUnbinned = 0;
-    _multibinned = 0;
+    _ampliconCounts.reset(new std::atomic<uint64_t>[_primerScheme->GetNumAmplicons() + 1]);
+    _ampliconBases.reset(new std::atomic<uint64_t>[_primerScheme->GetNumAmplicons() + 1]);
+    _resetCounts();
+    _strandCounts.reset(new std::atomic<uint64_t>[(_primerScheme->GetNumAmplicons() + 1) * 2]);
+    _reservoirLocks.reset(new std::mutex[(_primerScheme->GetNumAmplicons() + 1) * 2]);
+    _graphLocks.reset(new std::mutex[_primerScheme->GetNumAmplicons() + 1]);
 
-    // load the primer k-mers
+    // load the primer k-mers, using contiguous k-mers until any spaced seeds are set
     LOG_TRACE("collecting primer k-mers");
     LOG_TRACE("\tk-mer size used:\t{}", _kmerSize);
     LOG_TRACE("\tk-mer matches required:\t{}%", _minPrimerKmers);
     LOG_TRACE("\treference fasta file:\t{}", _refFile);
-    _primerScheme->GetPrimerKmers(_refFile, _kmerSize, _primerKmerMap);
-    LOG_TRACE("\ttotal distinct k-mers:\t{}", _primerKmerMap.size());
+    _loadPrimerKmers({std::string(_kmerSize, '1')});
+}
 
-    // TODO: filter k-mers and retain only mutually exclusive k-mers
-    size_t meCount = 0;
-    for (auto i : _primerKmerMap)
-    {
-        if (i.second.size() > 1)
+// SetSpacedSeeds will use spaced seed k-mers for binning instead of contiguous k-mers (a read k-mer hit from any seed counts towards its amplicon).
+void artic::Amplitigger::SetSpacedSeeds(const std::vector<std::string>& patterns)
+{
+    if (patterns.empty())
+        throw std::runtime_error("no spaced seed patterns provided");
+    LOG_TRACE("collecting spaced seed primer k-mers");
+    _loadPrimerKmers(patterns);
+}
+
+// SetReadLengthLimits will drop reads shorter than minReadLength or longer than maxReadLength (0 for 10% longer than the longest amplicon in the scheme).
+void artic::Amplitigger::SetReadLengthLimits(unsigned int minReadLength, unsigned int maxReadLength)
+{
+    if (maxReadLength == 0)
+        maxReadLength = _primerScheme->GetMaxAmpliconSpan() + (0.10 * _primerScheme->GetMaxAmpliconSpan());
+    if (maxReadLength < minReadLength)
+        throw std::runtime_error("maximum read length must be >= the minimum read length");
+    _minReadLength = minReadLength;
+    _maxReadLength = maxReadLength;
+}
+
+// SetFastqOutput will write binned reads to compressed FASTQ files (<prefix>.<bin name>.fastq.gz) during the next Run.
+void artic::Amplitigger::SetFastqOutput(const std::string& prefix, BinOutput binOutput, unsigned int compressionThreads)
+{
+    if (binOutput != BinOutput::none && prefix.empty())
+        throw std::runtime_error("no prefix provided for FASTQ output");
+    if (compressionThreads == 0)
+        throw std::runtime_error("number of compression threads must be > 0");
+    _fastqPrefix = prefix;
+    _binOutput = binOutput;
+    _compressionThreads = compressionThreads;
+}
+
+// SetPrimerTrimming will trim the primers (and anything beyond them, such as adapters) from the reads written to FASTQ.
+void artic::Amplitigger::SetPrimerTrimming(bool trimPrimers) { _trimPrimers = trimPrimers; }
+
+// SetChimeraSplitting will split reads holding more than one amplicon (such as ligation concatemers) into a sub-read per amplicon, instead of multibinning or dropping them.
+void artic::Amplitigger::SetChimeraSplitting(bool splitChimeras) { _splitChimeras = splitChimeras; }
+
+// SetDepthCap will only write up to this many reads to FASTQ for each amplicon strand (0 for no cap), using the seed if reservoir sampling.
+void artic::Amplitigger::SetDepthCap(unsigned int maxDepth, DepthCapMode mode, uint64_t seed)
+{
+    _maxDepth = maxDepth;
+    _depthCapMode = mode;
+    _depthCapSeed = seed;
+}
+
+// SetConsensusOutput will build an amplitig for each amplicon during the next Run, writing them and the stitched draft genome to FASTA (<prefix>.amplitigs.fasta and <prefix>.draft.fasta).
+void artic::Amplitigger::SetConsensusOutput(const std::string& prefix, unsigned int graphKmerSize, unsigned int minKmerCount)
+{
+    if (prefix.empty())
+        throw std::runtime_error("no prefix provided for amplitig output");
+
+    // the anchor k-mers are taken from the primers, so they need to fit within the smallest primer
+    if (graphKmerSize == 0 || graphKmerSize > _primerScheme->GetMinPrimerLen())
+        throw std::runtime_error("graph k-mer size must be > 0 and <= the smallest primer in scheme (" + std::to_string(_primerScheme->GetMinPrimerLen()) + ")");
+    if (minKmerCount == 0)
+        throw std::runtime_error("minimum graph k-mer count must be > 0");
+    _consensusPrefix = prefix;
+    _graphKmerSize = graphKmerSize;
+    _minKmerCount = minKmerCount;
+}
+
+// SetEndWindow will only look for primers within this many bases at each end of a read, unless that fails to find an amplicon (0 scans the whole read).
+void artic::Amplitigger::SetEndWindow(unsigned int windowSize)
+{
+    if (windowSize != 0 && windowSize < _primerScheme->GetMinPrimerLen())
+        throw std::runtime_error("end window must be at least the length of the smallest primer in scheme (" + std::to_string(_primerScheme->GetMinPrimerLen()) + ")");
+    _endWindow = windowSize;
+}
+
+// SetMinimizerFallback will bin reads that fail the primer k-mer test by the (w,k)-minimizers of the amplicon inserts, needing the given proportion of the read minimizers to hit an amplicon.
+void artic::Amplitigger::SetMinimizerFallback(unsigned int kSize, unsigned int wSize, float minMatch)
+{
+    if (minMatch <= 0 || minMatch > 1)
+        throw std::runtime_error("minimizer match proportion must be > 0 and <= 1");
+    LOG_TRACE("collecting amplicon insert minimizers");
+    artic::RefStore reference(_refFile);
+    _minimizerIndex.reset(new artic::AmpliconMinimizerIndex(*_primerScheme, reference, kSize, wSize));
+    _minMinimizers = minMatch;
+    LOG_TRACE("\tminimizer k-mer size and window:\t{}, {}", kSize, wSize);
+    LOG_TRACE("\ttotal minimizers:\t{}", _minimizerIndex->GetNumMinimizers());
+    LOG_TRACE("\t- shared by overlapping amplicons:\t{}", _minimizerIndex->GetNumShared());
+    LOG_TRACE("\ttotal repeated minimizers (dropped):\t{}", _minimizerIndex->GetNumDropped());
+    LOG_TRACE("\tminimizer index size:\t{} bytes", _minimizerIndex->GetMemoryUsage());
+}
+
+// SetAbundanceReport will write a report of the reads per amplicon and per pool at the end of the next Run, instead of the read assignments.
+void artic::Amplitigger::SetAbundanceReport(bool abundanceReport) { _abundanceReport = abundanceReport; }
+
+// SetDecompressionThreads sets the number of threads used to decompress BGZF input files (other files are inflated on a single background thread).
+void artic::Amplitigger::SetDecompressionThreads(unsigned int numThreads)
+{
+    if (numThreads == 0)
+        throw std::runtime_error("number of decompression threads must be > 0");
+    _decompressionThreads = numThreads;
+}
+
+// GetFastqFiles returns the FASTQ files written by the last Run.
+const std::vector<std::string>& artic::Amplitigger::GetFastqFiles(void) const { return _fastqFiles; }
+
+// Run will perform the amplicon read binning on the FASTQ files.
+void artic::Amplitigger::Run()
+{
+    // check the input files before starting any threads
+    if (_inputFiles.empty())
+        throw std::runtime_error("no FASTQ files provided");
+    for (const auto& file : _inputFiles)
+        if (!boost::filesystem::exists(file))
+            throw std::runtime_error("supplied file does not exist:\t" + file);
+    _run(false);
+}
+
+// Watch will bin the reads from FASTQ files as they are written to a directory, rewriting a JSON snapshot of the amplicon counts, until every amplicon reaches the target depth or no new files arrive within the idle timeout (in seconds).
+void artic::Amplitigger::Watch(const std::string& watchDir, const std::string& snapshotFile, unsigned int targetDepth, unsigned int idleTimeout, unsigned int snapshotInterval)
+{
+    if (!boost::filesystem::is_directory(watchDir))
+        throw std::runtime_error("watch directory does not exist:\t" + watchDir);
+    if (snapshotFile.empty())
+        throw std::runtime_error("no snapshot file provided");
+    if (targetDepth == 0 && idleTimeout == 0)
+        throw std::runtime_error("a target depth or an idle timeout is needed to stop watching");
+    if (snapshotInterval == 0)
+        throw std::runtime_error("snapshot interval must be > 0");
+    _watchDir = watchDir;
+    _snapshotFile = snapshotFile;
+    _targetDepth = targetDepth;
+    _idleTimeout = idleTimeout;
+    _snapshotInterval = snapshotInterval;
+    _run(true);
+}
+
+// _run bins the reads from the input files, or from the watch directory, on the worker threads.
+void artic::Amplitigger::_run(bool watch)
+{
+    _resetCounts();
+    _fastqFiles.clear();
+    _openFastqOutput();
+
+    // get an empty graph ready for each amplicon if building amplitigs
+    _amplitigs.clear();
+    _draftGenome.clear();
+    _graphs.clear();
+    if (!_consensusPrefix.empty())
+        for (unsigned int id = 0; id <= _primerScheme->GetNumAmplicons(); id++)
+            _graphs.emplace_back(new artic::AmplitigGraph(_graphKmerSize));
+    _collectHits = (_fastqOutput && (_trimPrimers || _maxDepth != 0)) || !_graphs.empty() || _splitChimeras;
+
+    // set up the queues, allowing a couple of batches per worker to be in flight
+    // (the parser only makes a new batch when none are free, so no more than 3 per worker + 1 can exist and returning one will never block)
+    artic::BoundedQueue<readBatch> batches(_numThreads * 2);
+    artic::BoundedQueue<readBatch> emptyBatches(_numThreads * 3 + 1);
+
+    // start the workers and then the parser, catching the first error from any thread
+    LOG_TRACE("processing");
+    LOG_TRACE("\tbinning threads:\t{}", _numThreads);
+    LOG_TRACE("\tBGZF decompression threads:\t{}", _decompressionThreads);
+    if (_endWindow != 0)
+        LOG_TRACE("\tprimer search window:\t{} bases at each read end", _endWindow);
+    if (_fastqOutput && _trimPrimers)
+        LOG_TRACE("\ttrimming primers from FASTQ reads");
+    if (_splitChimeras)
+        LOG_TRACE("\tsplitting reads with more than one amplicon");
+    if (_minimizerIndex)
+        LOG_TRACE("\tminimizer fallback:\t{} of read minimizers required", _minMinimizers);
+    if (_abundanceReport)
+        LOG_TRACE("\twriting abundance report instead of read assignments");
+    if (!_graphs.empty())
+        LOG_TRACE("\tbuilding amplitigs:\t{} reads per amplicon, k-mer size {}, min. k-mer count {}", AMPLITIG_GRAPH_READS, _graphKmerSize, _minKmerCount);
+    if (_fastqOutput && _maxDepth != 0)
+        LOG_TRACE("\tFASTQ depth cap:\t{} reads per amplicon strand ({})", _maxDepth, (_depthCapMode == DepthCapMode::reservoir) ? "reservoir sampled" : "first reads");
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto guard = [&](auto&& task) {
+        try
         {
-            _primerKmerMap.erase(i.first);
+            task();
         }
-        else
+        catch (...)
         {
-            meCount++;
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error)
+                error = std::current_exception();
+            batches.Close();
+            emptyBatches.Close();
         }
+    };
+
+    // the decompression pool is shared by the input files, and has to outlive the parser
+    std::unique_ptr<hts_tpool, decltype(&hts_tpool_destroy)> decompressionPool(hts_tpool_init(_decompressionThreads), hts_tpool_destroy);
+    if (!decompressionPool)
+        throw std::runtime_error("could not start decompression thread pool");
+    _decompressionPool = decompressionPool.get();
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < _numThreads; i++)
+        workers.emplace_back([&] { guard([&] { _binReads(batches, emptyBatches); }); });
+    std::thread parser([&] { guard([&] {
+        if (watch)
+            _watchReads(batches, emptyBatches);
+        else
+            _parseReads(batches, emptyBatches);
+    }); });
+    parser.join();
+    for (auto& worker : workers)
+        worker.join();
+    _decompressionPool = nullptr;
+    decompressionPool.reset();
+    if (error)
+    {
+        _fastqOutput.reset();
+        _graphs.clear();
+        std::rethrow_exception(error);
+    }
+    if (_abundanceReport)
+        _writeAbundance();
+    _output->flush();
+    if (_fastqOutput)
+    {
+        _writeReservoirs();
+        _fastqOutput->Close();
+        for (std::size_t i = 0; i < _fastqOutput->GetNumBins(); i++)
+            _fastqFiles.emplace_back(_fastqOutput->GetFileName(i));
+        _fastqOutput.reset();
+        LOG_TRACE("\tFASTQ files written:\t{}", _fastqFiles.size());
+        if (_trimPrimers)
+            LOG_TRACE("\tbases trimmed from FASTQ reads:\t{}", _trimmedBases);
+        if (_maxDepth != 0)
+            LOG_TRACE("\treads over the depth cap (not written):\t{}", _capped);
     }
-    LOG_TRACE("\ttotal mutually exclusive k-mers:\t{}", meCount);
-    if (meCount != _primerKmerMap.size())
-        throw std::runtime_error("did not remove k-mers...");
+    if (!_graphs.empty())
+    {
+        _buildAmplitigs();
+        _stitchAmplitigs();
+        _writeConsensus();
+        _graphs.clear();
+    }
+    if (watch)
+    {
+        _writeSnapshot(true);
+        LOG_TRACE("\tsnapshot written to:\t{}", _snapshotFile);
+    }
+
+    // print some stats
+    LOG_TRACE("finished processing reads")
+    LOG_TRACE("\ttotal input files:\t{}", _numFiles);
+    LOG_TRACE("\ttotal input reads:\t{}", _readCounter);
+    LOG_TRACE("\ttotal dropped reads:\t{}", (_droppedLong + _droppedShort + _droppedUnbinned));
+    LOG_TRACE("\t- short reads (<{}):\t{}", _minReadLength, _droppedShort);
+    LOG_TRACE("\t- long reads (>{}):\t{}", _maxReadLength, _droppedLong);
+    LOG_TRACE("\t- unbinned reads:\t{}", _droppedUnbinned);
+    LOG_TRACE("\ttotal binned reads:\t{}", (_readCounter - (_droppedLong + _droppedShort + _droppedUnbinned)));
+    LOG_TRACE("\t- multibinned reads:\t{}", _multibinned);
+    if (_minimizerIndex)
+        LOG_TRACE("\t- binned by minimizer fallback:\t{}", _rescued);
+    if (_splitChimeras)
+        LOG_TRACE("\t- split reads:\t{} (into {} sub-reads)", _split, _subReads);
+    if (_endWindow != 0)
+        LOG_TRACE("\treads needing a full scan:\t{}", _fullScans);
 }
 
-// Run will perform the amplicon read binning on the open FASTQ file.
-void artic::Amplitigger::Run()
+// GetNumReads returns the number of reads processed.
+uint64_t artic::Amplitigger::GetNumReads(void) const { return _readCounter; }
+
+// GetNumDroppedShort returns the number of reads dropped for being too short.
+uint64_t artic::Amplitigger::GetNumDroppedShort(void) const { return _droppedShort; }
+
+// GetNumDroppedLong returns the number of reads dropped for being too long.
+uint64_t artic::Amplitigger::GetNumDroppedLong(void) const { return _droppedLong; }
+
+// GetNumUnbinned returns the number of reads that were not binned to an amplicon.
+uint64_t artic::Amplitigger::GetNumUnbinned(void) const { return _droppedUnbinned; }
+
+// GetNumMultibinned returns the number of reads that were binned to more than one amplicon.
+uint64_t artic::Amplitigger::GetNumMultibinned(void) const { return _multibinned; }
+
+// GetNumFullScans returns the number of reads that needed a full scan as the end windows didn't find an amplicon.
+uint64_t artic::Amplitigger::GetNumFullScans(void) const { return _fullScans; }
+
+// GetNumTrimmedBases returns the number of bases trimmed from the reads written to FASTQ.
+uint64_t artic::Amplitigger::GetNumTrimmedBases(void) const { return _trimmedBases; }
+
+// GetNumSplit returns the number of reads that were split into sub-reads.
+uint64_t artic::Amplitigger::GetNumSplit(void) const { return _split; }
+
+// GetNumSubReads returns the number of sub-reads that split reads were cut into.
+uint64_t artic::Amplitigger::GetNumSubReads(void) const { return _subReads; }
+
+// GetNumRescued returns the number of reads that failed the primer k-mer test but were binned by the minimizer fallback.
+uint64_t artic::Amplitigger::GetNumRescued(void) const { return _rescued; }
+
+// GetNumCapped returns the number of binned reads that were not written to FASTQ as their amplicon strand was over the depth cap.
+uint64_t artic::Amplitigger::GetNumCapped(void) const { return _capped; }
+
+// GetAmpliconCount returns the number of reads binned to an amplicon.
+uint64_t artic::Amplitigger::GetAmpliconCount(unsigned int ampliconID) const
 {
-    // get some holders ready
-    artic::kmerset_t kmers;
-    std::vector<unsigned int> ampliconIDs;
-    KSeq record;
-    int seqLen;
+    if (ampliconID == 0 || ampliconID > _primerScheme->GetNumAmplicons())
+        throw std::runtime_error("amplicon ID not found in scheme: " + std::to_string(ampliconID));
+    return _ampliconCounts[ampliconID];
+}
 
-    LOG_TRACE("processing");
-    for (auto file : _inputFiles)
+// GetPoolCount returns the number of reads binned to the amplicons of a primer pool (reads binned to more than one amplicon count towards each).
+uint64_t artic::Amplitigger::GetPoolCount(unsigned int poolID) const
+{
+    if (poolID == 0 || poolID > _primerScheme->GetPrimerPools().size())
+        throw std::runtime_error("pool ID not found in scheme: " + std::to_string(poolID));
+    uint64_t count = 0;
+    for (unsigned int id = 1; id <= _primerScheme->GetNumAmplicons(); id++)
+        if (_primerScheme->GetAmplicon(id).GetPrimerPoolID() == poolID)
+            count += _ampliconCounts[id];
+    return count;
+}
+
+// GetAmpliconDepth returns an estimate of the mean depth of an amplicon (the bases binned to it over the amplicon span).
+double artic::Amplitigger::GetAmpliconDepth(unsigned int ampliconID) const
+{
+    if (ampliconID == 0 || ampliconID > _primerScheme->GetNumAmplicons())
+        throw std::runtime_error("amplicon ID not found in scheme: " + std::to_string(ampliconID));
+    const auto& amplicon = _primerScheme->GetAmplicon(ampliconID);
+    return double(_ampliconBases[ampliconID]) / double(amplicon.GetReversePrimer()->GetEnd() - amplicon.GetForwardPrimer()->GetStart());
+}
+
+// GetNumFiles returns the number of FASTQ files read.
+uint64_t artic::Amplitigger::GetNumFiles(void) const { return _numFiles; }
+
+// GetAmplitig returns the amplitig built for an amplicon by the last Run (empty if one couldn't be built).
+const std::string& artic::Amplitigger::GetAmplitig(unsigned int ampliconID) const
+{
+    if (ampliconID == 0 || ampliconID > _primerScheme->GetNumAmplicons())
+        throw std::runtime_error("amplicon ID not found in scheme: " + std::to_string(ampliconID));
+    if (_amplitigs.empty())
+        throw std::runtime_error("no amplitigs have been built");
+    return _amplitigs[ampliconID];
+}
+
+// GetDraftGenome returns the draft genome stitched from the amplitigs by the last Run.
+const std::string& artic::Amplitigger::GetDraftGenome(void) const { return _draftGenome; }
+
+// _parseReads reads the FASTQ files and queues batches of reads.
+void artic::Amplitigger::_parseReads(artic::BoundedQueue<readBatch>& batches, artic::BoundedQueue<readBatch>& emptyBatches)
+{
+    readBatch batch;
+    for (const auto& file : _inputFiles)
+        if (!_parseFile(file, batch, batches, emptyBatches))
+            return;
+
+    // queue the last batch and let the workers know there are no more
+    if (batch.size != 0)
+        batches.Push(std::move(batch));
+    batches.Close();
+}
+
+// _watchReads queues batches of reads from the FASTQ files written to the watch directory, writing snapshots as it goes, until the target depth or the idle timeout is reached.
+void artic::Amplitigger::_watchReads(artic::BoundedQueue<readBatch>& batches, artic::BoundedQueue<readBatch>& emptyBatches)
+{
+    artic::DirWatcher watcher(_watchDir);
+    LOG_TRACE("\twatching directory:\t{} ({})", _watchDir, watcher.UsingInotify() ? "inotify" : "polling");
+    if (_targetDepth != 0)
+        LOG_TRACE("\ttarget depth:\t{} reads per amplicon", _targetDepth);
+    if (_idleTimeout != 0)
+        LOG_TRACE("\tidle timeout:\t{} seconds", _idleTimeout);
+    readBatch batch;
+    std::vector<std::string> files;
+    auto lastFile = std::chrono::steady_clock::now();
+    auto lastSnapshot = lastFile;
+    while (true)
     {
-        if (!boost::filesystem::exists(file))
-            throw std::runtime_error("supplied file does not exist:\t" + file);
-        LOG_TRACE("\treading file:\t{}", file);
+        watcher.GetNewFiles(AMPLITIG_WATCH_WAIT, files);
+        for (const auto& file : files)
+            if (!_parseFile(file, batch, batches, emptyBatches))
+                return;
 
-        SeqStreamIn iss(file.c_str());
-        while (iss >> record)
+        // queue any partial batch so that the reads are counted while waiting for the next file
+        if (batch.size != 0)
         {
-            _readCounter++;
+            if (!batches.Push(std::move(batch)))
+                return;
+            batch = readBatch();
+        }
 
-            // check read length
-            seqLen = record.seq.size();
-            if (seqLen < _minReadLength)
-            {
-                _droppedShort++;
-                continue;
-            }
-            if (seqLen > _maxReadLength)
-            {
-                _droppedLong++;
+        // snapshot the counts every interval, and stop once every amplicon is at the target depth or there have been no new files for a while
+        // (counts for the last batches may still be with the workers, but these are in the final snapshot)
+        auto now = std::chrono::steady_clock::now();
+        if (!files.empty())
+            lastFile = now;
+        if (now - lastSnapshot >= std::chrono::seconds(_snapshotInterval))
+        {
+            _writeSnapshot(false);
+            lastSnapshot = now;
+        }
+        if (_targetDepth != 0 && _getNumAtTarget() == _primerScheme->GetNumAmplicons())
+        {
+            LOG_TRACE("\tall amplicons have reached the target depth");
+            break;
+        }
+        if (_idleTimeout != 0 && now - lastFile >= std::chrono::seconds(_idleTimeout))
+        {
+            LOG_TRACE("\tno new files for {} seconds", _idleTimeout);
+            break;
+        }
+    }
+    batches.Close();
+}
+
+// _parseFile reads a FASTQ file into batches of reads, queueing each batch once full (returns false if the queue has been closed).
+bool artic::Amplitigger::_parseFile(const std::string& file, readBatch& batch, artic::BoundedQueue<readBatch>& batches, artic::BoundedQueue<readBatch>& emptyBatches)
+{
+    artic::FastqReader reader(file, _decompressionPool);
+    LOG_TRACE("\treading file:\t{}{}", file, reader.IsBGZF() ? " (BGZF)" : "");
+    while (true)
+    {
+        // grab a recycled batch if there is one
+        if (batch.size == 0 && batch.reads.empty())
+            emptyBatches.TryPop(batch);
+
+        // read the next record into the batch
+        if (batch.size == batch.reads.size())
+            batch.reads.emplace_back();
+        if (!reader.Read(batch.reads[batch.size]))
+            break;
+
+        // queue the batch once full
+        if (++batch.size == AMPLITIG_BATCH_SIZE)
+        {
+            if (!batches.Push(std::move(batch)))
+                return false;
+            batch = readBatch();
+        }
+    }
+    _numFiles++;
+    return true;
+}
+
+// _getNumAtTarget returns the number of amplicons that have reached the target depth.
+unsigned int artic::Amplitigger::_getNumAtTarget(void) const
+{
+    unsigned int numAtTarget = 0;
+    for (unsigned int id = 1; id <= _primerScheme->GetNumAmplicons(); id++)
+        if (_ampliconCounts[id] >= _targetDepth)
+            numAtTarget++;
+    return numAtTarget;
+}
+
+// _writeSnapshot rewrites the JSON snapshot of the read and amplicon counts, replacing the old one in a single rename so that readers never see a partial file.
+void artic::Amplitigger::_writeSnapshot(bool finished)
+{
+    auto tmpFile = _snapshotFile + ".tmp";
+    char updated[32];
+    auto now = std::time(nullptr);
+    std::strftime(updated, sizeof(updated), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    uint64_t reads = _readCounter;
+    uint64_t unbinned = _droppedUnbinned;
+    uint64_t droppedShort = _droppedShort;
+    uint64_t droppedLong = _droppedLong;
+    auto numAtTarget = _getNumAtTarget();
+    boost::property_tree::ptree snapshot;
+    snapshot.put("scheme", _primerScheme->GetFileName());
+    snapshot.put("updated", updated);
+    snapshot.put("finished", finished);
+    snapshot.put("files", _numFiles);
+    snapshot.put("reads.total", reads);
+    snapshot.put("reads.binned", reads - unbinned - droppedShort - droppedLong);
+    snapshot.put("reads.unbinned", unbinned);
+    snapshot.put("reads.short", droppedShort);
+    snapshot.put("reads.long", droppedLong);
+    snapshot.put("reads.multibinned", uint64_t(_multibinned));
+    snapshot.put("targetDepth", _targetDepth);
+    snapshot.put("ampliconsAtTarget", (_targetDepth != 0) ? numAtTarget : 0);
+    snapshot.put("allAtTarget", _targetDepth != 0 && numAtTarget == _primerScheme->GetNumAmplicons());
+    boost::property_tree::ptree amplicons;
+    for (unsigned int id = 1; id <= _primerScheme->GetNumAmplicons(); id++)
+    {
+        const auto& amplicon = _primerScheme->GetAmplicon(id);
+        uint64_t count = _ampliconCounts[id];
+        std::ostringstream depth;
+        depth << std::fixed << std::setprecision(1) << GetAmpliconDepth(id);
+        boost::property_tree::ptree entry;
+        entry.put("name", _primerScheme->GetAmpliconName(id));
+        entry.put("pool", _primerScheme->GetPrimerPool(amplicon.GetPrimerPoolID()));
+        entry.put("reads", count);
+        entry.put("depth", depth.str());
+        entry.put("atTarget", _targetDepth != 0 && count >= _targetDepth);
+        amplicons.push_back(std::make_pair("", entry));
+    }
+    snapshot.add_child("amplicons", amplicons);
+    try
+    {
+        boost::property_tree::write_json(tmpFile, snapshot);
+    }
+    catch (const boost::property_tree::json_parser_error&)
+    {
+        throw std::runtime_error("could not write snapshot file: " + tmpFile);
+    }
+    boost::system::error_code error;
+    boost::filesystem::rename(tmpFile, _snapshotFile, error);
+    if (error)
+        throw std::runtime_error("could not replace snapshot file: " + _snapshotFile);
+    if (!finished)
+        LOG_TRACE("\tsnapshot:\t{} reads, {} of {} amplicons at target depth", reads, numAtTarget, _primerScheme->GetNumAmplicons());
+}
+
+// _binReads bins batches of reads until the queue is closed.
+void artic::Amplitigger::_binReads(artic::BoundedQueue<readBatch>& batches, artic::BoundedQueue<readBatch>& emptyBatches)
+{
+    // get the worker holders ready, these are reused for every read
+    binHolders holders;
+    holders.votes.assign(_primerScheme->GetNumAmplicons() + 1, 0);
+    holders.uniqueVotes.assign(_primerScheme->GetNumAmplicons() + 1, 0);
+    std::string output;
+    std::vector<std::string> binBuffers(_fastqOutput ? _fastqOutput->GetNumBins() : 0);
+    binCounts counts;
+    counts.ampliconCounts.assign(_primerScheme->GetNumAmplicons() + 1, 0);
+    counts.ampliconBases.assign(_primerScheme->GetNumAmplicons() + 1, 0);
+    readBatch batch;
+    while (batches.Pop(batch))
+    {
+        output.clear();
+        for (std::size_t i = 0; i < batch.size; i++)
+            _binRead(batch.reads[i], holders, counts, output, binBuffers);
+
+        // write the batch output in one go and update the counters
+        {
+            std::lock_guard<std::mutex> lock(_outputMutex);
+            _output->write(output.data(), output.size());
+        }
+        _addCounts(counts);
+        for (std::size_t bin = 0; bin < binBuffers.size(); bin++)
+        {
+            if (binBuffers[bin].size() < AMPLITIG_WRITE_BUFFER)
                 continue;
-            }
+            _fastqOutput->Write(bin, binBuffers[bin]);
+            binBuffers[bin].clear();
+        }
 
-            // clear sets
-            kmers.clear();
-            ampliconIDs.clear();
+        // send the batch back to the parser for reuse
+        batch.size = 0;
+        emptyBatches.Push(std::move(batch));
+        batch = readBatch();
+    }
 
-            // get the read k-mers
-            artic::GetEncodedKmers(record.seq.c_str(), seqLen, _kmerSize, kmers);
+    // write whatever is left in the FASTQ buffers
+    for (std::size_t bin = 0; bin < binBuffers.size(); bin++)
+        if (!binBuffers[bin].empty())
+            _fastqOutput->Write(bin, binBuffers[bin]);
+}
 
-            // check read k-mers against primer scheme k-mers, keep amplicon IDs for all matches
-            for (auto kmer : kmers)
-            {
+// _binRead bins a single read.
+void artic::Amplitigger::_binRead(const klibpp::KSeq& read, binHolders& holders, binCounts& counts, std::string& output, std::vector<std::string>& binBuffers)
+{
+    counts.reads++;
 
-                // check if read k-mer is matched to a primer k-mer
-                auto it = _primerKmerMap.find(kmer);
-                if (it != _primerKmerMap.end())
-                {
-                    ampliconIDs.reserve(ampliconIDs.size() + it->second.size());
-                    ampliconIDs.insert(ampliconIDs.end(), it->second.begin(), it->second.end());
-                }
-            }
+    // check read length, long reads are kept if they might be split
+    int seqLen = read.seq.size();
+    if (seqLen < _minReadLength)
+    {
+        counts.droppedShort++;
+        return;
+    }
+    bool tooLong = seqLen > _maxReadLength;
+    if (tooLong && !_splitChimeras)
+    {
+        counts.droppedLong++;
+        return;
+    }
 
-            // sort the matching IDs and then find the best candidate amplicon ID for this read
-            std::sort(ampliconIDs.begin(), ampliconIDs.end());
-            std::vector<std::pair<unsigned int, int>> ampliconCandidates;
-            int chain = 0;
-            for (size_t i = 1; i < ampliconIDs.size(); i++)
-            {
-                // if successive match, continue to the next ID and keep building the chain
-                if (ampliconIDs.at(i - 1) == ampliconIDs.at(i))
-                {
-                    chain++;
-                    continue;
-                }
+    holders.hits.clear();
+    holders.record.clear();
+    holders.minimizerForward = true;
 
-                // ignore empty chains
-                if (chain == 0)
-                    continue;
+    // look for primers at the read ends first, falling back to the whole read if that doesn't find an amplicon
+    // (the tail window is scanned towards the read end, so it only stops early if the primer is followed by a long adapter)
+    bool found = false;
+    if (_endWindow != 0 && !tooLong && seqLen > int(_endWindow * 2))
+    {
+        _scanKmers(read.seq, 0, _endWindow, true, holders);
+        _scanKmers(read.seq, seqLen - _endWindow, _endWindow, true, holders);
+        _selectAmplicons(holders);
+        found = !holders.amplicons.empty();
+        if (!found)
+            counts.fullScans++;
+    }
+    if (!found)
+    {
+        // the full scan finds the window hits again, so drop them to stop them counting twice towards the strand, insert and split sites
+        holders.hits.clear();
+        _scanKmers(read.seq, 0, seqLen, false, holders);
+        _selectAmplicons(holders);
+    }
 
-                // if first chain, add it to candidates and continue
-                if (ampliconCandidates.empty())
-                {
-                    ampliconCandidates.emplace_back(std::make_pair(ampliconIDs.at(i - 1), chain));
-                    chain = 0;
-                    continue;
-                }
+    // reads that may contain more than one amplicon are split if they have the primer pairs for each
+    if (_splitChimeras && (tooLong || holders.amplicons.size() > 1))
+    {
+        if (_splitRead(read, found, holders, counts, output, binBuffers))
+            return;
+        if (tooLong)
+        {
+            counts.droppedLong++;
+            return;
+        }
+    }
 
-                // if new chain is < than existing max, continue
-                if (chain < ampliconCandidates.back().second)
+    // reads without enough primer k-mer hits (e.g. with degraded ends) fall back to the amplicon insert minimizers
+    if (holders.amplicons.empty() && _minimizerIndex && _rescueRead(read.seq, holders))
+        counts.rescued++;
+    _assignRead(read, holders, counts, output, binBuffers);
+}
+
+// _assignRead writes a read to its selected amplicons.
+void artic::Amplitigger::_assignRead(const klibpp::KSeq& read, binHolders& holders, binCounts& counts, std::string& output, std::vector<std::string>& binBuffers)
+{
+    // process the likely amplicons, trimming FASTQ reads to their insert if requested
+    uint32_t seqLen = read.seq.size();
+    int binned = 0;
+    holders.readBins.clear();
+    uint32_t start = 0;
+    uint32_t end = seqLen;
+    if (_trimPrimers && !binBuffers.empty())
+        _findInsert(seqLen, holders, start, end);
+    for (auto candidate : holders.amplicons)
+    {
+        if (!_abundanceReport)
+            output.append(read.name).append("\t").append(_primerScheme->GetAmplicon(candidate.first).GetName()).append("\t").append(std::to_string(candidate.second)).append("\n");
+        counts.ampliconCounts[candidate.first]++;
+        counts.ampliconBases[candidate.first] += seqLen;
+        binned++;
+
+        // add the read to its FASTQ bin, only once if multibinned amplicons share a bin
+        if (!binBuffers.empty())
+        {
+            // reads over the depth cap for their amplicon strand are dropped, reservoir sampled reads are written at the end of the run
+            if (_maxDepth != 0)
+            {
+                auto slot = candidate.first * 2 + (_isForward(candidate.first, holders) ? 0 : 1);
+                if (_depthCapMode == DepthCapMode::reservoir)
                 {
-                    chain = 0;
+                    if (holders.record.empty())
+                        artic::AppendFastqRecord(read, start, end, holders.record);
+                    _addToReservoir(slot, {hashReadName(read.name, _depthCapSeed), seqLen - (end - start), holders.record});
                     continue;
                 }
-
-                // if new chain > existing max, replace and continue
-                if (chain > ampliconCandidates.back().second)
+                if (_strandCounts[slot].fetch_add(1, std::memory_order_relaxed) >= _maxDepth)
                 {
-                    ampliconCandidates.pop_back();
-                    ampliconCandidates.emplace_back(std::make_pair(ampliconIDs.at(i - 1), chain));
-                    chain = 0;
+                    counts.capped++;
                     continue;
                 }
+            }
+            auto bin = _ampliconBins[candidate.first];
+            if (std::find(holders.readBins.begin(), holders.readBins.end(), bin) == holders.readBins.end())
+            {
+                artic::AppendFastqRecord(read, start, end, binBuffers[bin]);
+                holders.readBins.emplace_back(bin);
+                counts.trimmedBases += seqLen - (end - start);
+            }
+        }
+    }
+
+    // only reads binned to a single amplicon are used to build amplitigs
+    if (!_graphs.empty() && binned == 1)
+        _addToGraph(holders.amplicons.front().first, read, holders);
+
+    // update some numbers
+    if (binned > 1)
+        counts.multibinned++;
+
+    // this will catch reads which didn't get any primer k-mer hits AND those which had too small a match proportion
+    if (binned == 0)
+        counts.unbinned++;
+}
+
+// _splitRead splits a read into a sub-read for each amplicon it contains, using pairs of primer sites from the primer k-mer hits (returns false if the read doesn't hold at least 2 amplicons).
+bool artic::Amplitigger::_splitRead(const klibpp::KSeq& read, bool windowed, binHolders& holders, binCounts& counts, std::string& output, std::vector<std::string>& binBuffers)
+{
+    // the hits are needed from across the whole read
+    uint32_t seqLen = read.seq.size();
+    if (windowed)
+    {
+        holders.hits.clear();
+        _scanKmers(read.seq, 0, seqLen, false, holders);
+        _selectAmplicons(holders);
+    }
 
-                // final opt, same value as existing max so add it as well
-                ampliconCandidates.emplace_back(std::make_pair(ampliconIDs.at(i - 1), chain));
-                chain = 0;
+    // group the hits into primer sites, where hits for an amplicon with only a short gap between them are from the same primer (as in _scanKmers)
+    std::sort(holders.hits.begin(), holders.hits.end(), [](const primerHit& lhs, const primerHit& rhs) { return lhs.start < rhs.start; });
+    uint32_t maxGap = 0;
+    for (const auto& seed : _seeds)
+        maxGap = std::max(maxGap, seed.GetSpan() * 2);
+    holders.sites.clear();
+    for (const auto& hit : holders.hits)
+    {
+        auto site = std::find_if(holders.sites.rbegin(), holders.sites.rend(), [&](const primerSite& s) { return s.ampliconID == hit.ampliconID && hit.start <= s.end + maxGap; });
+        if (site == holders.sites.rend())
+        {
+            holders.sites.push_back({hit.ampliconID, hit.start, hit.end, 1});
+            continue;
+        }
+        site->end = std::max(site->end, hit.end);
+        site->numHits++;
+    }
+
+    // pair each site with the nearest site for the same amplicon that gives about the amplicon span, without overlapping the previous pair
+    // (by more than a k-mer, as a primer k-mer can run into the next amplicon by chance)
+    holders.segments.clear();
+    uint32_t readPos = 0;
+    for (std::size_t i = 0; i < holders.sites.size(); i++)
+    {
+        const auto& site = holders.sites[i];
+        if (site.start + maxGap / 2 < readPos)
+            continue;
+        const auto& amplicon = _primerScheme->GetAmplicon(site.ampliconID);
+        uint32_t span = amplicon.GetReversePrimer()->GetEnd() - amplicon.GetForwardPrimer()->GetStart();
+        for (std::size_t j = i + 1; j < holders.sites.size(); j++)
+        {
+            const auto& partner = holders.sites[j];
+            if (partner.ampliconID != site.ampliconID)
+                continue;
+            if (partner.end - site.start > span * 1.1)
+                break;
+            if (partner.end - site.start < span / 2)
+                continue;
+            auto numHits = site.numHits + partner.numHits;
+            if (float(numHits - 1) / float(_primerKmerCounts[site.ampliconID]) >= _minPrimerKmers)
+            {
+                holders.segments.push_back({site.ampliconID, site.start, partner.end, numHits});
+                readPos = partner.end;
             }
+            break;
+        }
+    }
+    if (holders.segments.size() < 2)
+        return false;
+
+    // cut the read midway between the segments, then bin each sub-read to its segment's amplicon using the hits that fall within it
+    holders.readHits = holders.hits;
+    bool fastq = read.qual.size() == read.seq.size();
+    for (std::size_t i = 0; i < holders.segments.size(); i++)
+    {
+        const auto& segment = holders.segments[i];
+        uint32_t cutStart = (i == 0) ? 0 : (holders.segments[i - 1].end + segment.start) / 2;
+        uint32_t cutEnd = (i == holders.segments.size() - 1) ? seqLen : (segment.end + holders.segments[i + 1].start) / 2;
+        auto& subRead = holders.subRead;
+        subRead.name.assign(read.name).append("_").append(std::to_string(i + 1));
+        subRead.comment = read.comment;
+        subRead.seq.assign(read.seq, cutStart, cutEnd - cutStart);
+        if (fastq)
+            subRead.qual.assign(read.qual, cutStart, cutEnd - cutStart);
+        else
+            subRead.qual.clear();
+        holders.hits.clear();
+        for (const auto& hit : holders.readHits)
+            if (hit.start >= cutStart && hit.end <= cutEnd)
+                holders.hits.push_back({hit.ampliconID, hit.start - cutStart, hit.end - cutStart, hit.forward});
+        holders.amplicons.assign(1, {segment.ampliconID, float(segment.numHits - 1) / float(_primerKmerCounts[segment.ampliconID])});
+        holders.record.clear();
+        _assignRead(subRead, holders, counts, output, binBuffers);
+    }
+    counts.split++;
+    counts.subReads += holders.segments.size();
+    return true;
+}
+
+// _scanKmers votes for the amplicons of read k-mers that match primer k-mers, within a region of the read (stopping once past the first primer match if requested).
+void artic::Amplitigger::_scanKmers(const std::string& seq, uint32_t start, uint32_t len, bool stopAfterPrimer, binHolders& holders)
+{
+    (this->*_scanner)(seq, start, len, stopAfterPrimer, holders);
+}
 
-            // process the likely amplicons
-            int binned = 0;
-            for (auto candidate : ampliconCandidates)
+// _scanSeedKmers is _scanKmers with the k-mer size fixed at compile time (0 for runtime).
+template <uint32_t K>
+void artic::Amplitigger::_scanSeedKmers(const std::string& seq, uint32_t start, uint32_t len, bool stopAfterPrimer, binHolders& holders)
+{
+    // primer k-mers are contiguous in a read, so a long enough gap after a hit (allowing for a sequencing error) means the primer has been passed
+    for (std::size_t i = 0; i < _seeds.size(); i++)
+    {
+        const auto& primerKmerIndex = _primerKmerIndexes[i];
+        uint32_t span = (K != 0) ? K : _seeds[i].GetSpan();
+        uint32_t maxGap = span * 2;
+        uint32_t lastHit = 0;
+        bool hit = false;
+        for (const auto& kmer : artic::KmerScanner<K>(seq.c_str() + start, len, _seeds[i]))
+        {
+            if (stopAfterPrimer && hit && (kmer.end - lastHit > maxGap))
+                break;
+
+            // check if read k-mer is matched to a primer k-mer, keeping track of the amplicons that get votes
+            bool forward;
+            auto ampliconID = primerKmerIndex.Find<K>(kmer.kmer, forward);
+            if (ampliconID != artic::NO_AMPLICON)
             {
-                auto amplicon = _primerScheme->GetAmplicon(candidate.first);
-                auto ampliconKmers = (amplicon.GetForwardPrimer()->GetLen() + amplicon.GetReversePrimer()->GetLen()) - (_kmerSize * 2) + 2;
-                auto propKmers = float(candidate.second) / float(ampliconKmers);
-                if (propKmers >= _minPrimerKmers)
-                {
-                    std::cout << record.name << "\t" << amplicon.GetName() << "\t" << propKmers << std::endl;
-                    binned++;
-                }
+                if (holders.votes[ampliconID]++ == 0)
+                    holders.voted.emplace_back(ampliconID);
+                lastHit = kmer.end;
+                hit = true;
+                if (_collectHits)
+                    holders.hits.push_back({ampliconID, start + kmer.end - span, start + kmer.end, kmer.forward == forward});
             }
+        }
+    }
+}
+
+// _rescueRead bins a read by its amplicon insert minimizers, selecting the amplicons with the most minimizer hits (returns false if too few of the read minimizers hit an amplicon).
+bool artic::Amplitigger::_rescueRead(const std::string& seq, binHolders& holders)
+{
+    // a minimizer from the overlap of two amplicons votes for both, but is only evidence for an amplicon if it also has hits of its own
+    holders.minimizers.clear();
+    artic::GetMinimizers(seq.c_str(), seq.size(), _minimizerIndex->GetKmerSize(), _minimizerIndex->GetWindowSize(), holders.minimizers);
+    int strand = 0;
+    for (const auto& minimizer : holders.minimizers)
+    {
+        auto entry = _minimizerIndex->Find(minimizer.kmer);
+        if (!entry)
+            continue;
+        for (unsigned int ampliconID : {entry->ampliconID, entry->sharedID})
+            if (ampliconID != artic::NO_AMPLICON && holders.votes[ampliconID]++ == 0)
+                holders.voted.emplace_back(ampliconID);
+        if (entry->sharedID == artic::NO_AMPLICON)
+            holders.uniqueVotes[entry->ampliconID]++;
+        strand += (minimizer.forward == entry->forward) ? 1 : -1;
+    }
+    holders.minimizerForward = (strand >= 0);
 
-            // update some numbers
-            if (binned > 1)
-                _multibinned++;
+    // keep the amplicons with the top vote, as long as enough of the read minimizers hit them (so partial reads aren't penalised), then reset the votes
+    // (amplicons need at least 2 hits to be considered, as with the primer k-mers)
+    uint32_t topVotes = std::max(2U, uint32_t(_minMinimizers * holders.minimizers.size() + 0.999));
+    for (auto ampliconID : holders.voted)
+        if (holders.uniqueVotes[ampliconID] != 0)
+            topVotes = std::max(topVotes, holders.votes[ampliconID]);
+    for (auto ampliconID : holders.voted)
+    {
+        if (holders.uniqueVotes[ampliconID] != 0 && holders.votes[ampliconID] == topVotes)
+            holders.amplicons.emplace_back(ampliconID, float(topVotes) / float(holders.minimizers.size()));
+        holders.votes[ampliconID] = 0;
+        holders.uniqueVotes[ampliconID] = 0;
+    }
+    holders.voted.clear();
+    std::sort(holders.amplicons.begin(), holders.amplicons.end());
+    return !holders.amplicons.empty();
+}
 
-            // this will catch reads which didn't get any primer k-mer hits AND those which had too small a match proportion
-            if (binned == 0)
-                _droppedUnbinned++;
+// _selectAmplicons finds the amplicons with the most votes, keeping those with enough primer k-mers, and then resets the votes.
+void artic::Amplitigger::_selectAmplicons(binHolders& holders)
+{
+    holders.amplicons.clear();
 
-            // compare biggest chain to max %k-mer content
-            // remove chains with multiple identities
+    // get the top vote, amplicons need at least 2 matching k-mers to be considered
+    uint32_t topVotes = 2;
+    for (auto ampliconID : holders.voted)
+        topVotes = std::max(topVotes, holders.votes[ampliconID]);
+
+    // keep all the amplicons with the top vote that have enough of their primer k-mers (the first k-mer hit is not counted)
+    for (auto ampliconID : holders.voted)
+    {
+        if (holders.votes[ampliconID] == topVotes)
+        {
+            auto propKmers = float(topVotes - 1) / float(_primerKmerCounts[ampliconID]);
+            if (propKmers >= _minPrimerKmers)
+                holders.amplicons.emplace_back(ampliconID, propKmers);
         }
+        holders.votes[ampliconID] = 0;
     }
+    holders.voted.clear();
 
-    // print some stats
-    LOG_TRACE("finished processing reads")
-    LOG_TRACE("\ttotal input reads:\t{}", _readCounter);
-    LOG_TRACE("\ttotal dropped reads:\t{}", (_droppedLong + _droppedShort + _droppedUnbinned));
-    LOG_TRACE("\t- short reads (<{}):\t{}", _minReadLength, _droppedShort);
-    LOG_TRACE("\t- long reads (>{}):\t{}", _maxReadLength, _droppedLong);
-    LOG_TRACE("\t- unbinned reads:\t{}", _droppedUnbinned);
-    LOG_TRACE("\ttotal binned reads:\t{}", (_readCounter - (_droppedLong + _droppedShort + _droppedUnbinned)));
-    LOG_TRACE("\t- multibinned reads:\t{}", _multibinned);
+    // keep the output in amplicon order
+    std::sort(holders.amplicons.begin(), holders.amplicons.end());
+}
+
+// _findInsert gets the region of a read between the primers of its selected amplicons, using the primer k-mer hits.
+void artic::Amplitigger::_findInsert(uint32_t seqLen, const binHolders& holders, uint32_t& start, uint32_t& end) const
+{
+    // the primers are at either end of the read, so the hits in each half of the read are for the primer at that end
+    // (only hits within a primer length of the outermost hit are used, so stray hits inside the insert are ignored)
+    uint32_t midpoint = seqLen / 2;
+    uint32_t insertStart = seqLen;
+    uint32_t insertEnd = 0;
+    for (auto candidate : holders.amplicons)
+    {
+        const auto& amplicon = _primerScheme->GetAmplicon(candidate.first);
+        uint32_t primerLen = std::max(amplicon.GetForwardPrimer()->GetLen(), amplicon.GetReversePrimer()->GetLen());
+        uint32_t firstStart = seqLen;
+        uint32_t lastEnd = 0;
+        for (const auto& hit : holders.hits)
+        {
+            if (hit.ampliconID != candidate.first)
+                continue;
+            if (hit.end <= midpoint)
+                firstStart = std::min(firstStart, hit.start);
+            else
+                lastEnd = std::max(lastEnd, hit.end);
+        }
+        uint32_t primerEnd = 0;
+        uint32_t primerStart = seqLen;
+        for (const auto& hit : holders.hits)
+        {
+            if (hit.ampliconID != candidate.first)
+                continue;
+            if (hit.end <= midpoint && hit.start < firstStart + primerLen)
+                primerEnd = std::max(primerEnd, hit.end);
+            else if (hit.end > midpoint && hit.end + primerLen > lastEnd)
+                primerStart = std::min(primerStart, hit.start);
+        }
+
+        // a multibinned read is trimmed to cover the inserts of all its amplicons, ignoring ends where an amplicon had no hits
+        if (primerEnd != 0)
+            insertStart = std::min(insertStart, primerEnd);
+        if (primerStart != seqLen)
+            insertEnd = std::max(insertEnd, primerStart);
+    }
+    start = (insertStart == seqLen) ? 0 : insertStart;
+    end = (insertEnd == 0) ? seqLen : insertEnd;
+
+    // keep the whole read if the primers overlap
+    if (start >= end)
+    {
+        start = 0;
+        end = seqLen;
+    }
+}
+
+// _isForward gets the strand of a read from its primer k-mer hits for an amplicon (true if most hits are on the reference strand).
+bool artic::Amplitigger::_isForward(unsigned int ampliconID, const binHolders& holders) const
+{
+    // reads binned by the minimizer fallback may have no primer k-mer hits, so use the strand of their minimizer hits
+    int strand = 0;
+    bool hit = false;
+    for (const auto& primerHit : holders.hits)
+    {
+        if (primerHit.ampliconID != ampliconID)
+            continue;
+        strand += (primerHit.forward) ? 1 : -1;
+        hit = true;
+    }
+    return (hit) ? strand >= 0 : holders.minimizerForward;
+}
+
+// _addToReservoir adds a read to the reservoir for an amplicon strand.
+void artic::Amplitigger::_addToReservoir(std::size_t slot, sampledRead&& read)
+{
+    // the reads with the lowest priorities are kept, so the sample doesn't depend on the read order or the number of threads
+    auto higher = [](const sampledRead& lhs, const sampledRead& rhs) { return lhs.priority < rhs.priority; };
+    std::lock_guard<std::mutex> lock(_reservoirLocks[slot]);
+    _strandCounts[slot].fetch_add(1, std::memory_order_relaxed);
+    auto& reservoir = _reservoirs[slot];
+    if (reservoir.size() < _maxDepth)
+    {
+        reservoir.emplace_back(std::move(read));
+        std::push_heap(reservoir.begin(), reservoir.end(), higher);
+        return;
+    }
+    if (read.priority >= reservoir.front().priority)
+        return;
+    std::pop_heap(reservoir.begin(), reservoir.end(), higher);
+    reservoir.back() = std::move(read);
+    std::push_heap(reservoir.begin(), reservoir.end(), higher);
+}
+
+// _writeReservoirs writes the reservoir sampled reads to the FASTQ bins.
+void artic::Amplitigger::_writeReservoirs(void)
+{
+    if (_maxDepth == 0 || _depthCapMode != DepthCapMode::reservoir)
+        return;
+
+    // write each amplicon strand in priority order, skipping reads already written to a shared bin by another amplicon
+    std::vector<std::unordered_set<uint64_t>> written(_fastqOutput->GetNumBins());
+    std::string records;
+    for (std::size_t slot = 2; slot < _reservoirs.size(); slot++)
+    {
+        auto& reservoir = _reservoirs[slot];
+        _capped += _strandCounts[slot] - reservoir.size();
+        std::sort(reservoir.begin(), reservoir.end(), [](const sampledRead& lhs, const sampledRead& rhs) { return lhs.priority < rhs.priority; });
+        auto bin = _ampliconBins[slot / 2];
+        records.clear();
+        for (const auto& read : reservoir)
+        {
+            if (!written[bin].insert(read.priority).second)
+                continue;
+            records.append(read.record);
+            _trimmedBases += read.trimmed;
+        }
+        if (!records.empty())
+            _fastqOutput->Write(bin, records);
+        reservoir.clear();
+    }
+}
+
+// _addToGraph adds a read to the graph for its amplicon, on the reference strand (until the graph has enough reads).
+void artic::Amplitigger::_addToGraph(unsigned int ampliconID, const klibpp::KSeq& read, const binHolders& holders)
+{
+    bool reverse = !_isForward(ampliconID, holders);
+    std::lock_guard<std::mutex> lock(_graphLocks[ampliconID]);
+    auto& graph = *_graphs[ampliconID];
+    if (graph.GetNumReads() < AMPLITIG_GRAPH_READS)
+        graph.AddRead(read.seq.c_str(), read.seq.size(), reverse);
 }
 
-/*
-collect primer k-mers
-remove any k-mers shared between primers
-check each primer has some primers left / select a minimizer?
+// _buildAmplitigs walks the amplicon graphs between their primer anchors to get the amplitigs, freeing each graph once walked.
+void artic::Amplitigger::_buildAmplitigs(void)
+{
+    // the anchors are the last k-mer of the forward primer and the first k-mer of the reverse primer, on the reference strand
+    auto numAmplicons = _primerScheme->GetNumAmplicons();
+    std::vector<std::pair<std::string, std::string>> anchors(numAmplicons + 1);
+    std::vector<uint32_t> maxLens(numAmplicons + 1, 0);
+    artic::RefStore reference(_refFile);
+    for (unsigned int id = 1; id <= numAmplicons; id++)
+    {
+        const auto& amplicon = _primerScheme->GetAmplicon(id);
+        auto fwdEnd = amplicon.GetForwardPrimer()->GetEnd();
+        auto revStart = amplicon.GetReversePrimer()->GetStart();
+        reference.GetSeq(_primerScheme->GetReferenceName(), fwdEnd - _graphKmerSize, fwdEnd, anchors[id].first);
+        reference.GetSeq(_primerScheme->GetReferenceName(), revStart, revStart + _graphKmerSize, anchors[id].second);
+
+        // allow for indels in the sample, but stop walking if the path is much longer than the reference
+        maxLens[id] = (revStart - fwdEnd + (_graphKmerSize * 2)) * 1.5;
+    }
 
-grab a read
-get vector of k-mers
-loop through the vector and check against primer k-mers
-add vector of k-mers to k-mer freq map of matched amplicon
+    // each amplicon is walked independently, so share them out between the binning threads
+    _amplitigs.assign(numAmplicons + 1, "");
+    std::atomic<unsigned int> nextID(1);
+    auto walkGraphs = [&] {
+        std::string amplitig;
+        for (unsigned int id = nextID++; id <= numAmplicons; id = nextID++)
+        {
+            const auto& anchor = anchors[id];
+            bool validAnchors = anchor.first.find('N') == std::string::npos && anchor.second.find('N') == std::string::npos;
+            if (validAnchors && _graphs[id]->GetNumReads() != 0 && _graphs[id]->GetAmplitig(anchor.first, anchor.second, _minKmerCount, maxLens[id], amplitig))
+                _amplitigs[id] = amplitig;
+            _graphs[id].reset();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < std::min(_numThreads, numAmplicons); i++)
+        workers.emplace_back(walkGraphs);
+    for (auto& worker : workers)
+        worker.join();
+}
+
+// _stitchAmplitigs joins the amplitigs in amplicon order to get the draft genome, which covers the scheme from the first forward anchor to the last reverse anchor.
+void artic::Amplitigger::_stitchAmplitigs(void)
+{
+    // refEnd tracks the reference position at the end of the draft, so gaps and overlaps without a shared k-mer can be sized from the scheme
+    auto numAmplicons = _primerScheme->GetNumAmplicons();
+    int64_t k = _graphKmerSize;
+    int64_t refEnd = _primerScheme->GetAmplicon(1).GetForwardPrimer()->GetEnd() - k;
+    std::size_t lastStart = 0;
+    unsigned int numAmplitigs = 0;
+    _draftGenome.clear();
+    for (unsigned int id = 1; id <= numAmplicons; id++)
+    {
+        const auto& amplitig = _amplitigs[id];
+        if (amplitig.empty())
+            continue;
+        numAmplitigs++;
 
-requires 3x loops:
-once to get k-mers from sequence
-once to check k-mers against primer k-mers
-once to add k-mers to correct amplicon map
+        // merge on the first k-mer of the amplitig if it is in the previous amplitig, otherwise pad or trim the draft to the amplitig start
+        const auto& amplicon = _primerScheme->GetAmplicon(id);
+        auto overlap = _draftGenome.find(amplitig.c_str(), lastStart, k);
+        if (overlap != std::string::npos)
+            _draftGenome.resize(overlap);
+        else
+        {
+            int64_t gap = (amplicon.GetForwardPrimer()->GetEnd() - k) - refEnd;
+            if (gap >= 0)
+                _draftGenome.append(gap, 'N');
+            else
+                _draftGenome.resize(std::max(int64_t(lastStart), int64_t(_draftGenome.size()) + gap));
+        }
+        lastStart = _draftGenome.size();
+        _draftGenome.append(amplitig);
+        refEnd = amplicon.GetReversePrimer()->GetStart() + k;
+    }
+    if (numAmplitigs == 0)
+    {
+        _draftGenome.clear();
+        LOG_WARN("\tno amplitigs could be built");
+        return;
+    }
+    int64_t schemeEnd = _primerScheme->GetAmplicon(numAmplicons).GetReversePrimer()->GetStart() + k;
+    if (schemeEnd > refEnd)
+        _draftGenome.append(schemeEnd - refEnd, 'N');
+    LOG_TRACE("\tamplitigs built:\t{} of {} amplicons", numAmplitigs, numAmplicons);
+    LOG_TRACE("\tdraft genome length:\t{} ({} Ns)", _draftGenome.size(), std::count(_draftGenome.begin(), _draftGenome.end(), 'N'));
+}
 
-improvements for effiency:
-heuristic to skip regions during primer check (i.e, found one primer so can skip ~100 k-mers to next likley place a primer is found)
-check k-mer against map as it is generated - might be a better way
+// _writeConsensus writes the amplitigs and draft genome to FASTA.
+void artic::Amplitigger::_writeConsensus(void)
+{
+    auto amplitigFile = _consensusPrefix + ".amplitigs.fasta";
+    std::ofstream fh(amplitigFile);
+    if (!fh)
+        throw std::runtime_error("could not open amplitig file for writing: " + amplitigFile);
+    for (unsigned int id = 1; id <= _primerScheme->GetNumAmplicons(); id++)
+        if (!_amplitigs[id].empty())
+            fh << ">" << _primerScheme->GetAmpliconName(id) << "\n"
+               << _amplitigs[id] << "\n";
+    fh.close();
+    if (!fh)
+        throw std::runtime_error("could not write amplitig file: " + amplitigFile);
 
-additions:
-bloom filter to each amplicon to remove unique k-mers
-remove/exclude primer k-mers (but how to clip reads before/after primer sequence to within amplicons?)
+    // the draft genome is named after the prefix, without any directories
+    auto draftFile = _consensusPrefix + ".draft.fasta";
+    fh.open(draftFile);
+    if (!fh)
+        throw std::runtime_error("could not open draft genome file for writing: " + draftFile);
+    if (!_draftGenome.empty())
+        fh << ">" << boost::filesystem::path(_consensusPrefix).filename().string() << "\n"
+           << _draftGenome << "\n";
+    fh.close();
+    if (!fh)
+        throw std::runtime_error("could not write draft genome file: " + draftFile);
+    LOG_TRACE("\tamplitigs written to:\t{}", amplitigFile);
+    LOG_TRACE("\tdraft genome written to:\t{}", draftFile);
+}
 
-*/
\ No newline at end of file
+// _writeAbundance writes the reads per amplicon and per pool to the output, as tab separated lines starting with the record type.
+void artic::Amplitigger::_writeAbundance(void)
+{
+    auto numPools = _primerScheme->GetPrimerPools().size();
+    std::vector<uint64_t> poolCounts(numPools + 1, 0);
+    std::vector<unsigned int> poolDropouts(numPools + 1, 0);
+    *_output << "#amplicon\tname\tpool\treads\tdepth\n";
+    for (unsigned int id = 1; id <= _primerScheme->GetNumAmplicons(); id++)
+    {
+        auto poolID = _primerScheme->GetAmplicon(id).GetPrimerPoolID();
+        uint64_t count = _ampliconCounts[id];
+        poolCounts[poolID] += count;
+        if (count == 0)
+            poolDropouts[poolID]++;
+        *_output << "amplicon\t" << _primerScheme->GetAmpliconName(id) << "\t" << _primerScheme->GetPrimerPool(poolID) << "\t" << count << "\t" << std::fixed << std::setprecision(1) << GetAmpliconDepth(id) << "\n";
+    }
+    *_output << "#pool\tname\treads\tamplicons without reads\n";
+    unsigned int numDropouts = 0;
+    for (std::size_t poolID = 1; poolID <= numPools; poolID++)
+    {
+        *_output << "pool\t" << _primerScheme->GetPrimerPool(poolID) << "\t" << poolCounts[poolID] << "\t" << poolDropouts[poolID] << "\n";
+        numDropouts += poolDropouts[poolID];
+    }
+    LOG_TRACE("\tamplicons without reads:\t{} of {}", numDropouts, _primerScheme->GetNumAmplicons());
+}
+
+// _loadPrimerKmers builds a primer k-mer index for each seed pattern.
+void artic::Amplitigger::_loadPrimerKmers(const std::vector<std::string>& patterns)
+{
+    std::vector<artic::SpacedSeed> seeds;
+    for (const auto& pattern : patterns)
+    {
+        seeds.emplace_back(pattern);
+        if (seeds.back().GetSpan() > _primerScheme->GetMinPrimerLen())
+            throw std::runtime_error("requested k-mer size or seed span greater than the smallest primer in scheme (" + std::to_string(_primerScheme->GetMinPrimerLen()) + ")");
+    }
+
+    // get the number of primer k-mers for each amplicon across all seeds, used to get the proportion of matching k-mers for a read
+    _primerKmerCounts.assign(_primerScheme->GetNumAmplicons() + 1, 0);
+    for (unsigned int id = 1; id <= _primerScheme->GetNumAmplicons(); id++)
+    {
+        const auto& amplicon = _primerScheme->GetAmplicon(id);
+        for (const auto& seed : seeds)
+            _primerKmerCounts[id] += (amplicon.GetForwardPrimer()->GetLen() + amplicon.GetReversePrimer()->GetLen()) - (seed.GetSpan() * 2) + 2;
+    }
+
+    // index the primer k-mers for each seed
+    artic::RefStore reference(_refFile);
+    _primerKmerIndexes.clear();
+    for (const auto& seed : seeds)
+    {
+        _primerKmerIndexes.emplace_back(*_primerScheme, reference, seed);
+        if (!seed.IsContiguous())
+            LOG_TRACE("\tspaced seed:\t{} (span {}, weight {})", seed.GetPattern(), seed.GetSpan(), seed.GetWeight());
+        LOG_TRACE("\ttotal mutually exclusive k-mers:\t{}", _primerKmerIndexes.back().GetNumKmers());
+        LOG_TRACE("\ttotal shared k-mers (dropped):\t{}", _primerKmerIndexes.back().GetNumShared());
+        LOG_TRACE("\tk-mer index size:\t{} bytes", _primerKmerIndexes.back().GetMemoryUsage());
+    }
+    _seeds = std::move(seeds);
+
+    // select the k-mer scan once, fixing the k-mer size at compile time when every seed is contiguous and of the same size
+    _scanner = &Amplitigger::_scanSeedKmers<0>;
+    bool fixedSize = true;
+    for (const auto& seed : _seeds)
+        fixedSize &= seed.IsContiguous() && seed.GetSpan() == _seeds.front().GetSpan();
+    if (fixedSize)
+        artic::DispatchKmerSize<artic::MAX_K_SIZE>(_seeds.front().GetSpan(), [&](auto k) { _scanner = &Amplitigger::_scanSeedKmers<decltype(k)::value>; });
+}
+
+// _openFastqOutput opens the FASTQ bin files for a run.
+void artic::Amplitigger::_openFastqOutput(void)
+{
+    _fastqOutput.reset();
+    if (_binOutput == BinOutput::none)
+        return;
+
+    // get the bin names and the bin for each amplicon
+    std::vector<std::string> binNames;
+    _ampliconBins.assign(_primerScheme->GetNumAmplicons() + 1, 0);
+    if (_binOutput == BinOutput::amplicon)
+    {
+        for (unsigned int id = 1; id <= _primerScheme->GetNumAmplicons(); id++)
+        {
+            binNames.emplace_back(_primerScheme->GetAmpliconName(id));
+            _ampliconBins[id] = id - 1;
+        }
+    }
+    else
+    {
+        binNames = _primerScheme->GetPrimerPools();
+        for (unsigned int id = 1; id <= _primerScheme->GetNumAmplicons(); id++)
+        {
+            auto poolID = _primerScheme->GetAmplicon(id).GetPrimerPoolID();
+            if (poolID == 0)
+                throw std::runtime_error("amplicon has no primer pool: " + _primerScheme->GetAmpliconName(id));
+            _ampliconBins[id] = poolID - 1;
+        }
+    }
+    _reservoirs.assign((_primerScheme->GetNumAmplicons() + 1) * 2, {});
+    for (unsigned int i = 0; i < (_primerScheme->GetNumAmplicons() + 1) * 2; i++)
+        _strandCounts[i] = 0;
+    LOG_TRACE("\twriting FASTQ bins:\t{}.*.fastq.gz ({} files, {} compression threads)", _fastqPrefix, binNames.size(), _compressionThreads);
+    _fastqOutput.reset(new artic::FastqBinWriter(_fastqPrefix, binNames, _compressionThreads));
+}
+
+// _addCounts adds a worker's batch counts to the totals and resets them.
+void artic::Amplitigger::_addCounts(binCounts& counts)
+{
+    _readCounter.fetch_add(counts.reads, std::memory_order_relaxed);
+    _droppedShort.fetch_add(counts.droppedShort, std::memory_order_relaxed);
+    _droppedLong.fetch_add(counts.droppedLong, std::memory_order_relaxed);
+    _droppedUnbinned.fetch_add(counts.unbinned, std::memory_order_relaxed);
+    _multibinned.fetch_add(counts.multibinned, std::memory_order_relaxed);
+    _fullScans.fetch_add(counts.fullScans, std::memory_order_relaxed);
+    _trimmedBases.fetch_add(counts.trimmedBases, std::memory_order_relaxed);
+    _capped.fetch_add(counts.capped, std::memory_order_relaxed);
+    _split.fetch_add(counts.split, std::memory_order_relaxed);
+    _subReads.fetch_add(counts.subReads, std::memory_order_relaxed);
+    _rescued.fetch_add(counts.rescued, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < counts.ampliconCounts.size(); i++)
+    {
+        if (counts.ampliconCounts[i] == 0)
+            continue;
+        _ampliconCounts[i].fetch_add(counts.ampliconCounts[i], std::memory_order_relaxed);
+        _ampliconBases[i].fetch_add(counts.ampliconBases[i], std::memory_order_relaxed);
+        counts.ampliconCounts[i] = 0;
+        counts.ampliconBases[i] = 0;
+    }
+    counts.reads = counts.droppedShort = counts.droppedLong = counts.unbinned = counts.multibinned = counts.fullScans = counts.trimmedBases = counts.capped = counts.split = counts.subReads = counts.rescued = 0;
+}
+
+// _resetCounts zeroes the counters, so that each run only reports its own reads.
+void artic::Amplitigger::_resetCounts(void)
+{
+    _readCounter = 0;
+    _droppedLong = 0;
+    _droppedShort = 0;
+    _droppedUnbinned = 0;
+    _multibinned = 0;
+    _fullScans = 0;
+    _trimmedBases = 0;
+    _capped = 0;
+    _split = 0;
+    _subReads = 0;
+    _rescued = 0;
+    _numFiles = 0;
+    for (unsigned int i = 0; i <= _primerScheme->GetNumAmplicons(); i++)
+    {
+        _ampliconCounts[i] = 0;
+        _ampliconBases[i] = 0;
+    }
+}
@@ -1,53 +1,345 @@
 #ifndef AMPLITIG_H
 #define AMPLITIG_H
 
+#include <atomic>
+#include <iostream>
+#include <kseq++/seqio.hpp>
+#include <memory>
 #include <mutex>
-#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "ampliconMinimizerIndex.hpp"
+#include "amplitigGraph.hpp"
+#include "boundedQueue.hpp"
+#include "fastqBinWriter.hpp"
 #include "kmers.hpp"
+#include "primerKmerIndex.hpp"
 #include "primerScheme.hpp"
 
 namespace artic
 {
+    // AMPLITIG_BATCH_SIZE is the number of reads passed from the parser to a worker in one go.
+    const unsigned int AMPLITIG_BATCH_SIZE = 512;
+
+    // AMPLITIG_WRITE_BUFFER is the number of bytes a worker buffers for a FASTQ bin before writing it.
+    const std::size_t AMPLITIG_WRITE_BUFFER = 1 << 16;
+
+    // AMPLITIG_GRAPH_READS is the number of reads added to the graph for each amplicon when building amplitigs.
+    const uint32_t AMPLITIG_GRAPH_READS = 100;
+
+    // AMPLITIG_WATCH_WAIT is how long to wait for new files in the watch directory before checking the stop conditions (in milliseconds).
+    const unsigned int AMPLITIG_WATCH_WAIT = 1000;
+
+    // BinOutput is used to set how binned reads are written to FASTQ files.
+    enum class BinOutput
+    {
+        none,     // no FASTQ output
+        amplicon, // one FASTQ file per amplicon
+        pool      // one FASTQ file per primer pool
+    };
+
+    // DepthCapMode is used to set how reads are chosen when an amplicon strand goes over the depth cap.
+    enum class DepthCapMode
+    {
+        firstN,   // keep the first reads binned to the amplicon strand
+        reservoir // keep a random sample of the reads binned to the amplicon strand, chosen by a seeded hash of the read names
+    };
 
     //******************************************************************************
     // Amplitigger class handles the amplicon read binning
+    //
+    // NOTES:
+    // * one thread parses the FASTQ files and queues batches of reads for a pool of workers
+    // * each worker bins its reads against the primer k-mer index and buffers its output, writing it once per batch
+    // * primer k-mer hits are tallied in a per-worker vote array indexed by amplicon ID, which is reset via the list of amplicons that got votes
+    // * the counters are atomics, which workers update once per batch (they are zeroed at the start of each Run or Watch)
+    // * read batches are recycled between the parser and the workers to save on allocations
+    // * output order is not guaranteed to match the input order when using more than one thread
+    // * spaced seeds can be used instead of contiguous k-mers, so that primer hits tolerate sequencing errors
+    // * primers can be searched for at the read ends only, with a full scan of the read if that doesn't find an amplicon
+    // * input files are decompressed off the parser thread, block-parallel for BGZF input and on a single inflate thread for other gzip files
+    // * binned reads can also be written to FASTQ files per amplicon or per pool, which are compressed on a separate thread pool
+    // * FASTQ reads can be trimmed to the amplicon insert, cutting after the primer k-mer hits of its amplicon at each end of the read
+    // * FASTQ output can be capped per amplicon strand, with the strand of a read taken from the reference strand of its primer k-mer hits
+    // * reservoir sampled reads are held until the end of the run, so memory scales with the depth cap and not the number of reads
+    // * reads with the primer pairs of more than one amplicon (such as ligation concatemers) can be split into a sub-read per amplicon, cut midway between the primer pairs
+    // * reads that fail the primer k-mer test can fall back to an index of minimizers along the amplicon inserts, minimizers in the overlap of two amplicons count towards both
+    // * the read assignments can be replaced by an abundance report of the reads per amplicon and per pool, written once all the reads are binned
+    // * a directory can be watched for new FASTQ files instead, with the parser reading each new file once and a JSON snapshot of the counts rewritten as it goes
+    // * amplitigs are built from a de Bruijn graph per amplicon, fed by the first reads binned to only that amplicon (so not in input order when using more than one thread)
+    // * the amplitigs are stitched in amplicon order into a draft genome, merging overlaps on their shared k-mers and padding gaps with Ns (using reference coordinates)
     //******************************************************************************
     class Amplitigger
     {
     public:
-        // Amplitigger constructor and destructor.
-        Amplitigger(artic::PrimerScheme* primerScheme, const std::string& refFile, const std::vector<std::string> inputFiles, unsigned int kmerSize, float kmerMatch);
-        //~Amplitigger(void);
+        // Amplitigger constructor.
+        Amplitigger(const artic::PrimerScheme* primerScheme, const std::string& refFile, const std::vector<std::string> inputFiles, unsigned int kmerSize, float kmerMatch, unsigned int numThreads = 1, std::ostream& output = std::cout);
+
+        // SetReadLengthLimits will drop reads shorter than minReadLength or longer than maxReadLength (0 for 10% longer than the longest amplicon in the scheme).
+        void SetReadLengthLimits(unsigned int minReadLength, unsigned int maxReadLength = 0);
+
+        // SetFastqOutput will write binned reads to compressed FASTQ files (<prefix>.<bin name>.fastq.gz) during the next Run.
+        void SetFastqOutput(const std::string& prefix, BinOutput binOutput, unsigned int compressionThreads = 1);
+
+        // SetSpacedSeeds will use spaced seed k-mers for binning instead of contiguous k-mers (a read k-mer hit from any seed counts towards its amplicon).
+        void SetSpacedSeeds(const std::vector<std::string>& patterns);
+
+        // SetPrimerTrimming will trim the primers (and anything beyond them, such as adapters) from the reads written to FASTQ.
+        void SetPrimerTrimming(bool trimPrimers);
+
+        // SetChimeraSplitting will split reads holding more than one amplicon (such as ligation concatemers) into a sub-read per amplicon, instead of multibinning or dropping them.
+        void SetChimeraSplitting(bool splitChimeras);
+
+        // SetDepthCap will only write up to this many reads to FASTQ for each amplicon strand (0 for no cap), using the seed if reservoir sampling.
+        void SetDepthCap(unsigned int maxDepth, DepthCapMode mode = DepthCapMode::firstN, uint64_t seed = 0);
+
+        // SetConsensusOutput will build an amplitig for each amplicon during the next Run, writing them and the stitched draft genome to FASTA (<prefix>.amplitigs.fasta and <prefix>.draft.fasta).
+        void SetConsensusOutput(const std::string& prefix, unsigned int graphKmerSize = 15, unsigned int minKmerCount = 3);
+
+        // SetEndWindow will only look for primers within this many bases at each end of a read, unless that fails to find an amplicon (0 scans the whole read).
+        void SetEndWindow(unsigned int windowSize);
+
+        // SetMinimizerFallback will bin reads that fail the primer k-mer test by the (w,k)-minimizers of the amplicon inserts, needing the given proportion of the read minimizers to hit an amplicon.
+        void SetMinimizerFallback(unsigned int kSize = 15, unsigned int wSize = 10, float minMatch = 0.1);
+
+        // SetAbundanceReport will write a report of the reads per amplicon and per pool at the end of the next Run, instead of the read assignments.
+        void SetAbundanceReport(bool abundanceReport);
+
+        // SetDecompressionThreads sets the number of threads used to decompress BGZF input files (other files are inflated on a single background thread).
+        void SetDecompressionThreads(unsigned int numThreads);
+
+        // GetFastqFiles returns the FASTQ files written by the last Run.
+        const std::vector<std::string>& GetFastqFiles(void) const;
 
         // Run will perform the amplitigging.
         void Run();
 
+        // Watch will bin the reads from FASTQ files as they are written to a directory, rewriting a JSON snapshot of the amplicon counts, until every amplicon reaches the target depth or no new files arrive within the idle timeout (in seconds).
+        void Watch(const std::string& watchDir, const std::string& snapshotFile, unsigned int targetDepth, unsigned int idleTimeout, unsigned int snapshotInterval = 30);
+
+        // GetNumFiles returns the number of FASTQ files read.
+        uint64_t GetNumFiles(void) const;
+
+        // GetNumReads returns the number of reads processed.
+        uint64_t GetNumReads(void) const;
+
+        // GetNumDroppedShort returns the number of reads dropped for being too short.
+        uint64_t GetNumDroppedShort(void) const;
+
+        // GetNumDroppedLong returns the number of reads dropped for being too long.
+        uint64_t GetNumDroppedLong(void) const;
+
+        // GetNumUnbinned returns the number of reads that were not binned to an amplicon.
+        uint64_t GetNumUnbinned(void) const;
+
+        // GetNumMultibinned returns the number of reads that were binned to more than one amplicon.
+        uint64_t GetNumMultibinned(void) const;
+
+        // GetNumFullScans returns the number of reads that needed a full scan as the end windows didn't find an amplicon.
+        uint64_t GetNumFullScans(void) const;
+
+        // GetNumTrimmedBases returns the number of bases trimmed from the reads written to FASTQ.
+        uint64_t GetNumTrimmedBases(void) const;
+
+        // GetNumSplit returns the number of reads that were split into sub-reads.
+        uint64_t GetNumSplit(void) const;
+
+        // GetNumSubReads returns the number of sub-reads that split reads were cut into.
+        uint64_t GetNumSubReads(void) const;
+
+        // GetNumRescued returns the number of reads that failed the primer k-mer test but were binned by the minimizer fallback.
+        uint64_t GetNumRescued(void) const;
+
+        // GetNumCapped returns the number of binned reads that were not written to FASTQ as their amplicon strand was over the depth cap.
+        uint64_t GetNumCapped(void) const;
+
+        // GetAmpliconCount returns the number of reads binned to an amplicon.
+        uint64_t GetAmpliconCount(unsigned int ampliconID) const;
+
+        // GetPoolCount returns the number of reads binned to the amplicons of a primer pool (reads binned to more than one amplicon count towards each).
+        uint64_t GetPoolCount(unsigned int poolID) const;
+
+        // GetAmpliconDepth returns an estimate of the mean depth of an amplicon (the bases binned to it over the amplicon span).
+        double GetAmpliconDepth(unsigned int ampliconID) const;
+
+        // GetAmplitig returns the amplitig built for an amplicon by the last Run (empty if one couldn't be built).
+        const std::string& GetAmplitig(unsigned int ampliconID) const;
+
+        // GetDraftGenome returns the draft genome stitched from the amplitigs by the last Run.
+        const std::string& GetDraftGenome(void) const;
+
     private:
-        // data holders
-        artic::PrimerScheme* _primerScheme;         // the loaded primer scheme
-        const std::string _refFile;                 // the reference fasta file
-        const std::vector<std::string> _inputFiles; // input FASTQ files
-        kmermap_t _primerKmerMap;                   // map of primer k-mers and their origins
-        // std::unordered_map<std::string, artic::Amplicon> _amplicons; // map of amplicons
+        // readBatch is a batch of reads passed from the parser to a worker.
+        struct readBatch
+        {
+            std::vector<klibpp::KSeq> reads; // the read holders (may be larger than the batch)
+            std::size_t size = 0;            // the number of reads in the batch
+        };
+
+        // primerHit is where a read k-mer matched a primer k-mer.
+        struct primerHit
+        {
+            unsigned int ampliconID; // the amplicon of the primer k-mer
+            uint32_t start;          // the read position of the first base of the k-mer
+            uint32_t end;            // the read position after the last base of the k-mer
+            bool forward;            // true if the read k-mer is on the reference strand
+        };
+
+        // primerSite is a group of primer k-mer hits in a read from the same primer, or a pair of them bounding an amplicon in a read being split.
+        struct primerSite
+        {
+            unsigned int ampliconID; // the amplicon of the primer k-mer hits
+            uint32_t start;          // the read position of the first base of the first hit
+            uint32_t end;            // the read position after the last base of the last hit
+            uint32_t numHits;        // the number of primer k-mer hits
+        };
 
-        mutable std::shared_mutex _mutex;
+        // binHolders are the holders a worker reuses for every read, so binning a read doesn't allocate.
+        struct binHolders
+        {
+            std::vector<uint32_t> votes;                           // the number of primer k-mer hits for each amplicon (indexed by amplicon ID)
+            std::vector<unsigned int> voted;                       // the amplicons with votes, used to reset them after each read
+            std::vector<std::pair<unsigned int, float>> amplicons; // the amplicons selected for the read, with their proportion of matching primer k-mers (or read minimizers)
+            std::vector<std::size_t> readBins;                     // the FASTQ bins the read has been written to
+            std::vector<primerHit> hits;                           // the primer k-mer hits in the read (only collected if trimming primers, capping depth or building amplitigs)
+            std::string record;                                    // the read as a FASTQ record (used for reservoir sampling)
+            std::vector<primerHit> readHits;                       // the primer k-mer hits for the whole of a read being split
+            std::vector<primerSite> sites;                         // the primer sites in a read being split
+            std::vector<primerSite> segments;                      // the amplicons found in a read being split
+            klibpp::KSeq subRead;                                  // the sub-read being binned from a split read
+            std::vector<artic::Kmer> minimizers;                   // the minimizers of a read falling back to the amplicon minimizer index
+            std::vector<uint32_t> uniqueVotes;                     // the number of minimizer hits unique to each amplicon (indexed by amplicon ID)
+            bool minimizerForward;                                 // the strand of a read binned by the minimizer fallback (true if on the reference strand)
+        };
+
+        // sampledRead is a read held in a depth cap reservoir.
+        struct sampledRead
+        {
+            uint64_t priority;  // the seeded hash of the read name, the reads with the lowest priorities are kept
+            uint32_t trimmed;   // the number of bases trimmed from the read
+            std::string record; // the read as a FASTQ record
+        };
+
+        // binCounts are the counters collected by a worker for a single batch.
+        struct binCounts
+        {
+            uint64_t reads = 0;                   // number of reads processed
+            uint64_t droppedShort = 0;            // number of reads dropped for being too short
+            uint64_t droppedLong = 0;             // number of reads dropped for being too long
+            uint64_t unbinned = 0;                // number of reads not binned
+            uint64_t multibinned = 0;             // number of reads binned to multiple amplicons
+            uint64_t fullScans = 0;               // number of reads that fell back to a full scan
+            uint64_t trimmedBases = 0;            // number of bases trimmed from FASTQ reads
+            uint64_t capped = 0;                  // number of reads not written to FASTQ due to the depth cap
+            uint64_t split = 0;                   // number of reads split into sub-reads
+            uint64_t subReads = 0;                // number of sub-reads from split reads
+            uint64_t rescued = 0;                 // number of reads binned by the minimizer fallback
+            std::vector<uint64_t> ampliconCounts; // number of reads binned to each amplicon
+            std::vector<uint64_t> ampliconBases;  // number of bases binned to each amplicon
+        };
+
+        // scanKmers_t is a _scanSeedKmers specialisation.
+        typedef void (Amplitigger::*scanKmers_t)(const std::string& seq, uint32_t start, uint32_t len, bool stopAfterPrimer, binHolders& holders);
+
+        void _run(bool watch);                                                                                                                                       // bins the reads from the input files, or from the watch directory, on the worker threads
+        void _parseReads(BoundedQueue<readBatch>& batches, BoundedQueue<readBatch>& emptyBatches);                                                                   // reads the FASTQ files and queues batches of reads
+        void _watchReads(BoundedQueue<readBatch>& batches, BoundedQueue<readBatch>& emptyBatches);                                                                   // queues batches of reads from the files written to the watch directory
+        bool _parseFile(const std::string& file, readBatch& batch, BoundedQueue<readBatch>& batches, BoundedQueue<readBatch>& emptyBatches);                         // reads a FASTQ file into batches of reads
+        unsigned int _getNumAtTarget(void) const;                                                                                                                    // gets the number of amplicons at the target depth
+        void _writeSnapshot(bool finished);                                                                                                                          // rewrites the JSON snapshot of the counts
+        void _binReads(BoundedQueue<readBatch>& batches, BoundedQueue<readBatch>& emptyBatches);                                                                     // bins batches of reads until the queue is closed
+        void _binRead(const klibpp::KSeq& read, binHolders& holders, binCounts& counts, std::string& output, std::vector<std::string>& binBuffers);                  // bins a single read
+        void _assignRead(const klibpp::KSeq& read, binHolders& holders, binCounts& counts, std::string& output, std::vector<std::string>& binBuffers);               // writes a read to its selected amplicons
+        bool _splitRead(const klibpp::KSeq& read, bool windowed, binHolders& holders, binCounts& counts, std::string& output, std::vector<std::string>& binBuffers); // splits a read into a sub-read per amplicon if it holds more than one
+        void _scanKmers(const std::string& seq, uint32_t start, uint32_t len, bool stopAfterPrimer, binHolders& holders);                                            // votes for the amplicons of read k-mers that match primer k-mers, noting where the hits are
+        template <uint32_t K>
+        void _scanSeedKmers(const std::string& seq, uint32_t start, uint32_t len, bool stopAfterPrimer, binHolders& holders);                                        // _scanKmers with the k-mer size fixed at compile time (0 for runtime)
+        bool _rescueRead(const std::string& seq, binHolders& holders);                                                                                               // bins a read by its amplicon insert minimizers
+        void _selectAmplicons(binHolders& holders);                                                                                                                  // finds the amplicons with the most votes and resets the votes
+        void _findInsert(uint32_t seqLen, const binHolders& holders, uint32_t& start, uint32_t& end) const;                                                          // gets the region of a read between the primers of its amplicons
+        bool _isForward(unsigned int ampliconID, const binHolders& holders) const;                                                                                   // gets the strand of a read from its primer k-mer hits for an amplicon
+        void _addToReservoir(std::size_t slot, sampledRead&& read);                                                                                                  // adds a read to the reservoir for an amplicon strand
+        void _writeReservoirs(void);                                                                                                                                 // writes the reservoir sampled reads to the FASTQ bins
+        void _addToGraph(unsigned int ampliconID, const klibpp::KSeq& read, const binHolders& holders);                                                              // adds a read to the graph for its amplicon, on the reference strand
+        void _buildAmplitigs(void);                                                                                                                                  // walks the amplicon graphs between their primer anchors to get the amplitigs
+        void _stitchAmplitigs(void);                                                                                                                                 // joins the amplitigs in amplicon order to get the draft genome
+        void _writeConsensus(void);                                                                                                                                  // writes the amplitigs and draft genome to FASTA
+        void _writeAbundance(void);                                                                                                                                  // writes the reads per amplicon and per pool to the output
+        void _addCounts(binCounts& counts);                                                                                                                          // adds a worker's batch counts to the totals and resets them
+        void _resetCounts(void);                                                                                                                                     // zeroes the counters, so that each run only reports its own reads
+        void _loadPrimerKmers(const std::vector<std::string>& patterns);                                                                                             // builds a primer k-mer index for each seed pattern
+        void _openFastqOutput(void);                                                                                                                                 // opens the FASTQ bin files and resets the depth caps for a run
+
+        // data holders
+        const artic::PrimerScheme* _primerScheme;                       // the loaded primer scheme
+        const std::string _refFile;                                     // the reference fasta file
+        const std::vector<std::string> _inputFiles;                     // input FASTQ files
+        std::vector<artic::SpacedSeed> _seeds;                          // the seeds used to sample k-mers (a single contiguous seed unless spaced seeds are set)
+        std::vector<artic::PrimerKmerIndex> _primerKmerIndexes;         // index of primer k-mers and their amplicons, for each seed
+        scanKmers_t _scanner;                                           // the _scanSeedKmers specialisation for the seeds (selected once when the seeds are loaded)
+        std::ostream* _output;                                          // where the read assignments (or abundance report) are written
+        std::mutex _outputMutex;                                        // guards the output
+        std::unique_ptr<FastqBinWriter> _fastqOutput;                   // the FASTQ bin files for the current run
+        hts_tpool* _decompressionPool;                                  // the thread pool decompressing BGZF input during the current run
+        std::vector<uint32_t> _primerKmerCounts;                        // the number of primer k-mers for each amplicon (indexed by amplicon ID)
+        std::vector<std::size_t> _ampliconBins;                         // the FASTQ bin for each amplicon (indexed by amplicon ID)
+        std::vector<std::string> _fastqFiles;                           // the FASTQ files written by the last run
+        std::vector<std::vector<sampledRead>> _reservoirs;              // the reservoir sampled reads for each amplicon strand (2 per amplicon ID, held as a max heap on priority)
+        std::unique_ptr<std::mutex[]> _reservoirLocks;                  // guards the reservoir for each amplicon strand
+        std::vector<std::unique_ptr<artic::AmplitigGraph>> _graphs;     // the de Bruijn graph for each amplicon during the current run (indexed by amplicon ID)
+        std::unique_ptr<std::mutex[]> _graphLocks;                      // guards the graph for each amplicon
+        std::vector<std::string> _amplitigs;                            // the amplitigs built by the last run (indexed by amplicon ID)
+        std::string _draftGenome;                                       // the draft genome built by the last run
+        std::unique_ptr<artic::AmpliconMinimizerIndex> _minimizerIndex; // index of amplicon insert minimizers, for reads that fail the primer k-mer test (nullptr if not used)
 
         // user parameters
-        // TODO: implement these as options
-        unsigned int _kmerSize; // the k-mer size to use
-        float _minPrimerKmers;  // the minimum proportion of matching primer k-mers required for amplicon assignment
-        int _minReadLength;     // drop reads shorter than this length
-        int _maxReadLength;     // drop reads longer than this length (default is to use max amplicon span in the scheme + 10%)
+        unsigned int _kmerSize;             // the k-mer size to use
+        float _minPrimerKmers;              // the minimum proportion of matching primer k-mers required for amplicon assignment
+        int _minReadLength;                 // drop reads shorter than this length
+        int _maxReadLength;                 // drop reads longer than this length (default is to use max amplicon span in the scheme + 10%)
+        unsigned int _numThreads;           // the number of binning threads
+        unsigned int _endWindow;            // the number of bases to search for primers at each read end (0 for the whole read)
+        std::string _fastqPrefix;           // the prefix for FASTQ bin files
+        BinOutput _binOutput;               // how binned reads are written to FASTQ
+        unsigned int _compressionThreads;   // the number of FASTQ compression threads
+        unsigned int _decompressionThreads; // the number of BGZF input decompression threads
+        bool _trimPrimers;                  // trim the primers from reads written to FASTQ
+        unsigned int _maxDepth;             // the maximum number of reads to write to FASTQ for each amplicon strand (0 for no cap)
+        DepthCapMode _depthCapMode;         // how reads are chosen when an amplicon strand goes over the depth cap
+        uint64_t _depthCapSeed;             // the seed for reservoir sampling
+        std::string _consensusPrefix;       // the prefix for the amplitig and draft genome FASTA files (empty if not building amplitigs)
+        unsigned int _graphKmerSize;        // the k-mer size for the amplicon graphs
+        unsigned int _minKmerCount;         // the minimum count for a graph k-mer to be walked
+        bool _splitChimeras;                // split reads holding more than one amplicon into sub-reads
+        float _minMinimizers;               // the minimum proportion of read minimizers that must hit an amplicon to bin a read by the minimizer fallback
+        bool _abundanceReport;              // write the abundance report instead of the read assignments
+        bool _collectHits;                  // collect the primer k-mer hits for each read during the current run
+        std::string _watchDir;              // the directory to watch for FASTQ files
+        std::string _snapshotFile;          // the JSON snapshot file written while watching
+        unsigned int _targetDepth;          // stop watching once every amplicon has this many reads (0 to only use the idle timeout)
+        unsigned int _idleTimeout;          // stop watching if no new files arrive for this many seconds (0 to only use the target depth)
+        unsigned int _snapshotInterval;     // the number of seconds between snapshots while watching
 
         // counters
-        unsigned int _readCounter;     // number of reads processed by the softmasker
-        unsigned int _droppedLong;     // number of reads which were deemed too long and dropped prior to binning
-        unsigned int _droppedShort;    // number of reads which were deemed too short and dropped prior to binning
-        unsigned int _droppedUnbinned; // number of reads which did not get binned to an amplicon in the scheme
-        unsigned int _multibinned;     // number of reads which were binned into multiple amplicons
+        std::atomic<uint64_t> _readCounter;                       // number of reads processed by the amplitigger
+        std::atomic<uint64_t> _droppedLong;                       // number of reads which were deemed too long and dropped prior to binning
+        std::atomic<uint64_t> _droppedShort;                      // number of reads which were deemed too short and dropped prior to binning
+        std::atomic<uint64_t> _droppedUnbinned;                   // number of reads which did not get binned to an amplicon in the scheme
+        std::atomic<uint64_t> _multibinned;                       // number of reads which were binned into multiple amplicons
+        std::atomic<uint64_t> _fullScans;                         // number of reads where the end windows didn't find an amplicon, so the whole read was scanned
+        std::atomic<uint64_t> _trimmedBases;                      // number of bases trimmed from the reads written to FASTQ
+        std::atomic<uint64_t> _capped;                            // number of binned reads not written to FASTQ due to the depth cap
+        std::atomic<uint64_t> _split;                             // number of reads split into sub-reads
+        std::atomic<uint64_t> _subReads;                          // number of sub-reads from split reads
+        std::atomic<uint64_t> _rescued;                           // number of reads that failed the primer k-mer test but were binned by the minimizer fallback
+        uint64_t _numFiles;                                       // number of FASTQ files read (only updated by the parser)
+        std::unique_ptr<std::atomic<uint64_t>[]> _ampliconCounts; // number of reads binned to each amplicon (indexed by amplicon ID)
+        std::unique_ptr<std::atomic<uint64_t>[]> _ampliconBases;  // number of bases binned to each amplicon (indexed by amplicon ID)
+        std::unique_ptr<std::atomic<uint64_t>[]> _strandCounts;   // number of reads binned to each amplicon strand during the current run (2 per amplicon ID)
     };
 
 } // namespace artic
 
-#endif
\ No newline at end of file
+#endif
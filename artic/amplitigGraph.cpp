@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "amplitigGraph.hpp"
+
+// AMPLITIG_GRAPH_MIN_SLOTS is the starting size of the k-mer table (must be a power of 2).
+const std::size_t AMPLITIG_GRAPH_MIN_SLOTS = 1024;
+
+// AmplitigGraph constructor.
+artic::AmplitigGraph::AmplitigGraph(uint32_t kSize)
+    : _kSize(kSize), _numReads(0), _numKmers(0)
+{
+    if (_kSize == 0 || _kSize > MAX_K_SIZE)
+        throw std::runtime_error("k-mer size must be > 0 and <= " + std::to_string(MAX_K_SIZE));
+    _kmerMask = (_kSize == MAX_K_SIZE) ? ~0ULL : (1ULL << (2 * _kSize)) - 1;
+    _kmers.assign(AMPLITIG_GRAPH_MIN_SLOTS, 0);
+    _counts.assign(AMPLITIG_GRAPH_MIN_SLOTS, 0);
+}
+
+// GetKmerSize returns the k-mer size used by the graph.
+uint32_t artic::AmplitigGraph::GetKmerSize(void) const { return _kSize; }
+
+// GetNumKmers returns the number of distinct k-mers in the graph.
+std::size_t artic::AmplitigGraph::GetNumKmers(void) const { return _numKmers; }
+
+// GetNumReads returns the number of reads added to the graph.
+uint32_t artic::AmplitigGraph::GetNumReads(void) const { return _numReads; }
+
+// GetCount returns the number of times a k-mer (on the reference strand) has been added to the graph.
+uint32_t artic::AmplitigGraph::GetCount(kmer_t kmer) const { return _counts[_find(kmer)]; }
+
+// AddRead will add the k-mers of a read to the graph, reverse complementing them if the read is from the reverse strand.
+void artic::AmplitigGraph::AddRead(const char* seq, uint32_t len, bool reverse)
+{
+    // roll the k-mer on both strands, starting again after any non-ACGT base
+    uint64_t bitShift = 2 * (_kSize - 1);
+    kmer_t fwd = 0;
+    kmer_t rc = 0;
+    uint32_t l = 0;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        uint8_t base = nt2char[uint8_t(seq[i])];
+        if (base > 3)
+        {
+            l = 0;
+            continue;
+        }
+        fwd = ((fwd << 2) | base) & _kmerMask;
+        rc = (rc >> 2) | (uint64_t(3 - base) << bitShift);
+        if (++l >= _kSize)
+            _add((reverse) ? rc : fwd);
+    }
+    _numReads++;
+}
+
+// GetAmplitig will find the heaviest path of solid k-mers between two anchor k-mers, returning false if the end anchor isn't reached within the max. length.
+bool artic::AmplitigGraph::GetAmplitig(const std::string& startAnchor, const std::string& endAnchor, uint32_t minCount, uint32_t maxLen, std::string& amplitig) const
+{
+    auto start = _encode(startAnchor);
+    auto end = _encode(endAnchor);
+    amplitig = startAnchor;
+    if (start == end)
+        return true;
+    if (maxLen <= _kSize)
+        return false;
+    uint32_t maxSteps = maxLen - _kSize;
+
+    // successors gets the solid successors of a k-mer that are in the subgraph
+    std::unordered_map<kmer_t, uint32_t> nodeIDs;
+    std::vector<kmer_t> nodes;
+    auto successors = [&](kmer_t kmer, bool addNodes, std::vector<uint32_t>& succs) {
+        succs.clear();
+        for (kmer_t base = 0; base < 4; base++)
+        {
+            auto successor = ((kmer << 2) | base) & _kmerMask;
+            auto it = nodeIDs.find(successor);
+            if (it != nodeIDs.end())
+                succs.push_back(it->second);
+            else if (addNodes && GetCount(successor) >= minCount)
+            {
+                nodeIDs.emplace(successor, nodes.size());
+                succs.push_back(nodes.size());
+                nodes.push_back(successor);
+            }
+        }
+    };
+
+    // collect the subgraph of solid k-mers within the max. length of the start anchor (breadth first, the end anchor isn't extended)
+    // the start anchor is used even if it isn't solid, as the primer may be mismatched in the reads
+    nodeIDs.emplace(start, 0);
+    nodes.push_back(start);
+    std::vector<uint32_t> succs;
+    std::size_t layerEnd = 1;
+    for (uint32_t step = 0, i = 0; step < maxSteps && i < layerEnd; step++)
+    {
+        for (; i < layerEnd; i++)
+            if (nodes[i] != end)
+                successors(nodes[i], true, succs);
+        layerEnd = nodes.size();
+    }
+    if (nodeIDs.find(end) == nodeIDs.end())
+        return false;
+
+    // order the subgraph depth first (reverse post order), so that any edge running backwards in the order closes a cycle
+    std::vector<std::vector<uint32_t>> edges(nodes.size());
+    for (uint32_t i = 0; i < nodes.size(); i++)
+        if (nodes[i] != end)
+            successors(nodes[i], false, edges[i]);
+    std::vector<uint32_t> order;
+    order.reserve(nodes.size());
+    std::vector<uint8_t> seen(nodes.size(), 0);
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, 0}};
+    seen[0] = 1;
+    while (!stack.empty())
+    {
+        auto& top = stack.back();
+        if (top.second < edges[top.first].size())
+        {
+            auto next = edges[top.first][top.second++];
+            if (!seen[next])
+            {
+                seen[next] = 1;
+                stack.emplace_back(next, 0);
+            }
+            continue;
+        }
+        order.push_back(top.first);
+        stack.pop_back();
+    }
+    std::reverse(order.begin(), order.end());
+    std::vector<uint32_t> rank(nodes.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+        rank[order[i]] = i;
+
+    // the heaviest path is then found over the forward edges (dropping the cycles), weighting each k-mer by its count
+    std::vector<uint64_t> weights(nodes.size(), 0);
+    std::vector<uint32_t> steps(nodes.size(), 0);
+    std::vector<uint32_t> preds(nodes.size(), 0);
+    std::vector<uint8_t> reached(nodes.size(), 0);
+    reached[0] = 1;
+    for (auto node : order)
+    {
+        if (!reached[node])
+            continue;
+        for (auto next : edges[node])
+        {
+            auto weight = weights[node] + GetCount(nodes[next]);
+            if (rank[next] > rank[node] && (!reached[next] || weight > weights[next]))
+            {
+                reached[next] = 1;
+                weights[next] = weight;
+                steps[next] = steps[node] + 1;
+                preds[next] = node;
+            }
+        }
+    }
+    auto endID = nodeIDs[end];
+    if (!reached[endID] || steps[endID] > maxSteps)
+        return false;
+
+    // trace back from the end anchor, adding the last base of each k-mer
+    amplitig.resize(_kSize + steps[endID]);
+    for (auto node = endID, pos = uint32_t(amplitig.size()); node != 0; node = preds[node])
+        amplitig[--pos] = char2nt[nodes[node] & 3];
+    return true;
+}
+
+// _find gets the table slot for a k-mer (either holding the k-mer or empty).
+std::size_t artic::AmplitigGraph::_find(kmer_t kmer) const
+{
+    std::size_t mask = _kmers.size() - 1;
+    std::size_t slot = HashKmer(kmer, _kSize) & mask;
+    while (_counts[slot] != 0 && _kmers[slot] != kmer)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+// _add adds a k-mer to the table, growing it if needed.
+void artic::AmplitigGraph::_add(kmer_t kmer)
+{
+    auto slot = _find(kmer);
+    if (_counts[slot] != 0)
+    {
+        _counts[slot]++;
+        return;
+    }
+    _kmers[slot] = kmer;
+    _counts[slot] = 1;
+    _numKmers++;
+
+    // keep the table at most half full, so probes stay short
+    if (_numKmers * 2 <= _kmers.size())
+        return;
+    std::vector<kmer_t> kmers(_kmers.size() * 2, 0);
+    std::vector<uint32_t> counts(_counts.size() * 2, 0);
+    std::swap(kmers, _kmers);
+    std::swap(counts, _counts);
+    for (std::size_t i = 0; i < kmers.size(); i++)
+    {
+        if (counts[i] == 0)
+            continue;
+        auto newSlot = _find(kmers[i]);
+        _kmers[newSlot] = kmers[i];
+        _counts[newSlot] = counts[i];
+    }
+}
+
+// _encode encodes an anchor k-mer.
+artic::kmer_t artic::AmplitigGraph::_encode(const std::string& anchor) const
+{
+    if (anchor.size() != _kSize)
+        throw std::runtime_error("anchor k-mer must be the same size as the graph k-mers (" + std::to_string(_kSize) + "): " + anchor);
+    kmer_t kmer = 0;
+    for (auto c : anchor)
+    {
+        uint8_t base = nt2char[uint8_t(c)];
+        if (base > 3)
+            throw std::runtime_error("anchor k-mer can only contain ACGT: " + anchor);
+        kmer = (kmer << 2) | base;
+    }
+    return kmer;
+}
@@ -0,0 +1,63 @@
+#ifndef AMPLITIGGRAPH_H
+#define AMPLITIGGRAPH_H
+
+#include <string>
+#include <vector>
+
+#include "kmers.hpp"
+
+namespace artic
+{
+    //******************************************************************************
+    // AmplitigGraph is a de Bruijn graph of the reads from a single amplicon, used to build an amplitig.
+    //
+    // NOTES:
+    // * k-mers are counted in a flat open addressing table (parallel arrays of k-mers and counts)
+    // * k-mers are held on the reference strand, so reads from the reverse strand are reverse complemented as they are added
+    // * edges are implicit, the successors of a k-mer are found by looking up its 4 possible extensions
+    // * only solid k-mers (count >= the min. count) are walked, which drops most of the sequencing errors
+    // * the amplitig is the heaviest path (summed k-mer counts) between two anchor k-mers, found over the solid k-mers within the max. length
+    //   of the start anchor by ordering them depth first and keeping the best path to each k-mer, so bubbles and dead ends are resolved
+    // * edges that close a cycle are dropped, so a k-mer can't be used twice in an amplitig (repeats longer than k can't be walked)
+    // * the graph is not thread safe, callers must guard AddRead
+    //******************************************************************************
+    class AmplitigGraph
+    {
+    public:
+        // AmplitigGraph constructor.
+        AmplitigGraph(uint32_t kSize);
+
+        // GetKmerSize returns the k-mer size used by the graph.
+        uint32_t GetKmerSize(void) const;
+
+        // GetNumKmers returns the number of distinct k-mers in the graph.
+        std::size_t GetNumKmers(void) const;
+
+        // GetNumReads returns the number of reads added to the graph.
+        uint32_t GetNumReads(void) const;
+
+        // GetCount returns the number of times a k-mer (on the reference strand) has been added to the graph.
+        uint32_t GetCount(kmer_t kmer) const;
+
+        // AddRead will add the k-mers of a read to the graph, reverse complementing them if the read is from the reverse strand.
+        void AddRead(const char* seq, uint32_t len, bool reverse);
+
+        // GetAmplitig will find the heaviest path of solid k-mers between two anchor k-mers, returning false if the end anchor isn't reached within the max. length.
+        bool GetAmplitig(const std::string& startAnchor, const std::string& endAnchor, uint32_t minCount, uint32_t maxLen, std::string& amplitig) const;
+
+    private:
+        std::size_t _find(kmer_t kmer) const;            // gets the table slot for a k-mer (either holding the k-mer or empty)
+        void _add(kmer_t kmer);                          // adds a k-mer to the table, growing it if needed
+        kmer_t _encode(const std::string& anchor) const; // encodes an anchor k-mer
+
+        uint32_t _kSize;               // the k-mer size
+        kmer_t _kmerMask;              // mask to drop the oldest base from a k-mer
+        uint32_t _numReads;            // the number of reads added to the graph
+        std::size_t _numKmers;         // the number of distinct k-mers in the table
+        std::vector<kmer_t> _kmers;    // the k-mer in each table slot
+        std::vector<uint32_t> _counts; // the count for each table slot (0 for an empty slot)
+    };
+
+} // namespace artic
+
+#endif
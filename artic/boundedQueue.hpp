@@ -0,0 +1,92 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace artic
+{
+    //******************************************************************************
+    // BoundedQueue is a blocking FIFO queue for passing work between threads.
+    //
+    // NOTES:
+    // * Push blocks while the queue is full, Pop blocks while it is empty
+    // * once closed, Push will fail and Pop will drain the remaining items before failing
+    // * items should be batches of work, as every call takes the lock
+    //******************************************************************************
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        // BoundedQueue constructor.
+        BoundedQueue(std::size_t capacity)
+            : _capacity(capacity), _closed(false)
+        {
+            if (_capacity == 0)
+                _capacity = 1;
+        }
+
+        // Push will add an item to the back of the queue, waiting for space if needed (returns false if the queue is closed).
+        bool Push(T&& item)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notFull.wait(lock, [this] { return _closed || _items.size() < _capacity; });
+            if (_closed)
+                return false;
+            _items.emplace_back(std::move(item));
+            lock.unlock();
+            _notEmpty.notify_one();
+            return true;
+        }
+
+        // Pop will remove an item from the front of the queue, waiting for one if needed (returns false once the queue is closed and empty).
+        bool Pop(T& item)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notEmpty.wait(lock, [this] { return _closed || !_items.empty(); });
+            if (_items.empty())
+                return false;
+            item = std::move(_items.front());
+            _items.pop_front();
+            lock.unlock();
+            _notFull.notify_one();
+            return true;
+        }
+
+        // TryPop will remove an item from the front of the queue if there is one, without waiting.
+        bool TryPop(T& item)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_items.empty())
+                return false;
+            item = std::move(_items.front());
+            _items.pop_front();
+            lock.unlock();
+            _notFull.notify_one();
+            return true;
+        }
+
+        // Close will stop any more items being added and wake all waiting threads.
+        void Close(void)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _closed = true;
+            }
+            _notFull.notify_all();
+            _notEmpty.notify_all();
+        }
+
+    private:
+        std::mutex _mutex;                 // guards the queue
+        std::condition_variable _notFull;  // signals when there is space in the queue
+        std::condition_variable _notEmpty; // signals when there are items in the queue
+        std::deque<T> _items;              // the queued items
+        std::size_t _capacity;             // the maximum number of queued items
+        bool _closed;                      // true once no more items will be added
+    };
+
+} // namespace artic
+
+#endif
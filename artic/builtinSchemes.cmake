@@ -0,0 +1,103 @@
+######################################################################
+# generate the builtin primer scheme tables
+#
+# ARTIC_BUILTIN_SCHEMES is a list of name=file pairs, where file is an
+# ARTIC primer scheme BED. Each scheme is checked here (columns, primer
+# coordinates, primer tags and LEFT/RIGHT pairing) and then written to
+# artic/builtinSchemes.hpp as constexpr rows.
+#
+# NOTE: only reading and parsing the BED is skipped at runtime, the
+# Amplicon objects are still paired and validated by the PrimerScheme
+# constructor when a builtin scheme is loaded
+######################################################################
+set(ARTIC_BUILTIN_SCHEME_TABLES "")
+set(ARTIC_BUILTIN_SCHEME_ENTRIES "")
+set(ARTIC_BUILTIN_SCHEME_COUNT 0)
+
+if(BUILD_BUILTIN_SCHEMES)
+  foreach(scheme ${ARTIC_BUILTIN_SCHEMES})
+
+    # split the name=file pair
+    string(FIND "${scheme}" "=" splitPos)
+    if(splitPos EQUAL -1)
+      message(FATAL_ERROR "builtin scheme must be given as name=file: ${scheme}")
+    endif()
+    string(SUBSTRING "${scheme}" 0 ${splitPos} schemeName)
+    math(EXPR splitPos "${splitPos} + 1")
+    string(SUBSTRING "${scheme}" ${splitPos} -1 schemeFile)
+    if(NOT EXISTS ${schemeFile})
+      message(FATAL_ERROR "builtin scheme file does not exist: ${schemeFile}")
+    endif()
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${schemeFile})
+
+    # convert each BED row into a primer entry
+    string(MAKE_C_IDENTIFIER "BUILTIN_${schemeName}" schemeVar)
+    string(TOUPPER ${schemeVar} schemeVar)
+    file(STRINGS ${schemeFile} schemeRows)
+    set(schemeBody "")
+    set(numPrimers 0)
+    set(leftPrimers "")
+    set(rightPrimers "")
+    foreach(row ${schemeRows})
+      string(STRIP "${row}" row)
+      if(row STREQUAL "" OR row MATCHES "^#")
+        continue()
+      endif()
+      string(REPLACE "\t" ";" fields "${row}")
+      list(LENGTH fields numFields)
+      if(numFields LESS 5)
+        message(FATAL_ERROR "less than 5 columns in builtin scheme ${schemeName} - check it's in ARTIC format")
+      endif()
+      list(GET fields 0 refID)
+      list(GET fields 1 primerStart)
+      list(GET fields 2 primerEnd)
+      list(GET fields 3 primerID)
+      list(GET fields 4 primerPool)
+      if(NOT primerStart MATCHES "^[0-9]+$" OR NOT primerEnd MATCHES "^[0-9]+$" OR NOT primerStart LESS primerEnd)
+        message(FATAL_ERROR "invalid primer start/end in builtin scheme ${schemeName} for primerID: ${primerID}")
+      endif()
+
+      # collect the amplicon each primer belongs to (dropping any alt tag) so the pairs can be checked
+      if(primerID MATCHES "^(.+)_LEFT(_alt.*)?$")
+        list(APPEND leftPrimers ${CMAKE_MATCH_1})
+      elseif(primerID MATCHES "^(.+)_RIGHT(_alt.*)?$")
+        list(APPEND rightPrimers ${CMAKE_MATCH_1})
+      else()
+        message(FATAL_ERROR "invalid primer ID in builtin scheme ${schemeName} doesn't contain LEFT/RIGHT: ${primerID}")
+      endif()
+      string(APPEND schemeBody "\n            {\"${refID}\", ${primerStart}, ${primerEnd}, \"${primerID}\", \"${primerPool}\"},")
+      math(EXPR numPrimers "${numPrimers} + 1")
+    endforeach()
+    if(numPrimers EQUAL 0)
+      message(FATAL_ERROR "no primers found in builtin scheme ${schemeName}")
+    endif()
+
+    # every amplicon needs a LEFT and a RIGHT primer
+    list(REMOVE_DUPLICATES leftPrimers)
+    list(REMOVE_DUPLICATES rightPrimers)
+    foreach(amplicon ${leftPrimers})
+      list(FIND rightPrimers ${amplicon} pairPos)
+      if(pairPos EQUAL -1)
+        message(FATAL_ERROR "no RIGHT primer for ${amplicon}_LEFT in builtin scheme ${schemeName}")
+      endif()
+    endforeach()
+    foreach(amplicon ${rightPrimers})
+      list(FIND leftPrimers ${amplicon} pairPos)
+      if(pairPos EQUAL -1)
+        message(FATAL_ERROR "no LEFT primer for ${amplicon}_RIGHT in builtin scheme ${schemeName}")
+      endif()
+    endforeach()
+
+    # add the table and its lookup entry
+    string(APPEND ARTIC_BUILTIN_SCHEME_TABLES "    // ${schemeVar} was generated from ${schemeName} (${numPrimers} primers).\n")
+    string(APPEND ARTIC_BUILTIN_SCHEME_TABLES "    inline constexpr BuiltinPrimer ${schemeVar}[${numPrimers}] =\n        {${schemeBody}\n    };\n\n")
+    string(APPEND ARTIC_BUILTIN_SCHEME_ENTRIES "\n            {\"${schemeName}\", ${schemeVar}, ${numPrimers}},")
+    math(EXPR ARTIC_BUILTIN_SCHEME_COUNT "${ARTIC_BUILTIN_SCHEME_COUNT} + 1")
+    message(STATUS "embedding builtin scheme: ${schemeName} (${numPrimers} primers)")
+  endforeach()
+endif()
+
+configure_file (
+    "${PROJECT_SOURCE_DIR}/artic/builtinSchemes.hpp.in"
+    "${PROJECT_SOURCE_DIR}/artic/builtinSchemes.hpp"
+)
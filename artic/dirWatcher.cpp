@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "dirWatcher.hpp"
+
+// INOTIFY_BUFFER_SIZE is the number of bytes to read from inotify in one go (enough for a few hundred events).
+const std::size_t INOTIFY_BUFFER_SIZE = 1 << 16;
+
+// DirWatcher constructor.
+artic::DirWatcher::DirWatcher(const std::string& dir)
+    : _dir(dir), _inotifyFD(-1), _started(false)
+{
+    if (!boost::filesystem::is_directory(_dir))
+        throw std::runtime_error("watch directory does not exist:\t" + _dir);
+
+    // use inotify if it's available, falling back to polling if the watch can't be set (e.g. the user watch limit has been hit)
+#ifdef __linux__
+    _inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotifyFD >= 0 && inotify_add_watch(_inotifyFD, _dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        close(_inotifyFD);
+        _inotifyFD = -1;
+    }
+#endif
+}
+
+// DirWatcher destructor.
+artic::DirWatcher::~DirWatcher(void)
+{
+#ifdef __linux__
+    if (_inotifyFD >= 0)
+        close(_inotifyFD);
+#endif
+}
+
+// GetDir returns the directory being watched.
+const std::string& artic::DirWatcher::GetDir(void) const { return _dir; }
+
+// UsingInotify returns true if the directory is watched with inotify, false if it is polled.
+bool artic::DirWatcher::UsingInotify(void) const { return _inotifyFD >= 0; }
+
+// GetNumFiles returns the number of files returned so far.
+std::size_t artic::DirWatcher::GetNumFiles(void) const { return _returned.size(); }
+
+// GetNewFiles will wait up to the timeout (in milliseconds) for new files, returning the paths of any found in name order.
+void artic::DirWatcher::GetNewFiles(unsigned int timeout, std::vector<std::string>& files)
+{
+    // the first call returns the files already in the directory without waiting
+    files.clear();
+    std::vector<std::string> fileNames;
+    if (!_started)
+    {
+        _scanDir(fileNames);
+        _started = true;
+    }
+    else if (_inotifyFD >= 0)
+        _readEvents(timeout, fileNames);
+    else
+        _pollDir(timeout, fileNames);
+
+    // a file can be reported more than once (e.g. if it's rewritten), but is only returned the first time
+    std::sort(fileNames.begin(), fileNames.end());
+    for (const auto& fileName : fileNames)
+        if (_isFastq(fileName) && _returned.insert(fileName).second)
+            files.emplace_back((boost::filesystem::path(_dir) / fileName).string());
+}
+
+// _isFastq checks a file name has a FASTQ extension.
+bool artic::DirWatcher::_isFastq(const std::string& fileName) const
+{
+    for (const auto& extension : DIRWATCHER_EXTENSIONS)
+        if (fileName.size() > extension.size() && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0)
+            return true;
+    return false;
+}
+
+// _scanDir lists the FASTQ files in the directory.
+void artic::DirWatcher::_scanDir(std::vector<std::string>& fileNames) const
+{
+    for (const auto& entry : boost::filesystem::directory_iterator(_dir))
+        if (boost::filesystem::is_regular_file(entry.status()) && _isFastq(entry.path().filename().string()))
+            fileNames.emplace_back(entry.path().filename().string());
+}
+
+// _readEvents waits for inotify events, listing the files that were closed after writing or moved into the directory.
+void artic::DirWatcher::_readEvents(unsigned int timeout, std::vector<std::string>& fileNames)
+{
+#ifdef __linux__
+    struct pollfd pfd = {_inotifyFD, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeout);
+    if (ready < 0 && errno != EINTR)
+        throw std::runtime_error("could not wait for files in watch directory:\t" + _dir);
+    if (ready <= 0)
+        return;
+
+    // drain the events, rescanning the directory if inotify dropped some
+    alignas(struct inotify_event) char buffer[INOTIFY_BUFFER_SIZE];
+    while (true)
+    {
+        ssize_t len = read(_inotifyFD, buffer, sizeof(buffer));
+        if (len < 0 && (errno == EAGAIN || errno == EINTR))
+            return;
+        if (len <= 0)
+            throw std::runtime_error("could not read events for watch directory:\t" + _dir);
+        const struct inotify_event* event;
+        for (char* ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + event->len)
+        {
+            event = reinterpret_cast<const struct inotify_event*>(ptr);
+            if (event->mask & IN_Q_OVERFLOW)
+                _scanDir(fileNames);
+            else if (event->len != 0 && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)))
+                fileNames.emplace_back(event->name);
+        }
+    }
+#else
+    (void)timeout;
+    (void)fileNames;
+#endif
+}
+
+// _pollDir waits for the timeout and then lists the new files that are the same size as at the last poll.
+void artic::DirWatcher::_pollDir(unsigned int timeout, std::vector<std::string>& fileNames)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+    std::vector<std::string> current;
+    _scanDir(current);
+    for (const auto& fileName : current)
+    {
+        if (_returned.count(fileName))
+            continue;
+        boost::system::error_code error;
+        auto size = boost::filesystem::file_size(boost::filesystem::path(_dir) / fileName, error);
+        if (error)
+            continue;
+        auto previous = _sizes.find(fileName);
+        if (previous != _sizes.end() && previous->second == size)
+        {
+            fileNames.emplace_back(fileName);
+            _sizes.erase(previous);
+        }
+        else
+            _sizes[fileName] = size;
+    }
+}
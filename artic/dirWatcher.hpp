@@ -0,0 +1,64 @@
+#ifndef DIRWATCHER_H
+#define DIRWATCHER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace artic
+{
+    // DIRWATCHER_EXTENSIONS are the file extensions of the FASTQ files picked up by a DirWatcher.
+    const std::vector<std::string> DIRWATCHER_EXTENSIONS = {".fastq", ".fq", ".fastq.gz", ".fq.gz"};
+
+    //******************************************************************************
+    // DirWatcher reports the FASTQ files that are written to a directory, returning each file once.
+    //
+    // NOTES:
+    // * on Linux it uses inotify, so a new file is only returned once it has been closed after writing (or moved into the directory)
+    // * elsewhere it polls the directory, and a new file is only returned once its size is the same on two consecutive polls
+    // * files already in the directory when the watcher starts are assumed to be complete and are returned on the first call
+    // * the directory is not watched recursively
+    //******************************************************************************
+    class DirWatcher
+    {
+    public:
+        // DirWatcher constructor.
+        DirWatcher(const std::string& dir);
+
+        // DirWatcher destructor.
+        ~DirWatcher(void);
+
+        // DirWatcher is not copyable, as it owns the inotify descriptor.
+        DirWatcher(const DirWatcher&) = delete;
+        DirWatcher& operator=(const DirWatcher&) = delete;
+
+        // GetDir returns the directory being watched.
+        const std::string& GetDir(void) const;
+
+        // UsingInotify returns true if the directory is watched with inotify, false if it is polled.
+        bool UsingInotify(void) const;
+
+        // GetNumFiles returns the number of files returned so far.
+        std::size_t GetNumFiles(void) const;
+
+        // GetNewFiles will wait up to the timeout (in milliseconds) for new files, returning the paths of any found in name order.
+        void GetNewFiles(unsigned int timeout, std::vector<std::string>& files);
+
+    private:
+        bool _isFastq(const std::string& fileName) const;                            // checks a file name has a FASTQ extension
+        void _scanDir(std::vector<std::string>& fileNames) const;                    // lists the FASTQ files in the directory
+        void _readEvents(unsigned int timeout, std::vector<std::string>& fileNames); // waits for inotify events, listing the files closed after writing or moved in
+        void _pollDir(unsigned int timeout, std::vector<std::string>& fileNames);    // waits and then lists the new files that have stopped growing
+
+        std::string _dir;                                  // the directory being watched
+        int _inotifyFD;                                    // the inotify descriptor (-1 if polling)
+        bool _started;                                     // true once the files already in the directory have been returned
+        std::unordered_set<std::string> _returned;         // the names of the files returned so far
+        std::unordered_map<std::string, uintmax_t> _sizes; // the size of each new file at the last poll
+    };
+
+} // namespace artic
+
+#endif
@@ -0,0 +1,108 @@
+#include <stdexcept>
+
+#include "fastqBinWriter.hpp"
+
+// FastqBinWriter constructor.
+artic::FastqBinWriter::FastqBinWriter(const std::string& prefix, const std::vector<std::string>& binNames, unsigned int numThreads)
+    : _threadPool(nullptr)
+{
+    if (binNames.empty())
+        throw std::runtime_error("no bins provided for FASTQ output");
+    if (numThreads == 0)
+        throw std::runtime_error("number of compression threads must be > 0");
+    _threadPool = hts_tpool_init(numThreads);
+    if (!_threadPool)
+        throw std::runtime_error("could not start compression thread pool");
+
+    // open a file for each bin and attach it to the thread pool
+    _binLocks.reset(new std::mutex[binNames.size()]);
+    for (const auto& binName : binNames)
+    {
+        _fileNames.emplace_back(prefix + "." + binName + ".fastq.gz");
+        BGZF* file = bgzf_open(_fileNames.back().c_str(), "w");
+        if (!file || bgzf_thread_pool(file, _threadPool, 0) != 0)
+        {
+            if (file)
+                bgzf_close(file);
+            Close();
+            throw std::runtime_error("could not open FASTQ file for writing: " + _fileNames.back());
+        }
+        _files.emplace_back(file);
+    }
+}
+
+// FastqBinWriter destructor.
+artic::FastqBinWriter::~FastqBinWriter(void)
+{
+    try
+    {
+        Close();
+    }
+    catch (...)
+    {
+    }
+}
+
+// GetNumBins returns the number of bins being written.
+std::size_t artic::FastqBinWriter::GetNumBins(void) const { return _fileNames.size(); }
+
+// GetFileName returns the output file name for a bin.
+const std::string& artic::FastqBinWriter::GetFileName(std::size_t binID) const
+{
+    if (binID >= _fileNames.size())
+        throw std::runtime_error("bin ID out of range: " + std::to_string(binID));
+    return _fileNames[binID];
+}
+
+// Write will write a chunk of FASTQ records to a bin.
+void artic::FastqBinWriter::Write(std::size_t binID, const std::string& records)
+{
+    if (binID >= _files.size())
+        throw std::runtime_error("bin ID out of range: " + std::to_string(binID));
+    std::lock_guard<std::mutex> lock(_binLocks[binID]);
+    if (!_files[binID])
+        throw std::runtime_error("FASTQ file has been closed: " + _fileNames[binID]);
+    if (bgzf_write(_files[binID], records.data(), records.size()) < 0)
+        throw std::runtime_error("could not write to FASTQ file: " + _fileNames[binID]);
+}
+
+// Close will flush and close all the bin files, it is called by the destructor if needed.
+void artic::FastqBinWriter::Close(void)
+{
+    // close every file before the thread pool, even if one of them fails
+    std::string failed;
+    for (std::size_t i = 0; i < _files.size(); i++)
+    {
+        std::lock_guard<std::mutex> lock(_binLocks[i]);
+        if (_files[i] && bgzf_close(_files[i]) != 0 && failed.empty())
+            failed = _fileNames[i];
+        _files[i] = nullptr;
+    }
+    if (_threadPool)
+    {
+        hts_tpool_destroy(_threadPool);
+        _threadPool = nullptr;
+    }
+    if (!failed.empty())
+        throw std::runtime_error("could not close FASTQ file: " + failed);
+}
+
+// AppendFastqRecord will add a read to a string as a FASTQ record (or FASTA if the read has no qualities).
+void artic::AppendFastqRecord(const klibpp::KSeq& read, std::string& records)
+{
+    artic::AppendFastqRecord(read, 0, read.seq.size(), records);
+}
+
+// AppendFastqRecord will add part of a read to a string as a FASTQ record (from start up to, but not including, end).
+void artic::AppendFastqRecord(const klibpp::KSeq& read, std::size_t start, std::size_t end, std::string& records)
+{
+    if (start > end || end > read.seq.size())
+        throw std::runtime_error("invalid read region for FASTQ record: " + read.name);
+    bool fastq = read.qual.size() == read.seq.size();
+    records.append(fastq ? "@" : ">").append(read.name);
+    if (!read.comment.empty())
+        records.append(" ").append(read.comment);
+    records.append("\n").append(read.seq, start, end - start).append("\n");
+    if (fastq)
+        records.append("+\n").append(read.qual, start, end - start).append("\n");
+}
@@ -0,0 +1,62 @@
+#ifndef FASTQBINWRITER_H
+#define FASTQBINWRITER_H
+
+#include <htslib/bgzf.h>
+#include <htslib/thread_pool.h>
+#include <kseq++/seqio.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace artic
+{
+    //******************************************************************************
+    // FastqBinWriter writes reads to a set of BGZF compressed FASTQ files, one per bin.
+    //
+    // NOTES:
+    // * files are named <prefix>.<bin name>.fastq.gz and can be read with any gzip reader
+    // * all files share one htslib thread pool, which compresses the blocks in the background
+    // * each bin has its own lock, so threads writing to different bins don't wait on each other
+    // * callers should buffer their records and write them in chunks, as every write takes a lock
+    //******************************************************************************
+    class FastqBinWriter
+    {
+    public:
+        // FastqBinWriter constructor.
+        FastqBinWriter(const std::string& prefix, const std::vector<std::string>& binNames, unsigned int numThreads);
+
+        // FastqBinWriter destructor.
+        ~FastqBinWriter(void);
+
+        FastqBinWriter(const FastqBinWriter&) = delete;
+        FastqBinWriter& operator=(const FastqBinWriter&) = delete;
+
+        // GetNumBins returns the number of bins being written.
+        std::size_t GetNumBins(void) const;
+
+        // GetFileName returns the output file name for a bin.
+        const std::string& GetFileName(std::size_t binID) const;
+
+        // Write will write a chunk of FASTQ records to a bin.
+        void Write(std::size_t binID, const std::string& records);
+
+        // Close will flush and close all the bin files, it is called by the destructor if needed.
+        void Close(void);
+
+    private:
+        std::vector<std::string> _fileNames;     // the output file for each bin
+        std::vector<BGZF*> _files;               // the open file handle for each bin
+        std::unique_ptr<std::mutex[]> _binLocks; // guards the file handle for each bin
+        hts_tpool* _threadPool;                  // the compression thread pool shared by all the bins
+    };
+
+    // AppendFastqRecord will add a read to a string as a FASTQ record (or FASTA if the read has no qualities).
+    void AppendFastqRecord(const klibpp::KSeq& read, std::string& records);
+
+    // AppendFastqRecord will add part of a read to a string as a FASTQ record (from start up to, but not including, end).
+    void AppendFastqRecord(const klibpp::KSeq& read, std::size_t start, std::size_t end, std::string& records);
+
+} // namespace artic
+
+#endif
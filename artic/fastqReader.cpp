@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "fastqReader.hpp"
+
+// FASTQREADER_GZ_BUFFER is the size of the zlib input buffer used by the inflate thread.
+const unsigned int FASTQREADER_GZ_BUFFER = 1 << 17;
+
+// FastqReader constructor.
+artic::FastqReader::FastqReader(const std::string& fileName, hts_tpool* threadPool)
+    : _fileName(fileName), _bgzf(nullptr), _gzFile(nullptr), _chunks(FASTQREADER_CHUNKS), _emptyChunks(FASTQREADER_CHUNKS + 2), _chunkPos(0), _failed(false), _numBytes(0), _stream(klibpp::make_kstream(this, &artic::FastqReader::_fill, klibpp::mode::in))
+{
+    // BGZF files are handed to the thread pool, which decompresses blocks ahead of the parser
+    _bgzf = bgzf_open(_fileName.c_str(), "r");
+    if (!_bgzf)
+        throw std::runtime_error("could not open FASTQ file: " + _fileName);
+    if (bgzf_compression(_bgzf) == bgzf)
+    {
+        if (threadPool && bgzf_thread_pool(_bgzf, threadPool, 0) != 0)
+        {
+            _close();
+            throw std::runtime_error("could not attach decompression threads to FASTQ file: " + _fileName);
+        }
+        return;
+    }
+
+    // anything else can't be split into blocks, so it's inflated in large chunks on a background thread instead
+    bgzf_close(_bgzf);
+    _bgzf = nullptr;
+    _gzFile = gzopen(_fileName.c_str(), "rb");
+    if (!_gzFile)
+        throw std::runtime_error("could not open FASTQ file: " + _fileName);
+    gzbuffer(_gzFile, FASTQREADER_GZ_BUFFER);
+    _inflater = std::thread(&artic::FastqReader::_inflate, this);
+}
+
+// FastqReader destructor.
+artic::FastqReader::~FastqReader(void) { _close(); }
+
+// GetFileName returns the name of the file being read.
+const std::string& artic::FastqReader::GetFileName(void) const { return _fileName; }
+
+// IsBGZF returns true if the file is BGZF compressed (and being decompressed by the thread pool).
+bool artic::FastqReader::IsBGZF(void) const { return _bgzf != nullptr; }
+
+// GetNumBytes returns the number of (decompressed) bytes read so far.
+uint64_t artic::FastqReader::GetNumBytes(void) const { return _numBytes; }
+
+// Read will read the next record into the holder, returning false once there are no more.
+bool artic::FastqReader::Read(klibpp::KSeq& record)
+{
+    if (_stream >> record)
+        return true;
+    if (_failed)
+        throw std::runtime_error("could not decompress FASTQ file: " + _fileName);
+    return false;
+}
+
+// _fill fills the parser buffer with decompressed bytes (0 at the end of the file).
+int artic::FastqReader::_fill(FastqReader* reader, void* buffer, unsigned int size)
+{
+    if (reader->_bgzf)
+    {
+        auto len = bgzf_read(reader->_bgzf, buffer, size);
+        if (len < 0)
+        {
+            reader->_failed = true;
+            return 0;
+        }
+        reader->_numBytes += len;
+        return len;
+    }
+
+    // move on to the next inflated chunk once this one has been parsed, handing this one back to the inflate thread
+    // (the inflate thread only makes a new chunk when none are free, so the empty queue always has room for this one)
+    if (reader->_chunkPos == reader->_chunk.size())
+    {
+        if (reader->_chunk.capacity() != 0)
+            reader->_emptyChunks.Push(std::move(reader->_chunk));
+        reader->_chunk.clear();
+        reader->_chunkPos = 0;
+        if (!reader->_chunks.Pop(reader->_chunk))
+            return 0;
+    }
+    auto len = std::min(std::size_t(size), reader->_chunk.size() - reader->_chunkPos);
+    std::memcpy(buffer, reader->_chunk.data() + reader->_chunkPos, len);
+    reader->_chunkPos += len;
+    reader->_numBytes += len;
+    return len;
+}
+
+// _inflate inflates the file in chunks on the background thread.
+void artic::FastqReader::_inflate(void)
+{
+    while (true)
+    {
+        std::vector<char> chunk;
+        _emptyChunks.TryPop(chunk);
+        chunk.resize(FASTQREADER_CHUNK_SIZE);
+        int len = gzread(_gzFile, chunk.data(), chunk.size());
+
+        // a truncated file reads as the end of the file, so check zlib's error state too
+        int error = Z_OK;
+        if (len <= 0)
+            gzerror(_gzFile, &error);
+        if (len < 0 || error != Z_OK)
+        {
+            _failed = true;
+            break;
+        }
+        if (len == 0)
+            break;
+        chunk.resize(len);
+        if (!_chunks.Push(std::move(chunk)))
+            break;
+    }
+    _chunks.Close();
+}
+
+// _close stops the inflate thread and closes the file.
+void artic::FastqReader::_close(void)
+{
+    _chunks.Close();
+    _emptyChunks.Close();
+    if (_inflater.joinable())
+        _inflater.join();
+    if (_gzFile)
+        gzclose(_gzFile);
+    _gzFile = nullptr;
+    if (_bgzf)
+        bgzf_close(_bgzf);
+    _bgzf = nullptr;
+}
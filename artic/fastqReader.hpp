@@ -0,0 +1,79 @@
+#ifndef FASTQREADER_H
+#define FASTQREADER_H
+
+#include <cstdint>
+#include <htslib/bgzf.h>
+#include <htslib/thread_pool.h>
+#include <kseq++/kseq++.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+#include "boundedQueue.hpp"
+
+namespace artic
+{
+    // FASTQREADER_CHUNK_SIZE is the number of bytes inflated in one go when reading a gzip file that isn't BGZF.
+    const std::size_t FASTQREADER_CHUNK_SIZE = 1 << 20;
+
+    // FASTQREADER_CHUNKS is the number of inflated chunks that can be waiting for the parser.
+    const std::size_t FASTQREADER_CHUNKS = 4;
+
+    //******************************************************************************
+    // FastqReader reads the records from a FASTQ (or FASTA) file, decompressing it off the calling thread.
+    //
+    // NOTES:
+    // * BGZF files are decompressed a block at a time by the htslib thread pool, so more threads give more throughput
+    // * other files (gzip or uncompressed) are inflated in large chunks by a single background thread
+    // * either way the calling thread only parses records, which overlaps with the decompression
+    // * a thread pool can be shared by several readers, but it has to outlive them (without one, BGZF files are decompressed on the calling thread)
+    //******************************************************************************
+    class FastqReader
+    {
+    public:
+        // FastqReader constructor.
+        FastqReader(const std::string& fileName, hts_tpool* threadPool);
+
+        // FastqReader destructor.
+        ~FastqReader(void);
+
+        // FastqReader is not copyable, as it owns the file handle and the inflate thread.
+        FastqReader(const FastqReader&) = delete;
+        FastqReader& operator=(const FastqReader&) = delete;
+
+        // GetFileName returns the name of the file being read.
+        const std::string& GetFileName(void) const;
+
+        // IsBGZF returns true if the file is BGZF compressed (and being decompressed by the thread pool).
+        bool IsBGZF(void) const;
+
+        // GetNumBytes returns the number of (decompressed) bytes read so far.
+        uint64_t GetNumBytes(void) const;
+
+        // Read will read the next record into the holder, returning false once there are no more.
+        bool Read(klibpp::KSeq& record);
+
+    private:
+        typedef int (*readFunc)(FastqReader*, void*, unsigned int);
+
+        static int _fill(FastqReader* reader, void* buffer, unsigned int size); // fills the parser buffer with decompressed bytes (0 at the end of the file)
+        void _inflate(void);                                                    // inflates the file in chunks on the background thread
+        void _close(void);                                                      // stops the inflate thread and closes the file
+
+        std::string _fileName;                             // the file being read
+        BGZF* _bgzf;                                       // the BGZF file handle (nullptr if the file isn't BGZF)
+        gzFile _gzFile;                                    // the zlib file handle used by the inflate thread (nullptr if the file is BGZF)
+        std::thread _inflater;                             // the inflate thread
+        BoundedQueue<std::vector<char>> _chunks;           // chunks inflated by the inflate thread, waiting for the parser
+        BoundedQueue<std::vector<char>> _emptyChunks;      // chunks returned by the parser for reuse
+        std::vector<char> _chunk;                          // the chunk being parsed
+        std::size_t _chunkPos;                             // the position of the parser in the chunk
+        bool _failed;                                      // true if the file couldn't be decompressed (set before the chunk queue closes)
+        uint64_t _numBytes;                                // the number of decompressed bytes passed to the parser
+        klibpp::KStreamIn<FastqReader*, readFunc> _stream; // the kseq++ parser, which pulls decompressed bytes through _fill
+    };
+
+} // namespace artic
+
+#endif
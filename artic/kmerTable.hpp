@@ -0,0 +1,108 @@
+#ifndef KMERTABLE_H
+#define KMERTABLE_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "kmers.hpp"
+
+namespace artic
+{
+    //******************************************************************************
+    // KmerTable is a static hash-bucketed lookup of k-mer keyed entries, used by the k-mer and minimizer indexes.
+    //
+    // NOTES:
+    // * entries can be any type with a kmer field, and each k-mer should only be given once
+    // * entries are ordered by an invertible hash of their k-mer and held in one flat array, with a
+    //   bucket table on the top bits of the hash (sized to the next power of 2, so 0.5-1 entries per bucket)
+    // * k-mers sampled by their hash (minimizers, syncmers) only cover the low end of the hash range, so their
+    //   tables need a seed, which is mixed in to the k-mer before hashing to spread them over the buckets
+    // * a probe is one bucket lookup plus a short scan of adjacent entries, so a typical scheme fits in L1/L2
+    // * the table is built once and can't be changed, it is read-only and can be shared between threads
+    // * K fixes the k-mer size of a probe at compile time so the hash mask is a constant, the default of 0 uses it at runtime
+    //******************************************************************************
+    template <typename T>
+    class KmerTable
+    {
+    public:
+        // KmerTable constructor (an empty table).
+        KmerTable(void)
+            : _kSize(0), _bucketShift(0), _seed(0) {}
+
+        // KmerTable constructor (builds the table from a set of entries, the seed changes the bucket hash).
+        KmerTable(std::vector<T> entries, uint32_t kSize, kmer_t seed = 0)
+            : _kSize(kSize), _bucketShift(0), _seed(seed)
+        {
+            if (_kSize == 0 || _kSize > MAX_K_SIZE)
+                throw std::runtime_error("k-mer size must be > 0 and <= " + std::to_string(MAX_K_SIZE));
+            if (_kSize < MAX_K_SIZE)
+                _seed &= (1ULL << (2 * _kSize)) - 1;
+
+            // order the entries by k-mer hash
+            std::vector<std::pair<uint64_t, std::size_t>> hashed;
+            hashed.reserve(entries.size());
+            for (std::size_t i = 0; i < entries.size(); i++)
+                hashed.emplace_back(HashKmer(entries[i].kmer ^ _seed, _kSize), i);
+            std::sort(hashed.begin(), hashed.end());
+
+            // size the bucket table to the next power of 2 >= the number of entries (min 2), using the top bits of the (2k-bit) hash
+            uint32_t hashBits = 2 * _kSize;
+            uint32_t bucketBits = 1;
+            while ((bucketBits < hashBits) && ((1ULL << bucketBits) < hashed.size()))
+                bucketBits++;
+            _bucketShift = hashBits - bucketBits;
+
+            // fill the entries and mark the start of each bucket
+            _buckets.assign((1ULL << bucketBits) + 1, 0);
+            _entries.reserve(hashed.size());
+            for (const auto& entry : hashed)
+            {
+                _buckets[(entry.first >> _bucketShift) + 1]++;
+                _entries.emplace_back(std::move(entries[entry.second]));
+            }
+            for (std::size_t i = 1; i < _buckets.size(); ++i)
+                _buckets[i] += _buckets[i - 1];
+        }
+
+        // Find returns the entry for a k-mer, or nullptr if the k-mer is not in the table.
+        template <uint32_t K = 0>
+        inline const T* Find(kmer_t kmer) const
+        {
+            if (_entries.empty())
+                return nullptr;
+            auto bucket = HashKmer<K>(kmer ^ _seed, _kSize) >> _bucketShift;
+            for (auto i = _buckets[bucket]; i < _buckets[bucket + 1]; ++i)
+                if (_entries[i].kmer == kmer)
+                    return &_entries[i];
+            return nullptr;
+        }
+
+        // GetEntries returns the entries, ordered by hash.
+        const std::vector<T>& GetEntries(void) const { return _entries; }
+
+        // GetNumEmptyBuckets returns the number of buckets without any entries.
+        std::size_t GetNumEmptyBuckets(void) const
+        {
+            std::size_t numEmpty = 0;
+            for (std::size_t i = 1; i < _buckets.size(); ++i)
+                numEmpty += (_buckets[i] == _buckets[i - 1]);
+            return numEmpty;
+        }
+
+        // GetMemoryUsage returns the number of bytes used by the table.
+        std::size_t GetMemoryUsage(void) const { return (_buckets.size() * sizeof(uint32_t)) + (_entries.size() * sizeof(T)); }
+
+    private:
+        uint32_t _kSize;                // the k-mer size
+        uint32_t _bucketShift;          // the shift to get a bucket from a k-mer hash
+        kmer_t _seed;                   // the seed mixed in to the k-mers before hashing
+        std::vector<uint32_t> _buckets; // the start of each bucket in the entries (plus a final end)
+        std::vector<T> _entries;        // the entries, ordered by hash
+    };
+
+} // namespace artic
+
+#endif
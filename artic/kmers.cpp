@@ -1,41 +1,139 @@
+#include <algorithm>
 #include <iostream>
 #include <queue>
 
 #include "kmers.hpp"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ARTIC_KMER_DISPATCH
+#include <immintrin.h>
+#endif
+
 namespace artic
 {
 
-    // GetEncodedKmers will compute and integer encode all canonical k-mers in a sequence, adding them to the provided container.
-    void GetEncodedKmers(const char* seq, uint32_t seqLen, uint32_t kSize, kmerset_t& kmers)
+    // encodeBasesScalar will 2-bit encode a sequence one base at a time.
+    static void encodeBasesScalar(const char* seq, uint32_t seqLen, uint8_t* codes)
     {
-        if (kSize > MAX_K_SIZE)
-            throw std::runtime_error("k-mer size must be <= " + std::to_string(MAX_K_SIZE));
-        //if (!kmers.empty())
-        //    throw std::runtime_error("provided k-mer container already has k-mers in it");
-        uint64_t kmerMask = (1ULL << (2 * kSize)) - 1;
-        uint64_t bitShift = 2 * (kSize - 1);
-        kmer_t x[2];
-        x[0] = x[1] = 0;
-        uint32_t l = 0;
         for (uint32_t i = 0; i < seqLen; i++)
+            codes[i] = nt2char[static_cast<uint8_t>(seq[i])];
+    }
+
+#ifdef ARTIC_KMER_DISPATCH
+    // encodeBasesSSE41 will 2-bit encode a sequence 16 bases at a time.
+    // ((base >> 1) ^ (base >> 2)) & 3 gives A/C/G/T = 0/1/2/3 for either case, then anything that isn't ACGT is blended to 4.
+    __attribute__((target("sse4.1"))) static void encodeBasesSSE41(const char* seq, uint32_t seqLen, uint8_t* codes)
+    {
+        const __m128i caseMask = _mm_set1_epi8(char(0xDF));
+        const __m128i a = _mm_set1_epi8('A');
+        const __m128i c = _mm_set1_epi8('C');
+        const __m128i g = _mm_set1_epi8('G');
+        const __m128i t = _mm_set1_epi8('T');
+        const __m128i codeMask = _mm_set1_epi8(3);
+        const __m128i invalid = _mm_set1_epi8(4);
+        uint32_t i = 0;
+        for (; i + 16 <= seqLen; i += 16)
         {
+            __m128i bases = _mm_loadu_si128(reinterpret_cast<const __m128i*>(seq + i));
+            __m128i upper = _mm_and_si128(bases, caseMask);
+            __m128i valid = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(upper, a), _mm_cmpeq_epi8(upper, c)), _mm_or_si128(_mm_cmpeq_epi8(upper, g), _mm_cmpeq_epi8(upper, t)));
+            __m128i encoded = _mm_and_si128(_mm_xor_si128(_mm_srli_epi16(bases, 1), _mm_srli_epi16(bases, 2)), codeMask);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(codes + i), _mm_blendv_epi8(invalid, encoded, valid));
+        }
+        encodeBasesScalar(seq + i, seqLen - i, codes + i);
+    }
 
-            // get 2-bit encoding of current base
-            uint8_t base = (uint8_t)seq[i] < 128 ? nt2char[static_cast<uint8_t>(seq[i])] : 4;
+    // encodeBasesAVX2 will 2-bit encode a sequence 32 bases at a time (as per encodeBasesSSE41).
+    __attribute__((target("avx2"))) static void encodeBasesAVX2(const char* seq, uint32_t seqLen, uint8_t* codes)
+    {
+        const __m256i caseMask = _mm256_set1_epi8(char(0xDF));
+        const __m256i a = _mm256_set1_epi8('A');
+        const __m256i c = _mm256_set1_epi8('C');
+        const __m256i g = _mm256_set1_epi8('G');
+        const __m256i t = _mm256_set1_epi8('T');
+        const __m256i codeMask = _mm256_set1_epi8(3);
+        const __m256i invalid = _mm256_set1_epi8(4);
+        uint32_t i = 0;
+        for (; i + 32 <= seqLen; i += 32)
+        {
+            __m256i bases = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(seq + i));
+            __m256i upper = _mm256_and_si256(bases, caseMask);
+            __m256i valid = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(upper, a), _mm256_cmpeq_epi8(upper, c)), _mm256_or_si256(_mm256_cmpeq_epi8(upper, g), _mm256_cmpeq_epi8(upper, t)));
+            __m256i encoded = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi16(bases, 1), _mm256_srli_epi16(bases, 2)), codeMask);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(codes + i), _mm256_blendv_epi8(invalid, encoded, valid));
+        }
+        encodeBasesScalar(seq + i, seqLen - i, codes + i);
+    }
+#endif
 
-            // skip non A/C/T/G bases
-            if (base > 3)
-                continue;
+    // GetBaseEncoder returns the encoding function for a kernel, checking it is supported by the CPU.
+    baseEncoder_t GetBaseEncoder(KmerKernel kernel)
+    {
+        if (kernel > GetKmerKernel())
+            throw std::runtime_error("k-mer kernel not supported by this CPU: " + GetKmerKernelName(kernel));
+        switch (kernel)
+        {
+#ifdef ARTIC_KMER_DISPATCH
+        case KmerKernel::avx2:
+            return encodeBasesAVX2;
+        case KmerKernel::sse41:
+            return encodeBasesSSE41;
+#endif
+        default:
+            return encodeBasesScalar;
+        }
+    }
 
-            // use the masks to add the current base to the k-mer and its reverse complement, dropping the oldest base from the k-mer
-            x[0] = (x[0] << 2 | base) & kmerMask;
-            x[1] = x[1] >> 2 | (uint64_t)(3ULL - base) << bitShift;
+    // GetKmerKernel returns the fastest k-mer kernel supported by the CPU (checked once, on first use).
+    KmerKernel GetKmerKernel(void)
+    {
+        static const KmerKernel kernel = []() {
+#ifdef ARTIC_KMER_DISPATCH
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return KmerKernel::avx2;
+            if (__builtin_cpu_supports("sse4.1"))
+                return KmerKernel::sse41;
+#endif
+            return KmerKernel::scalar;
+        }();
+        return kernel;
+    }
 
-            // once enough bases have been processed, start collecting canonical k-mers
-            if (++l >= kSize)
-                (x[0] <= x[1]) ? kmers.emplace_back(x[0]) : kmers.emplace_back(x[1]);
+    // GetKmerKernelName returns the name of a k-mer kernel.
+    std::string GetKmerKernelName(KmerKernel kernel)
+    {
+        switch (kernel)
+        {
+        case KmerKernel::avx2:
+            return "avx2";
+        case KmerKernel::sse41:
+            return "sse4.1";
+        default:
+            return "scalar";
         }
+    }
+
+    // EncodeBases will 2-bit encode a sequence using the provided kernel, with non-ACGT bases encoded as 4 (as per nt2char).
+    void EncodeBases(const char* seq, uint32_t seqLen, uint8_t* codes, KmerKernel kernel)
+    {
+        GetBaseEncoder(kernel)(seq, seqLen, codes);
+    }
+
+    // GetEncodedKmers will compute and integer encode all canonical k-mers in a sequence, adding them to the provided container.
+    void GetEncodedKmers(const char* seq, uint32_t seqLen, uint32_t kSize, kmerset_t& kmers)
+    {
+        GetEncodedKmers(seq, seqLen, kSize, kmers, GetKmerKernel());
+    }
+
+    // GetEncodedKmers will compute and integer encode all canonical k-mers in a sequence using the provided kernel.
+    void GetEncodedKmers(const char* seq, uint32_t seqLen, uint32_t kSize, kmerset_t& kmers, KmerKernel kernel)
+    {
+        if (kSize > MAX_K_SIZE)
+            throw std::runtime_error("k-mer size must be <= " + std::to_string(MAX_K_SIZE));
+
+        // dispatch to the compile-time k-mer size, so the masks and shifts are constants in the hot loop
+        DispatchKmerSize<MAX_K_SIZE>(kSize, [&](auto k) { GetEncodedKmers<decltype(k)::value, kmer_t>(seq, seqLen, kmers, kernel); });
         return;
     }
 
@@ -74,4 +172,153 @@ namespace artic
         return;
     }
 
+    namespace
+    {
+        //******************************************************************************
+        // windowMin is a monotone deque for the minimum hash in a sliding window.
+        //
+        // NOTES:
+        // * it is a ring buffer that never holds more than the window size
+        // * hashes increase from front to back, so the front is the window minimum
+        // * ties keep the leftmost entry
+        //******************************************************************************
+        class windowMin
+        {
+        public:
+            // windowMin constructor.
+            windowMin(uint32_t wSize)
+                : _wSize(wSize), _ring(wSize), _head(0), _size(0) {}
+
+            // Push adds the hash for an item index, dropping any items that have left the window.
+            void Push(uint64_t hash, uint32_t index)
+            {
+                while (_size && _back().first > hash)
+                    _size--;
+                while (_size && _ring[_head].second + _wSize <= index)
+                {
+                    _head = (_head + 1) % _wSize;
+                    _size--;
+                }
+                _ring[(_head + _size) % _wSize] = std::make_pair(hash, index);
+                _size++;
+            }
+
+            // Front returns the item index with the smallest hash in the window.
+            uint32_t Front(void) const { return _ring[_head].second; }
+
+        private:
+            std::pair<uint64_t, uint32_t>& _back(void) { return _ring[(_head + _size - 1) % _wSize]; }
+
+            uint32_t _wSize;                                  // the window size
+            std::vector<std::pair<uint64_t, uint32_t>> _ring; // the hashes and item indices in the window
+            uint32_t _head;                                   // the ring position of the front item
+            uint32_t _size;                                   // the number of items in the window
+        };
+    } // namespace
+
+    // GetMinimizers will add the (w,k)-minimizers of a sequence to the provided container (the k-mer with the smallest hash in each window of w k-mers).
+    void GetMinimizers(const char* seq, uint32_t seqLen, uint32_t kSize, uint32_t wSize, std::vector<Kmer>& minimizers)
+    {
+        if (wSize == 0)
+            throw std::runtime_error("minimizer window size must be > 0");
+        windowMin window(wSize);
+        std::vector<Kmer> kmers(wSize);
+        uint32_t index = 0;
+        uint32_t last = UINT32_MAX;
+        Kmer kmer;
+        KmerScanner scanner(seq, seqLen, kSize);
+        while (scanner.Next(kmer))
+        {
+            // keep the last w k-mers so that the window minimum can be returned
+            kmers[index % wSize] = kmer;
+            window.Push(HashKmer(kmer.kmer, kSize), index);
+
+            // once the first window is full, add each new minimizer
+            if (index + 1 >= wSize && window.Front() != last)
+            {
+                last = window.Front();
+                minimizers.emplace_back(kmers[last % wSize]);
+            }
+            index++;
+        }
+        return;
+    }
+
+    // GetSyncmers will add the open or closed syncmers of a sequence to the provided container (k-mers whose smallest s-mer is at the offset, or either end if closed).
+    void GetSyncmers(const char* seq, uint32_t seqLen, uint32_t kSize, uint32_t sSize, SyncmerType type, std::vector<Kmer>& syncmers, uint32_t offset)
+    {
+        if (sSize == 0 || sSize > kSize)
+            throw std::runtime_error("syncmer s-mer size must be > 0 and <= the k-mer size");
+        if (type == SyncmerType::open && offset > (kSize - sSize))
+            throw std::runtime_error("open syncmer offset must be <= " + std::to_string(kSize - sSize));
+
+        // scan the s-mers and k-mers together, the k-mer ending on a base holds the last k-s+1 s-mers ending on or before that base
+        uint32_t numSmers = kSize - sSize + 1;
+        windowMin window(numSmers);
+        uint32_t index = 0;
+        Kmer smer, kmer;
+        KmerScanner smerScanner(seq, seqLen, sSize);
+        KmerScanner kmerScanner(seq, seqLen, kSize);
+        while (smerScanner.Next(smer))
+        {
+            window.Push(HashKmer(smer.kmer, sSize), index);
+            if (index + 1 >= numSmers)
+            {
+                kmerScanner.Next(kmer);
+                uint32_t smerOffset = window.Front() - (index + 1 - numSmers);
+                if ((type == SyncmerType::closed) ? (smerOffset == 0 || smerOffset == numSmers - 1) : (smerOffset == offset))
+                    syncmers.emplace_back(kmer);
+            }
+            index++;
+        }
+        return;
+    }
+
+    // SpacedSeed constructor.
+    SpacedSeed::SpacedSeed(const std::string& pattern)
+        : _pattern(pattern), _span(pattern.size()), _weight(0), _numRuns(0)
+    {
+        if (_span == 0 || _span > MAX_K_SIZE)
+            throw std::runtime_error("spaced seed span must be > 0 and <= " + std::to_string(MAX_K_SIZE) + ": " + pattern);
+        if (pattern.find_first_not_of("01") != std::string::npos)
+            throw std::runtime_error("spaced seed can only contain 1s and 0s: " + pattern);
+        if (pattern.front() != '1' || pattern.back() != '1')
+            throw std::runtime_error("spaced seed must start and end with a 1: " + pattern);
+
+        // find the runs of 1s, working back from the end of the pattern as the last base is in the lowest bits
+        uint32_t offset = 0;
+        uint32_t runEnd = _span;
+        while (runEnd > 0)
+        {
+            if (pattern[runEnd - 1] == '0')
+            {
+                runEnd--;
+                continue;
+            }
+            uint32_t runStart = runEnd;
+            while (runStart > 0 && pattern[runStart - 1] == '1')
+                runStart--;
+            uint32_t runLen = runEnd - runStart;
+            _runs[_numRuns].mask = (runLen == MAX_K_SIZE) ? ~0ULL : (1ULL << (2 * runLen)) - 1;
+            _runs[_numRuns].shift = 2 * (_span - runEnd);
+            _runs[_numRuns].offset = offset;
+            _numRuns++;
+            offset += 2 * runLen;
+            _weight += runLen;
+            runEnd = runStart;
+        }
+    }
+
+    // GetPattern returns the seed pattern.
+    const std::string& SpacedSeed::GetPattern(void) const { return _pattern; }
+
+    // GetSpan returns the number of bases covered by the seed.
+    uint32_t SpacedSeed::GetSpan(void) const { return _span; }
+
+    // GetWeight returns the number of bases kept by the seed (the k-mer size of the sampled k-mers).
+    uint32_t SpacedSeed::GetWeight(void) const { return _weight; }
+
+    // IsContiguous returns true if the seed keeps every base it covers.
+    bool SpacedSeed::IsContiguous(void) const { return _weight == _span; }
+
 } // namespace artic
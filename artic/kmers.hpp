@@ -1,6 +1,11 @@
 #ifndef KMERS_H
 #define KMERS_H
 
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <unordered_set>
 #include <vector>
 
@@ -38,9 +43,144 @@ namespace artic
     // char2nt is a lookup to convert integers to nucleotides.
     const uint8_t char2nt[5] = {'A', 'C', 'G', 'T', 'N'};
 
+    // KMER_BLOCK_SIZE is the number of bases encoded in one go by the k-mer kernels.
+    const uint32_t KMER_BLOCK_SIZE = 256;
+
+    // baseEncoder_t is a kernel function for 2-bit encoding bases.
+    typedef void (*baseEncoder_t)(const char* seq, uint32_t seqLen, uint8_t* codes);
+
+    // KmerKernel is the instruction set used to 2-bit encode bases.
+    enum class KmerKernel
+    {
+        scalar, // one base at a time via nt2char
+        sse41,  // 16 bases at a time
+        avx2    // 32 bases at a time
+    };
+
+    // GetKmerKernel returns the fastest k-mer kernel supported by the CPU (checked once, on first use).
+    KmerKernel GetKmerKernel(void);
+
+    // GetKmerKernelName returns the name of a k-mer kernel.
+    std::string GetKmerKernelName(KmerKernel kernel);
+
+    // GetBaseEncoder returns the encoding function for a kernel, checking it is supported by the CPU.
+    baseEncoder_t GetBaseEncoder(KmerKernel kernel);
+
+    // EncodeBases will 2-bit encode a sequence using the provided kernel, with non-ACGT bases encoded as 4 (as per nt2char).
+    void EncodeBases(const char* seq, uint32_t seqLen, uint8_t* codes, KmerKernel kernel);
+
     // GetEncodedKmers will compute and integer encode all canonical k-mers in a sequence, adding them to the provided container.
     void GetEncodedKmers(const char* seq, uint32_t seqLen, uint32_t kSize, kmerset_t& kmers);
 
+    // GetEncodedKmers will compute and integer encode all canonical k-mers in a sequence using the provided kernel.
+    void GetEncodedKmers(const char* seq, uint32_t seqLen, uint32_t kSize, kmerset_t& kmers, KmerKernel kernel);
+
+    // kmer128_t is a 128-bit word for k-mers longer than MAX_K_SIZE.
+    __extension__ typedef unsigned __int128 kmer128_t;
+
+    // MAX_LONG_K_SIZE is the maximum k-mer size permitted by the templated k-mer functions.
+    const uint32_t MAX_LONG_K_SIZE = sizeof(kmer128_t) * 4;
+
+    // kmerWord_t is the smallest word that can hold a 2-bit encoded k-mer of size K.
+    template <uint32_t K>
+    using kmerWord_t = std::conditional_t<(K <= 16), uint32_t, std::conditional_t<(K <= 32), uint64_t, kmer128_t>>;
+
+    // GetKmerMask returns the mask for a 2-bit encoded k-mer of size K held in a word.
+    template <uint32_t K, typename word_t = kmer_t>
+    constexpr word_t GetKmerMask(void)
+    {
+        static_assert(K > 0 && (2 * K) <= (sizeof(word_t) * 8), "k-mer size does not fit in the word type");
+        return ((2 * K) == (sizeof(word_t) * 8)) ? ~word_t(0) : (word_t(1) << (2 * K)) - 1;
+    }
+
+    // GetEncodedKmers will compute and integer encode all canonical k-mers in a sequence, with the k-mer size and word type fixed at compile time.
+    template <uint32_t K, typename word_t = kmerWord_t<K>>
+    void GetEncodedKmers(const char* seq, uint32_t seqLen, std::vector<word_t>& kmers, KmerKernel kernel = GetKmerKernel())
+    {
+        constexpr word_t kmerMask = GetKmerMask<K, word_t>();
+        constexpr uint32_t bitShift = 2 * (K - 1);
+        auto encoder = GetBaseEncoder(kernel);
+
+        // size the container for the maximum number of k-mers up front and write them through a pointer, trimming any excess at the end
+        if (seqLen < K)
+            return;
+        std::size_t offset = kmers.size();
+        kmers.resize(offset + (seqLen - K + 1));
+        word_t* out = kmers.data() + offset;
+        word_t x[2];
+        x[0] = x[1] = 0;
+        uint32_t l = 0;
+        uint8_t codes[KMER_BLOCK_SIZE];
+        for (uint32_t blockStart = 0; blockStart < seqLen; blockStart += KMER_BLOCK_SIZE)
+        {
+
+            // 2-bit encode the next block of bases
+            uint32_t blockLen = std::min(KMER_BLOCK_SIZE, seqLen - blockStart);
+            encoder(seq + blockStart, blockLen, codes);
+            for (uint32_t i = 0; i < blockLen; i++)
+            {
+                uint8_t base = codes[i];
+
+                // skip non A/C/T/G bases
+                if (base > 3)
+                    continue;
+
+                // use the masks to add the current base to the k-mer and its reverse complement, dropping the oldest base from the k-mer
+                x[0] = (x[0] << 2 | base) & kmerMask;
+                x[1] = x[1] >> 2 | word_t(3 - base) << bitShift;
+
+                // once enough bases have been processed, start collecting canonical k-mers (branch free, as the choice of strand is unpredictable)
+                *out = std::min(x[0], x[1]);
+                out += (++l >= K);
+            }
+        }
+        kmers.resize(out - kmers.data());
+        return;
+    }
+
+    // GetRCencoding will reverse complement an encoded k-mer, with the k-mer size and word type fixed at compile time.
+    template <uint32_t K, typename word_t>
+    word_t GetRCencoding(word_t encodedKmer)
+    {
+        word_t rc = 0;
+        for (uint32_t i = 0; i < K; i++)
+        {
+            rc = (rc << 2) | ((encodedKmer & 3) ^ 3);
+            encodedKmer >>= 2;
+        }
+        return rc;
+    }
+
+    // DecodeKmer will decode an integer encoded k-mer, with the k-mer size and word type fixed at compile time.
+    template <uint32_t K, typename word_t>
+    void DecodeKmer(word_t encodedKmer, std::string& decodedKmer)
+    {
+        decodedKmer.resize(K);
+        for (uint32_t i = 0; i < K; i++)
+        {
+            decodedKmer[(K - 1) - i] = char2nt[uint8_t(encodedKmer & 3)];
+            encodedKmer >>= 2;
+        }
+    }
+
+    // DispatchKmerSize is the jump table behind DispatchKmerSize, with an entry for each k-mer size in the sequence (offset by 1).
+    template <typename F, uint32_t... Ks>
+    void DispatchKmerSize(uint32_t kSize, F& func, std::integer_sequence<uint32_t, Ks...>)
+    {
+        using call_t = void (*)(F&);
+        static constexpr call_t calls[] = {[](F& f) { f(std::integral_constant<uint32_t, Ks + 1>()); }...};
+        calls[kSize - 1](func);
+    }
+
+    // DispatchKmerSize will call func with std::integral_constant<uint32_t, K> for a runtime k-mer size, so that callers can select a templated k-mer function once.
+    template <uint32_t MAX_K = MAX_LONG_K_SIZE, typename F>
+    void DispatchKmerSize(uint32_t kSize, F&& func)
+    {
+        if (kSize == 0 || kSize > MAX_K)
+            throw std::runtime_error("k-mer size must be > 0 and <= " + std::to_string(MAX_K));
+        DispatchKmerSize(kSize, func, std::make_integer_sequence<uint32_t, MAX_K>());
+    }
+
     // GetRCencoding will reverse complement an encoded k-mer.
     kmer_t GetRCencoding(kmer_t encodedKmer, uint32_t kSize);
 
@@ -50,6 +190,297 @@ namespace artic
     // DecodeKmer_rc will decode an integer encoded k-mer to it's reverse complement.
     void DecodeKmer_rc(kmer_t encodedKmer, uint32_t kSize, std::string& decodedKmer);
 
+    // Kmer is a canonical k-mer yielded by a KmerScanner.
+    struct Kmer
+    {
+        kmer_t kmer;  // the canonical k-mer encoding
+        uint32_t end; // the sequence position after the last base of the k-mer (0-based, half-open)
+        bool forward; // true if the canonical k-mer is from the forward strand of the sequence
+    };
+
+    // MAX_SEED_RUNS is the maximum number of runs of kept positions in a spaced seed (a pattern can't start or end with a 0).
+    const uint32_t MAX_SEED_RUNS = (MAX_K_SIZE + 1) / 2;
+
+    //******************************************************************************
+    // SpacedSeed is a pattern of kept and ignored positions, used to sample k-mers that tolerate substitutions.
+    //
+    // NOTES:
+    // * patterns are strings of 1s (keep) and 0s (ignore), e.g. "111010010100110111"
+    // * the span of a pattern must be <= MAX_K_SIZE and it must start and end with a 1
+    // * sampled k-mers have the pattern weight (number of 1s) as their k-mer size
+    // * a substitution at an ignored position doesn't change the sampled k-mer
+    // * k-mers are canonical, so use symmetric patterns (e.g. "110111010111011") to tolerate the same substitutions on both strands
+    // * a pattern of all 1s gives the same k-mers as a contiguous k-mer of that size
+    //******************************************************************************
+    class SpacedSeed
+    {
+    public:
+        // SpacedSeed constructor.
+        SpacedSeed(const std::string& pattern);
+
+        // GetPattern returns the seed pattern.
+        const std::string& GetPattern(void) const;
+
+        // GetSpan returns the number of bases covered by the seed.
+        uint32_t GetSpan(void) const;
+
+        // GetWeight returns the number of bases kept by the seed (the k-mer size of the sampled k-mers).
+        uint32_t GetWeight(void) const;
+
+        // IsContiguous returns true if the seed keeps every base it covers.
+        bool IsContiguous(void) const;
+
+        // Apply returns the k-mer sampled by the seed from an encoded k-mer of the seed span.
+        inline kmer_t Apply(kmer_t window) const
+        {
+            kmer_t kmer = 0;
+            for (uint32_t i = 0; i < _numRuns; ++i)
+                kmer |= ((window >> _runs[i].shift) & _runs[i].mask) << _runs[i].offset;
+            return kmer;
+        }
+
+    private:
+        // run is a run of kept positions in the seed, which is copied into the sampled k-mer in one go.
+        struct run
+        {
+            uint64_t mask;   // the mask for the run bits
+            uint32_t shift;  // the bit position of the run in the window
+            uint32_t offset; // the bit position of the run in the sampled k-mer
+        };
+
+        std::string _pattern;     // the seed pattern
+        uint32_t _span;           // the number of bases covered by the seed
+        uint32_t _weight;         // the number of bases kept by the seed
+        uint32_t _numRuns;        // the number of runs of kept positions
+        run _runs[MAX_SEED_RUNS]; // the runs of kept positions
+    };
+
+    //******************************************************************************
+    // KmerScanner yields the canonical k-mers of a sequence one at a time.
+    //
+    // NOTES:
+    // * k-mers are the same, and in the same order, as those from GetEncodedKmers
+    // * nothing is allocated, so consumers can probe lookups inline and stop early
+    // * the sequence is not copied, so it must outlive the scanner
+    // * bases are encoded in blocks using the fastest kernel for the CPU
+    // * with a spaced seed, the k-mers are sampled from each window of the seed span (the seed must outlive the scanner)
+    // * K fixes the k-mer size (or seed span) at compile time so the masks and shifts are constants, the default of 0 takes it at runtime
+    //
+    // USAGE:
+    //      for (const auto& kmer : artic::KmerScanner(seq, seqLen, kSize))
+    //          if (lookup.count(kmer.kmer)) break;
+    //******************************************************************************
+    template <uint32_t K = 0>
+    class KmerScanner
+    {
+    public:
+        // KmerScanner constructor.
+        KmerScanner(const char* seq, uint32_t seqLen, uint32_t kSize);
+        KmerScanner(const char* seq, uint32_t seqLen, uint32_t kSize, KmerKernel kernel);
+        KmerScanner(const char* seq, uint32_t seqLen, const SpacedSeed& seed);
+
+        // Next will get the next canonical k-mer, returning false once the sequence is exhausted.
+        inline bool Next(Kmer& kmer)
+        {
+            while (true)
+            {
+                if (_blockPos == _blockLen && !_encodeBlock())
+                    return false;
+                uint8_t base = _codes[_blockPos++];
+
+                // skip non A/C/T/G bases
+                if (base > 3)
+                    continue;
+
+                // add the current base to the k-mer and its reverse complement, dropping the oldest base
+                _x[0] = (_x[0] << 2 | base) & _getKmerMask();
+                _x[1] = _x[1] >> 2 | (uint64_t)(3ULL - base) << _getBitShift();
+                if (++_l >= _getKSize())
+                {
+                    if (_seed)
+                    {
+                        // the seed is applied to both strands, so the canonical k-mer is the same for a read from either strand
+                        auto fwd = _seed->Apply(_x[0]);
+                        auto rc = _seed->Apply(_x[1]);
+                        kmer.forward = (fwd <= rc);
+                        kmer.kmer = (kmer.forward) ? fwd : rc;
+                    }
+                    else
+                    {
+                        kmer.forward = (_x[0] <= _x[1]);
+                        kmer.kmer = (kmer.forward) ? _x[0] : _x[1];
+                    }
+                    kmer.end = _blockStart + _blockPos;
+                    return true;
+                }
+            }
+        }
+
+        // Reset will move the scanner back to the start of the sequence.
+        void Reset(void);
+
+        // iterator allows a KmerScanner to be used in a range-based for loop.
+        class iterator
+        {
+        public:
+            iterator(KmerScanner* scanner = nullptr)
+                : _scanner(scanner) { ++(*this); }
+            const Kmer& operator*() const { return _kmer; }
+            const Kmer* operator->() const { return &_kmer; }
+            iterator& operator++()
+            {
+                if (_scanner && !_scanner->Next(_kmer))
+                    _scanner = nullptr;
+                return *this;
+            }
+            bool operator!=(const iterator& other) const { return _scanner != other._scanner; }
+
+        private:
+            KmerScanner* _scanner; // the scanner being iterated (nullptr once exhausted)
+            Kmer _kmer;            // the current k-mer
+        };
+
+        // begin returns an iterator to the first k-mer.
+        iterator begin(void) { return iterator(this); }
+
+        // end returns an iterator past the last k-mer.
+        iterator end(void) { return iterator(); }
+
+    private:
+        bool _encodeBlock(void); // encodes the next block of bases, returning false if there are none left
+
+        // _getKSize returns the k-mer size (or seed span).
+        inline uint32_t _getKSize(void) const
+        {
+            if constexpr (K == 0)
+                return _kSize;
+            else
+                return K;
+        }
+
+        // _getKmerMask returns the mask to drop the oldest base from the forward k-mer.
+        inline kmer_t _getKmerMask(void) const
+        {
+            if constexpr (K == 0)
+                return _kmerMask;
+            else
+                return GetKmerMask<K>();
+        }
+
+        // _getBitShift returns the shift to add a base to the reverse complement k-mer.
+        inline uint32_t _getBitShift(void) const
+        {
+            if constexpr (K == 0)
+                return _bitShift;
+            else
+                return 2 * (K - 1);
+        }
+
+        const char* _seq;                // the sequence being scanned
+        uint32_t _seqLen;                // the length of the sequence
+        uint32_t _kSize;                 // the k-mer size (the seed span if using a spaced seed)
+        const SpacedSeed* _seed;         // the spaced seed to sample k-mers with (nullptr for contiguous k-mers)
+        baseEncoder_t _encoder;          // the kernel used to encode bases
+        kmer_t _kmerMask;                // mask to drop the oldest base from the forward k-mer (runtime k-mer size only)
+        uint32_t _bitShift;              // shift to add a base to the reverse complement k-mer (runtime k-mer size only)
+        kmer_t _x[2];                    // the current forward and reverse complement k-mers
+        uint32_t _l;                     // the number of bases added to the current k-mer
+        uint32_t _blockStart;            // the sequence position of the current block
+        uint32_t _blockLen;              // the number of bases in the current block
+        uint32_t _blockPos;              // the position within the current block
+        uint8_t _codes[KMER_BLOCK_SIZE]; // the 2-bit encoded bases of the current block
+    };
+
+    // KmerScanner constructor.
+    template <uint32_t K>
+    KmerScanner<K>::KmerScanner(const char* seq, uint32_t seqLen, uint32_t kSize)
+        : KmerScanner(seq, seqLen, kSize, GetKmerKernel())
+    {
+    }
+
+    // KmerScanner constructor.
+    template <uint32_t K>
+    KmerScanner<K>::KmerScanner(const char* seq, uint32_t seqLen, uint32_t kSize, KmerKernel kernel)
+        : _seq(seq), _seqLen(seqLen), _kSize(kSize), _seed(nullptr), _encoder(GetBaseEncoder(kernel))
+    {
+        if (kSize > MAX_K_SIZE)
+            throw std::runtime_error("k-mer size must be <= " + std::to_string(MAX_K_SIZE));
+        if (K != 0 && kSize != K)
+            throw std::runtime_error("k-mer size does not match the scanner (" + std::to_string(K) + ")");
+        _kmerMask = (kSize == MAX_K_SIZE) ? ~0ULL : (1ULL << (2 * kSize)) - 1;
+        _bitShift = 2 * (kSize - 1);
+        Reset();
+    }
+
+    // KmerScanner constructor (samples k-mers with a spaced seed, contiguous seeds are scanned as plain k-mers).
+    template <uint32_t K>
+    KmerScanner<K>::KmerScanner(const char* seq, uint32_t seqLen, const SpacedSeed& seed)
+        : KmerScanner(seq, seqLen, seed.GetSpan(), GetKmerKernel())
+    {
+        if (!seed.IsContiguous())
+            _seed = &seed;
+    }
+
+    // Reset will move the scanner back to the start of the sequence.
+    template <uint32_t K>
+    void KmerScanner<K>::Reset(void)
+    {
+        _x[0] = _x[1] = 0;
+        _l = 0;
+        _blockStart = 0;
+        _blockLen = 0;
+        _blockPos = 0;
+    }
+
+    // _encodeBlock encodes the next block of bases, returning false if there are none left.
+    template <uint32_t K>
+    bool KmerScanner<K>::_encodeBlock(void)
+    {
+        _blockStart += _blockLen;
+        if (_blockStart >= _seqLen)
+        {
+            _blockLen = 0;
+            _blockPos = 0;
+            return false;
+        }
+        _blockLen = std::min(KMER_BLOCK_SIZE, _seqLen - _blockStart);
+        _blockPos = 0;
+        _encoder(_seq + _blockStart, _blockLen, _codes);
+        return true;
+    }
+
+    // SyncmerType is the type of syncmer to sample.
+    enum class SyncmerType
+    {
+        open,  // the smallest s-mer is at a set offset in the k-mer
+        closed // the smallest s-mer is at the start or end of the k-mer
+    };
+
+    // HashKmer returns an invertible hash of an encoded k-mer, used to order k-mers and s-mers when sampling (K fixes the k-mer size at compile time, 0 uses kSize).
+    template <uint32_t K = 0>
+    inline uint64_t HashKmer(kmer_t kmer, uint32_t kSize)
+    {
+        uint64_t mask;
+        if constexpr (K == 0)
+            mask = (kSize >= MAX_K_SIZE) ? ~0ULL : (1ULL << (2 * kSize)) - 1;
+        else
+            mask = GetKmerMask<K>();
+        kmer = (~kmer + (kmer << 21)) & mask;
+        kmer = kmer ^ kmer >> 24;
+        kmer = ((kmer + (kmer << 3)) + (kmer << 8)) & mask;
+        kmer = kmer ^ kmer >> 14;
+        kmer = ((kmer + (kmer << 2)) + (kmer << 4)) & mask;
+        kmer = kmer ^ kmer >> 28;
+        kmer = (kmer + (kmer << 31)) & mask;
+        return kmer;
+    }
+
+    // GetMinimizers will add the (w,k)-minimizers of a sequence to the provided container (the k-mer with the smallest hash in each window of w k-mers).
+    void GetMinimizers(const char* seq, uint32_t seqLen, uint32_t kSize, uint32_t wSize, std::vector<Kmer>& minimizers);
+
+    // GetSyncmers will add the open or closed syncmers of a sequence to the provided container (k-mers whose smallest s-mer is at the offset, or either end if closed).
+    void GetSyncmers(const char* seq, uint32_t seqLen, uint32_t kSize, uint32_t sSize, SyncmerType type, std::vector<Kmer>& syncmers, uint32_t offset = 0);
+
 } // namespace artic
 
 #endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include <algorithm>
+
+#include "primerKmerIndex.hpp"
+
+// PrimerKmerIndex constructor (an empty index).
+artic::PrimerKmerIndex::PrimerKmerIndex(void)
+    : _kSize(0), _numShared(0)
+{
+}
+
+// PrimerKmerIndex constructor (builds the index from the primers in a scheme).
+artic::PrimerKmerIndex::PrimerKmerIndex(const artic::PrimerScheme& primerScheme, const artic::RefStore& reference, uint32_t kSize)
+    : _kSize(kSize), _numShared(0)
+{
+    artic::kmermap_t kmerMap;
+    primerScheme.GetPrimerKmers(reference, kSize, kmerMap);
+    _build(kmerMap, _getStrands(primerScheme, reference, artic::SpacedSeed(std::string(kSize, '1'))));
+}
+
+// PrimerKmerIndex constructor (builds the index from the primers in a scheme, using spaced seed k-mers).
+artic::PrimerKmerIndex::PrimerKmerIndex(const artic::PrimerScheme& primerScheme, const artic::RefStore& reference, const artic::SpacedSeed& seed)
+    : _kSize(seed.GetWeight()), _numShared(0)
+{
+    artic::kmermap_t kmerMap;
+    primerScheme.GetPrimerKmers(reference, seed, kmerMap);
+    _build(kmerMap, _getStrands(primerScheme, reference, seed));
+}
+
+// PrimerKmerIndex constructor (builds the index from a primer k-mer map, as produced by PrimerScheme::GetPrimerKmers).
+artic::PrimerKmerIndex::PrimerKmerIndex(const artic::kmermap_t& kmerMap, uint32_t kSize)
+    : _kSize(kSize), _numShared(0)
+{
+    _build(kmerMap, {});
+}
+
+// GetKmerSize returns the k-mer size used by the index.
+uint32_t artic::PrimerKmerIndex::GetKmerSize(void) const { return _kSize; }
+
+// GetNumKmers returns the number of k-mers in the index.
+std::size_t artic::PrimerKmerIndex::GetNumKmers(void) const { return _kmers.GetEntries().size(); }
+
+// GetNumShared returns the number of primer k-mers that were dropped as they are shared by amplicons.
+std::size_t artic::PrimerKmerIndex::GetNumShared(void) const { return _numShared; }
+
+// GetMemoryUsage returns the number of bytes used by the index.
+std::size_t artic::PrimerKmerIndex::GetMemoryUsage(void) const { return _kmers.GetMemoryUsage(); }
+
+// _build builds the index from a primer k-mer map, with the reference strand of each k-mer (k-mers without a strand are taken as forward).
+void artic::PrimerKmerIndex::_build(const artic::kmermap_t& kmerMap, const std::unordered_map<kmer_t, bool>& strands)
+{
+    if (_kSize == 0 || _kSize > MAX_K_SIZE)
+        throw std::runtime_error("k-mer size must be > 0 and <= " + std::to_string(MAX_K_SIZE));
+
+    // keep the k-mers that are unique to one amplicon
+    std::vector<entry> entries;
+    entries.reserve(kmerMap.size());
+    for (const auto& kmer : kmerMap)
+    {
+        if (kmer.second.empty())
+            continue;
+        auto ampliconID = kmer.second.front();
+        if (std::any_of(kmer.second.begin(), kmer.second.end(), [ampliconID](unsigned int id) { return id != ampliconID; }))
+        {
+            _numShared++;
+            continue;
+        }
+        if (ampliconID == NO_AMPLICON || ampliconID > UINT16_MAX)
+            throw std::runtime_error("invalid amplicon ID in primer k-mer map: " + std::to_string(ampliconID));
+        auto strand = strands.find(kmer.first);
+        entries.push_back({kmer.first, uint16_t(ampliconID), (strand != strands.end()) ? strand->second : true});
+    }
+    _kmers = artic::KmerTable<entry>(std::move(entries), _kSize);
+}
+
+// _getStrands gets the reference strand of each primer k-mer, by scanning the primers (which are fetched from the reference strand).
+std::unordered_map<artic::kmer_t, bool> artic::PrimerKmerIndex::_getStrands(const artic::PrimerScheme& primerScheme, const artic::RefStore& reference, const artic::SpacedSeed& seed) const
+{
+    std::unordered_map<kmer_t, bool> strands;
+    std::string seq;
+    for (const auto& amplicon : primerScheme.GetExpAmplicons())
+    {
+        for (auto primer : {amplicon.GetForwardPrimer(), amplicon.GetReversePrimer()})
+        {
+            primer->GetSeq(reference, primerScheme.GetReferenceName(), seq);
+            for (const auto& kmer : artic::KmerScanner(seq.c_str(), seq.size(), seed))
+                strands[kmer.kmer] = kmer.forward;
+        }
+    }
+    return strands;
+}
@@ -0,0 +1,91 @@
+#ifndef PRIMERKMERINDEX_H
+#define PRIMERKMERINDEX_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "kmerTable.hpp"
+#include "kmers.hpp"
+#include "primerScheme.hpp"
+#include "refStore.hpp"
+
+namespace artic
+{
+    // NO_AMPLICON is returned by the primer k-mer index when a k-mer is not found (amplicon IDs start at 1).
+    const uint16_t NO_AMPLICON = 0;
+
+    //******************************************************************************
+    // PrimerKmerIndex is a static lookup of primer k-mers to the amplicon they came from.
+    //
+    // NOTES:
+    // * only k-mers unique to a single amplicon are kept, shared k-mers are dropped
+    // * when built from a scheme, each k-mer also records if its canonical form is on the reference strand,
+    //   so a read hit can tell which strand the read came from
+    // * the k-mers are held in a KmerTable, so the index is read-only once built and can be shared between threads
+    //******************************************************************************
+    class PrimerKmerIndex
+    {
+    public:
+        // PrimerKmerIndex constructor (an empty index).
+        PrimerKmerIndex(void);
+
+        // PrimerKmerIndex constructor (builds the index from the primers in a scheme).
+        PrimerKmerIndex(const PrimerScheme& primerScheme, const RefStore& reference, uint32_t kSize);
+
+        // PrimerKmerIndex constructor (builds the index from the primers in a scheme, using spaced seed k-mers).
+        PrimerKmerIndex(const PrimerScheme& primerScheme, const RefStore& reference, const SpacedSeed& seed);
+
+        // PrimerKmerIndex constructor (builds the index from a primer k-mer map, as produced by PrimerScheme::GetPrimerKmers).
+        PrimerKmerIndex(const kmermap_t& kmerMap, uint32_t kSize);
+
+        // GetKmerSize returns the k-mer size used by the index.
+        uint32_t GetKmerSize(void) const;
+
+        // GetNumKmers returns the number of k-mers in the index.
+        std::size_t GetNumKmers(void) const;
+
+        // GetNumShared returns the number of primer k-mers that were dropped as they are shared by amplicons.
+        std::size_t GetNumShared(void) const;
+
+        // GetMemoryUsage returns the number of bytes used by the index.
+        std::size_t GetMemoryUsage(void) const;
+
+        // Find returns the amplicon ID for a k-mer, or NO_AMPLICON if the k-mer is not in the index (K fixes the index k-mer size at compile time, 0 uses it at runtime).
+        template <uint32_t K = 0>
+        inline uint16_t Find(kmer_t kmer) const
+        {
+            auto entry = _kmers.Find<K>(kmer);
+            return (entry) ? entry->ampliconID : NO_AMPLICON;
+        }
+
+        // Find returns the amplicon ID for a k-mer, or NO_AMPLICON if the k-mer is not in the index (forward is set to true if the canonical k-mer is on the reference strand).
+        template <uint32_t K = 0>
+        inline uint16_t Find(kmer_t kmer, bool& forward) const
+        {
+            auto entry = _kmers.Find<K>(kmer);
+            if (!entry)
+                return NO_AMPLICON;
+            forward = entry->forward;
+            return entry->ampliconID;
+        }
+
+    private:
+        // entry is a primer k-mer and its amplicon ID.
+        struct entry
+        {
+            kmer_t kmer;         // the canonical primer k-mer
+            uint16_t ampliconID; // the amplicon the k-mer came from
+            bool forward;        // true if the canonical k-mer is on the reference strand (always true if built from a k-mer map)
+        };
+
+        void _build(const kmermap_t& kmerMap, const std::unordered_map<kmer_t, bool>& strands);                                                  // builds the index from a primer k-mer map
+        std::unordered_map<kmer_t, bool> _getStrands(const PrimerScheme& primerScheme, const RefStore& reference, const SpacedSeed& seed) const; // gets the reference strand of each primer k-mer
+
+        uint32_t _kSize;         // the k-mer size
+        std::size_t _numShared;  // the number of shared primer k-mers that were dropped
+        KmerTable<entry> _kmers; // the primer k-mers
+    };
+
+} // namespace artic
+
+#endif
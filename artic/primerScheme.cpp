@@ -2,12 +2,16 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <rapidcsv.h>
 #include <stdexcept>
 #include <string>
 
 #include "primerScheme.hpp"
 
+// CURSOR_MAX_STEPS is the number of primer locations a PrimerCursor will step over before using a binary search.
+const std::size_t CURSOR_MAX_STEPS = 16;
+
 // ARTIC scheme tags
 const std::string LEFT_PRIMER_TAG = "_LEFT";
 const std::string RIGHT_PRIMER_TAG = "_RIGHT";
@@ -79,7 +83,7 @@ std::string artic::Primer::GetBaseID(void) const { return _primerID.substr(0, _b
 size_t artic::Primer::GetPrimerPoolID(void) const { return _poolID; }
 
 // IsForward returns the primer direction (true = forward, false = reverse).
-bool artic::Primer::IsForward(void) { return _isForward; }
+bool artic::Primer::IsForward(void) const { return _isForward; }
 
 // GetSeq returns the primer sequence from a reference.
 void artic::Primer::GetSeq(faidx_t* reference, const std::string& refID, std::string& primerSeq) const
@@ -102,6 +106,13 @@ void artic::Primer::GetSeq(faidx_t* reference, const std::string& refID, std::st
     return;
 }
 
+// GetSeq returns the primer sequence from a packed reference.
+void artic::Primer::GetSeq(const artic::RefStore& reference, const std::string& refID, std::string& primerSeq) const
+{
+    reference.GetSeq(refID, _start, _end, primerSeq);
+    return;
+}
+
 // PrimerScheme constructor.
 artic::PrimerScheme::PrimerScheme(const std::string& inputFile)
     : _filename(inputFile)
@@ -110,6 +121,14 @@ artic::PrimerScheme::PrimerScheme(const std::string& inputFile)
     _validateScheme();
 }
 
+// PrimerScheme constructor (from a builtin scheme).
+artic::PrimerScheme::PrimerScheme(const BuiltinScheme& builtinScheme)
+    : _filename(builtinScheme.name)
+{
+    _loadScheme(builtinScheme);
+    _validateScheme();
+}
+
 // PrimerScheme destructor.
 artic::PrimerScheme::~PrimerScheme(void) {}
 
@@ -120,28 +139,28 @@ const std::string& artic::PrimerScheme::GetFileName(void) const { return _filena
 const std::string& artic::PrimerScheme::GetReferenceName(void) const { return _referenceID; }
 
 // GetNumPrimers returns the number of primers in the primer scheme.
-unsigned int artic::PrimerScheme::GetNumPrimers(void) { return _numPrimers; }
+unsigned int artic::PrimerScheme::GetNumPrimers(void) const { return _numPrimers; }
 
 // GetMinPrimerLen returns the minimum primer length in the scheme.
-unsigned int artic::PrimerScheme::GetMinPrimerLen(void) { return _minPrimerLen; }
+unsigned int artic::PrimerScheme::GetMinPrimerLen(void) const { return _minPrimerLen; }
 
 // GetMaxPrimerLen returns the maximum primer length in the scheme.
-unsigned int artic::PrimerScheme::GetMaxPrimerLen(void) { return _maxPrimerLen; }
+unsigned int artic::PrimerScheme::GetMaxPrimerLen(void) const { return _maxPrimerLen; }
 
 // GetNumAlts returns the number of alts in the primer scheme.
-unsigned int artic::PrimerScheme::GetNumAlts(void) { return _numAlts; }
+unsigned int artic::PrimerScheme::GetNumAlts(void) const { return _numAlts; }
 
 // GetNumAmplicons returns the number of primers in the primer scheme (after alts are merged).
-unsigned int artic::PrimerScheme::GetNumAmplicons(void) { return _numAmplicons; }
+unsigned int artic::PrimerScheme::GetNumAmplicons(void) const { return _numAmplicons; }
 
 // GetMeanAmpliconSpan returns the mean amplicon span (including primer sequence).
-unsigned int artic::PrimerScheme::GetMeanAmpliconSpan(void) { return _meanAmpliconSpan; }
+unsigned int artic::PrimerScheme::GetMeanAmpliconSpan(void) const { return _meanAmpliconSpan; }
 
 // GetMaxAmpliconSpan returns the max amplicon span (including primer sequence).
-unsigned int artic::PrimerScheme::GetMaxAmpliconSpan(void) { return _maxAmpliconSpan; }
+unsigned int artic::PrimerScheme::GetMaxAmpliconSpan(void) const { return _maxAmpliconSpan; }
 
 // GetPrimerPools returns the primer pools found in the primer scheme.
-std::vector<std::string> artic::PrimerScheme::GetPrimerPools(void) { return std::vector<std::string>(_primerPools.begin() + 1, _primerPools.end()); }
+std::vector<std::string> artic::PrimerScheme::GetPrimerPools(void) const { return std::vector<std::string>(_primerPools.begin() + 1, _primerPools.end()); }
 
 // GetPrimerPool returns the primer pool for the provided pool ID.
 const std::string& artic::PrimerScheme::GetPrimerPool(size_t poolID) const
@@ -162,19 +181,19 @@ size_t artic::PrimerScheme::GetPrimerPoolID(const std::string& poolName) const
 }
 
 // GetRefStart returns the first position in the reference covered by the primer scheme.
-int64_t artic::PrimerScheme::GetRefStart(void) { return _refStart; }
+int64_t artic::PrimerScheme::GetRefStart(void) const { return _refStart; }
 
 // GetRefEnd returns the last position in the reference covered by the primer scheme.
-int64_t artic::PrimerScheme::GetRefEnd(void) { return _refEnd; }
+int64_t artic::PrimerScheme::GetRefEnd(void) const { return _refEnd; }
 
 // GetNumOverlaps returns the number of reference positions covered by more than one amplicon.
-unsigned int artic::PrimerScheme::GetNumOverlaps(void) { return _ampliconOverlaps.count(); }
+unsigned int artic::PrimerScheme::GetNumOverlaps(void) const { return _numOverlaps; }
 
 // GetExpAmplicons returns a vector to the amplicons the scheme expects to produce.
-const std::vector<artic::Amplicon>& artic::PrimerScheme::GetExpAmplicons(void) { return _expAmplicons; }
+const std::vector<artic::Amplicon>& artic::PrimerScheme::GetExpAmplicons(void) const { return _expAmplicons; }
 
 // GetAmpliconName returns a string name for an amplicon in the scheme, based on the provided amplicon int ID.
-const std::string artic::PrimerScheme::GetAmpliconName(unsigned int id)
+const std::string artic::PrimerScheme::GetAmpliconName(unsigned int id) const
 {
     if (id == 0)
         return "unassigned";
@@ -184,7 +203,7 @@ const std::string artic::PrimerScheme::GetAmpliconName(unsigned int id)
 }
 
 // GetAmplicon returns an amplicon from the scheme, based on the provided amplicon int ID.
-const artic::Amplicon& artic::PrimerScheme::GetAmplicon(unsigned int id)
+const artic::Amplicon& artic::PrimerScheme::GetAmplicon(unsigned int id) const
 {
     if (id == 0)
         throw std::runtime_error("provided an unassigned amplicon ID");
@@ -193,92 +212,132 @@ const artic::Amplicon& artic::PrimerScheme::GetAmplicon(unsigned int id)
     return _expAmplicons.at(id - 1);
 }
 
-// FindPrimers returns a primer pair with the nearest forward and reverse primer for a given segment start and end.
-// Note: the primer pair may not be correctly paired, check using the IsProperlyPaired() method
-artic::Amplicon artic::PrimerScheme::FindPrimers(int64_t segStart, int64_t segEnd)
+// nearestPrimer returns the primer location closest to pos, given the index of the first location >= pos.
+// Ties go to the location at or after pos.
+static const artic::Primer* nearestPrimer(const std::vector<std::pair<int64_t, const artic::Primer*>>& locations, std::size_t index, int64_t pos)
 {
+    if (index == locations.size())
+        return locations.back().second;
+    if (index == 0)
+        return locations.front().second;
+    if (std::abs(locations[index].first - pos) <= std::abs(locations[index - 1].first - pos))
+        return locations[index].second;
+    return locations[index - 1].second;
+}
 
-    // get the nearest forward primer start
-    std::string fPrimerID;
-    std::vector<std::pair<int64_t, std::string>>::iterator fIterator;
-    fIterator = std::lower_bound(_fPrimerLocations.begin(), _fPrimerLocations.end(), std::pair<int64_t, std::string>(segStart, {}));
-    if (std::abs(int(fIterator->first - segStart)) <= std::abs(int(std::prev(fIterator, 1)->first - segStart)))
-    {
-        fPrimerID = fIterator->second;
-    }
-    else
-    {
-        fPrimerID = (std::prev(fIterator, 1))->second;
-    }
+// lowerBound returns the index of the first primer location >= pos, searching from the provided index.
+static std::size_t lowerBound(const std::vector<std::pair<int64_t, const artic::Primer*>>& locations, std::size_t from, int64_t pos)
+{
+    auto it = std::lower_bound(locations.begin() + from, locations.end(), pos, [](const std::pair<int64_t, const artic::Primer*>& loc, int64_t p) {
+        return loc.first < p;
+    });
+    return it - locations.begin();
+}
 
-    // get the nearest reverse primer end
-    std::string rPrimerID;
-    std::vector<std::pair<int64_t, std::string>>::iterator rIterator;
-    rIterator = std::lower_bound(_rPrimerLocations.begin(), _rPrimerLocations.end(), std::pair<int64_t, std::string>(segEnd, {}));
-    if (std::abs(int(rIterator->first - segEnd)) <= std::abs(int(std::prev(rIterator, 1)->first - segEnd)))
-    {
-        rPrimerID = rIterator->second;
-    }
-    else
+// seekPrimer moves a cursor index from the first primer location >= lastPos to the first primer location >= pos.
+// It steps through the locations when pos is close to lastPos, otherwise it uses a binary search.
+static std::size_t seekPrimer(const std::vector<std::pair<int64_t, const artic::Primer*>>& locations, std::size_t index, int64_t lastPos, int64_t pos)
+{
+    if (pos >= lastPos)
     {
-        rPrimerID = (std::prev(rIterator, 1))->second;
+        for (std::size_t step = 0; step < CURSOR_MAX_STEPS; ++step, ++index)
+            if ((index == locations.size()) || (locations[index].first >= pos))
+                return index;
+        return lowerBound(locations, index, pos);
     }
+    for (std::size_t step = 0; step < CURSOR_MAX_STEPS; ++step, --index)
+        if ((index == 0) || (locations[index - 1].first < pos))
+            return index;
+    return lowerBound(locations, 0, pos);
+}
 
-    // lookup the primers in the scheme
-    primermap_t::iterator i = _fPrimers.find(fPrimerID);
-    primermap_t::iterator j = _rPrimers.find(rPrimerID);
-    if ((i == _fPrimers.end()) || (j == _rPrimers.end()))
-        throw std::runtime_error("primer dropped from scheme - " + fPrimerID + " & " + rPrimerID);
+// FindPrimers returns a primer pair with the nearest forward and reverse primer for a given segment start and end.
+// Note: the primer pair may not be correctly paired, check using the IsProperlyPaired() method
+artic::Amplicon artic::PrimerScheme::FindPrimers(int64_t segStart, int64_t segEnd) const
+{
+    // get the nearest forward primer start and reverse primer end
+    const Primer* fPrimer = nearestPrimer(_fPrimerLocations, lowerBound(_fPrimerLocations, 0, segStart), segStart);
+    const Primer* rPrimer = nearestPrimer(_rPrimerLocations, lowerBound(_rPrimerLocations, 0, segEnd), segEnd);
 
     // return an amplicon with no ID (0) as this is not guarenteed to be an expected scheme amplicon
-    return Amplicon(&i->second, &j->second);
+    return Amplicon(fPrimer, rPrimer);
 }
 
+// GetPrimerCursor returns a cursor for finding primers for alignment segments that arrive in coordinate order.
+artic::PrimerCursor artic::PrimerScheme::GetPrimerCursor(void) const { return PrimerCursor(this); }
+
 // CheckAmpliconOverlap returns true if the queried position is covered by multiple primers.
-bool artic::PrimerScheme::CheckAmpliconOverlap(int64_t pos)
+bool artic::PrimerScheme::CheckAmpliconOverlap(int64_t pos) const
 {
     if ((_refStart > pos) || (_refEnd < pos))
         throw std::runtime_error("query position outside of primer scheme bounds");
-    return _ampliconOverlaps.test(pos);
+    return _positions[pos - _refStart].IsOverlap();
 }
 
 // CheckPrimerSite returns true if the queried position is within a primer site of the scheme (either pool).
-// TODO: this currently has primer sites stored by pools - probably not necessary as we don't use that info,
-// just the primer locations for the whole scheme.
-bool artic::PrimerScheme::CheckPrimerSite(int64_t pos)
+bool artic::PrimerScheme::CheckPrimerSite(int64_t pos) const
 {
     if ((_refStart > pos) || (_refEnd < pos))
         throw std::runtime_error("query position outside of primer scheme bounds");
-    return _primerSites.test(pos);
+    return _positions[pos - _refStart].IsPrimerSite();
+}
+
+// GetPosition returns the scheme annotation for a reference position, or an empty annotation if outside the scheme bounds.
+const artic::SchemePosition& artic::PrimerScheme::GetPosition(int64_t pos) const
+{
+    static const SchemePosition outOfBounds{0, 0, 0};
+    if ((_refStart > pos) || (_refEnd < pos))
+        return outOfBounds;
+    return _positions[pos - _refStart];
+}
+
+// AnnotatePositions fills the provided vector with the scheme annotation of each queried position.
+// Positions outside of the scheme bounds get an empty annotation. The queried positions should be
+// sorted so that the track is read sequentially, but unsorted positions will still be annotated.
+void artic::PrimerScheme::AnnotatePositions(const std::vector<int64_t>& positions, std::vector<SchemePosition>& annotations) const
+{
+    annotations.resize(positions.size());
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        auto pos = positions[i];
+        annotations[i] = ((_refStart > pos) || (_refEnd < pos)) ? SchemePosition{0, 0, 0} : _positions[pos - _refStart];
+    }
 }
 
 // GetPrimerKmers will int encode k-mers from all primers in the scheme and deposit them in the provided map, linked to their amplicon primer origin(s).
-void artic::PrimerScheme::GetPrimerKmers(const std::string& reference, uint32_t kSize, artic::kmermap_t& kmerMap)
+void artic::PrimerScheme::GetPrimerKmers(const std::string& reference, uint32_t kSize, artic::kmermap_t& kmerMap) const
 {
     if (reference.size() == 0)
         throw std::runtime_error("no reference sequence provided, can't output primer sequences");
+    GetPrimerKmers(artic::RefStore(reference), kSize, kmerMap);
+    return;
+}
+
+// GetPrimerKmers will int encode k-mers from all primers in the scheme using a packed reference.
+void artic::PrimerScheme::GetPrimerKmers(const artic::RefStore& reference, uint32_t kSize, artic::kmermap_t& kmerMap) const
+{
     if (kSize > _minPrimerLen)
         throw std::runtime_error("requested k-mer size is greater than the shortest primer in the scheme (" + std::to_string(_minPrimerLen) + ")");
+    GetPrimerKmers(reference, artic::SpacedSeed(std::string(kSize, '1')), kmerMap);
+    return;
+}
+
+// GetPrimerKmers will int encode spaced seed k-mers from all primers in the scheme using a packed reference.
+void artic::PrimerScheme::GetPrimerKmers(const artic::RefStore& reference, const artic::SpacedSeed& seed, artic::kmermap_t& kmerMap) const
+{
+    if (seed.GetSpan() > _minPrimerLen)
+        throw std::runtime_error("requested seed span is greater than the shortest primer in the scheme (" + std::to_string(_minPrimerLen) + ")");
     std::string seq;
-    artic::kmerset_t kmers;
-    faidx_t* fai = fai_load(reference.c_str());
-    for (auto amplicon : GetExpAmplicons())
+    for (const auto& amplicon : _expAmplicons)
     {
-        // get the forward and reverse primer seqs, int encode them and add them to the set
-        amplicon.GetForwardPrimer()->GetSeq(fai, _referenceID, seq);
-        artic::GetEncodedKmers(seq.c_str(), seq.size(), kSize, kmers);
-        seq.clear();
-        amplicon.GetReversePrimer()->GetSeq(fai, _referenceID, seq);
-        artic::GetEncodedKmers(seq.c_str(), seq.size(), kSize, kmers);
-        seq.clear();
-
-        // add each kmer to the map and link it to the amplicon
-        for (auto kmer : kmers)
-            kmerMap[kmer].emplace_back(amplicon.GetID());
-        kmers.clear();
+        // get the forward and reverse primer seqs from the packed reference and add each k-mer to the map, linked to the amplicon
+        for (auto primer : {amplicon.GetForwardPrimer(), amplicon.GetReversePrimer()})
+        {
+            primer->GetSeq(reference, _referenceID, seq);
+            for (const auto& kmer : artic::KmerScanner(seq.c_str(), seq.size(), seed))
+                kmerMap[kmer.kmer].emplace_back(amplicon.GetID());
+        }
     }
-    if (fai)
-        fai_destroy(fai);
     return;
 }
 
@@ -311,68 +370,15 @@ void artic::PrimerScheme::_loadScheme(const std::string& filename)
         std::vector<std::string> row = scheme.GetRow<std::string>(rowIterator);
 
         // check we don't have multiple references used in the scheme
-        if (!_referenceID.empty())
-        {
-            if (row[0] != _referenceID)
-                throw std::runtime_error("multiple reference sequences can't be used in primer scheme");
-        }
-        else
-        {
-            _referenceID = row[0];
-        }
+        _checkReference(row[0]);
 
         // add the primer pool to the scheme and get a lookup int for the primers
-        size_t poolID = 0;
-        std::vector<std::string>::iterator poolItr = std::find(_primerPools.begin(), _primerPools.end(), row[4]);
-        if (poolItr != _primerPools.end())
-        {
-            poolID = poolItr - _primerPools.begin();
-        }
-        else
-        {
-            // store the primer pool name
-            _primerPools.emplace_back(row[4]);
-            poolID = _primerPools.size() - 1;
-        }
+        size_t poolID = _addPrimerPool(row[4]);
 
         // try converting the primer scheme row into a primer object
         try
         {
-            Primer primer(std::stoi(row[1]), std::stoi(row[2]), row[3], poolID);
-
-            // increment the raw primer counter
-            _numPrimers++;
-
-            // chomp off any alt tag to get the canonical primer ID
-            std::string canonicalID = row[3].substr(0, row[3].find(ALT_PRIMER_TAG));
-
-            // check to see if this primer or an alt has not been seen before and then add it to the forward/reverse map
-            if (primer.IsForward())
-            {
-                primermap_t::iterator i = _fPrimers.find(canonicalID);
-                if (i == _fPrimers.end())
-                {
-                    _fPrimers.emplace(canonicalID, primer);
-                    continue;
-                }
-
-                // otherwise, the primer has been seen before so it's an alt that needs merging
-                i->second.MergeAlt(primer);
-                _numAlts++;
-            }
-            else
-            {
-                primermap_t::iterator j = _rPrimers.find(canonicalID);
-                if (j == _rPrimers.end())
-                {
-                    _rPrimers.emplace(canonicalID, primer);
-                    continue;
-                }
-
-                // otherwise, the primer has been seen before so it's an alt that needs merging
-                j->second.MergeAlt(primer);
-                _numAlts++;
-            }
+            _addPrimer(Primer(std::stoi(row[1]), std::stoi(row[2]), row[3], poolID));
         }
         catch (const std::exception& e)
         {
@@ -392,6 +398,71 @@ void artic::PrimerScheme::_loadScheme(const std::string& filename)
         throw std::runtime_error("primer count does not equal the number of rows in the input file - " + std::to_string(_numPrimers) + " vs " + std::to_string(rowCount));
 }
 
+// _loadScheme will create the primer objects from a builtin scheme.
+// NOTE: builtin rows were checked when they were embedded, so any primer errors here are fatal
+void artic::PrimerScheme::_loadScheme(const BuiltinScheme& builtinScheme)
+{
+    _numPrimers = 0;
+    _numAlts = 0;
+    _primerPools.emplace_back(NO_POOL);
+    for (std::size_t rowIterator = 0; rowIterator < builtinScheme.numPrimers; ++rowIterator)
+    {
+        const BuiltinPrimer& row = builtinScheme.primers[rowIterator];
+        _checkReference(std::string(row.refID));
+        size_t poolID = _addPrimerPool(std::string(row.pool));
+        _addPrimer(Primer(row.start, row.end, std::string(row.primerID), poolID));
+    }
+    if (_numPrimers != builtinScheme.numPrimers)
+        throw std::runtime_error("primer count does not equal the number of rows in the builtin scheme - " + std::to_string(_numPrimers) + " vs " + std::to_string(builtinScheme.numPrimers));
+}
+
+// _checkReference will record the scheme reference ID, or check it matches the existing one.
+void artic::PrimerScheme::_checkReference(const std::string& refID)
+{
+    if (_referenceID.empty())
+    {
+        _referenceID = refID;
+        return;
+    }
+    if (refID != _referenceID)
+        throw std::runtime_error("multiple reference sequences can't be used in primer scheme");
+}
+
+// _addPrimerPool will add a primer pool to the scheme (if it is new) and return its ID.
+size_t artic::PrimerScheme::_addPrimerPool(const std::string& poolName)
+{
+    std::vector<std::string>::iterator poolItr = std::find(_primerPools.begin(), _primerPools.end(), poolName);
+    if (poolItr != _primerPools.end())
+        return poolItr - _primerPools.begin();
+
+    // store the primer pool name
+    _primerPools.emplace_back(poolName);
+    return _primerPools.size() - 1;
+}
+
+// _addPrimer will add a primer to the scheme, merging it if it's an alt.
+void artic::PrimerScheme::_addPrimer(const Primer& primer)
+{
+    // increment the raw primer counter
+    _numPrimers++;
+
+    // chomp off any alt tag to get the canonical primer ID
+    std::string canonicalID = primer.GetName().substr(0, primer.GetName().find(ALT_PRIMER_TAG));
+
+    // check to see if this primer or an alt has not been seen before and then add it to the forward/reverse map
+    primermap_t& primers = (primer.IsForward()) ? _fPrimers : _rPrimers;
+    primermap_t::iterator i = primers.find(canonicalID);
+    if (i == primers.end())
+    {
+        primers.emplace(canonicalID, primer);
+        return;
+    }
+
+    // otherwise, the primer has been seen before so it's an alt that needs merging
+    i->second.MergeAlt(primer);
+    _numAlts++;
+}
+
 // _validateScheme will check all forward primers have a paired reverse primer and record some primer scheme stats.
 void artic::PrimerScheme::_validateScheme(void)
 {
@@ -420,15 +491,18 @@ void artic::PrimerScheme::_validateScheme(void)
         return lhs.GetForwardPrimer()->GetEnd() < rhs.GetForwardPrimer()->GetEnd();
     });
 
-    // update the min/max value of the scheme
+    // update the min/max value of the scheme and set up the annotation track
     _refStart = _expAmplicons.front().GetForwardPrimer()->GetStart();
     _refEnd = _expAmplicons.back().GetReversePrimer()->GetEnd();
-    _primerSites.resize(_refEnd, 0);
+    if (_primerPools.size() > 9)
+        throw std::runtime_error("too many primer pools in scheme (max 8) - " + std::to_string(_primerPools.size() - 1));
+    if (_numAmplicons > UINT16_MAX)
+        throw std::runtime_error("too many amplicons in scheme (max " + std::to_string(UINT16_MAX) + ")");
+    _positions.assign(_refEnd - _refStart + 1, SchemePosition{0, 0, 0});
 
     // loop through the expected amplicon list for the scheme and populate some scheme stats
     unsigned int ampliconID = 0;
     uint64_t spanCounter = 0;
-    _ampliconOverlaps.resize(_refEnd, 0);
     _minPrimerLen = 999;
     _maxPrimerLen = 0;
     for (artic::Amplicon& amplicon : _expAmplicons)
@@ -449,8 +523,8 @@ void artic::PrimerScheme::_validateScheme(void)
             _minPrimerLen = fP->GetLen();
         if (fP->GetLen() > _maxPrimerLen)
             _maxPrimerLen = fP->GetLen();
-        for (auto bitSetter = fP->GetStart(); bitSetter < fP->GetEnd(); bitSetter++)
-            _primerSites[bitSetter] = 1;
+        for (auto pos = fP->GetStart(); pos < fP->GetEnd(); pos++)
+            _positions[pos - _refStart].primerPools |= (1U << (fP->GetPrimerPoolID() - 1));
 
         // check reverse primer and record sites
         auto rP = amplicon.GetReversePrimer();
@@ -458,26 +532,39 @@ void artic::PrimerScheme::_validateScheme(void)
             _minPrimerLen = rP->GetLen();
         if (rP->GetLen() > _maxPrimerLen)
             _maxPrimerLen = rP->GetLen();
-        for (auto bitSetter = rP->GetStart(); bitSetter < rP->GetEnd(); bitSetter++)
-            _primerSites[bitSetter] = 1;
+        for (auto pos = rP->GetStart(); pos < rP->GetEnd(); pos++)
+            _positions[pos - _refStart].primerPools |= (1U << (rP->GetPrimerPoolID() - 1));
+
+        // record the amplicon owner (incl. primer sites) and coverage (excluding primer sites)
+        for (auto pos = fP->GetStart(); pos < rP->GetEnd(); pos++)
+        {
+            SchemePosition& site = _positions[pos - _refStart];
+            if (site.ampliconID == 0)
+                site.ampliconID = ampliconID;
+            if ((pos >= ampliconSE.first) && (pos < ampliconSE.second) && (site.coverage < UINT8_MAX))
+                site.coverage++;
+        }
 
         // add the primer sites to the lookups
-        _fPrimerLocations.emplace_back(fP->GetStart(), fP->GetName());
-        _rPrimerLocations.emplace_back(rP->GetEnd(), rP->GetName());
+        _fPrimerLocations.emplace_back(fP->GetStart(), fP);
+        _rPrimerLocations.emplace_back(rP->GetEnd(), rP);
 
-        // store the amplicon overlap regions (excluding primer sites)
+        // check for gaps between this amplicon and the next one
         if (ampliconID != _numAmplicons)
         {
             auto nextAmpliconBoundary = _expAmplicons.at(ampliconID).GetForwardPrimer()->GetEnd();
             if (rP->GetStart() < nextAmpliconBoundary)
                 throw std::runtime_error("gap found in primer scheme - " + std::to_string(rP->GetStart()) + "-" + std::to_string(nextAmpliconBoundary));
-
-            for (; nextAmpliconBoundary < rP->GetStart(); nextAmpliconBoundary++)
-                _ampliconOverlaps[nextAmpliconBoundary] = 1;
         }
     }
+    _numOverlaps = std::count_if(_positions.begin(), _positions.end(), [](const SchemePosition& p) { return p.IsOverlap(); });
     _meanAmpliconSpan = spanCounter / _numAmplicons;
 
+    // make sure the primer lookups are sorted by position so they can be searched
+    auto byPosition = [](const std::pair<int64_t, const Primer*>& lhs, const std::pair<int64_t, const Primer*>& rhs) { return lhs.first < rhs.first; };
+    std::stable_sort(_fPrimerLocations.begin(), _fPrimerLocations.end(), byPosition);
+    std::stable_sort(_rPrimerLocations.begin(), _rPrimerLocations.end(), byPosition);
+
     // basic checks
     if (_expAmplicons.size() != _numAmplicons || _numAmplicons != ampliconID)
         throw std::runtime_error("could not produce all expected amplicons from scheme");
@@ -490,7 +577,7 @@ void artic::PrimerScheme::_validateScheme(void)
 }
 
 // Amplicon constructor.
-artic::Amplicon::Amplicon(Primer* p1, Primer* p2)
+artic::Amplicon::Amplicon(const Primer* p1, const Primer* p2)
     : _fPrimer(p1), _rPrimer(p2)
 {
     // set ID to 0 (no ID) as this will be set by the scheme if needed
@@ -522,7 +609,7 @@ void artic::Amplicon::SetID(unsigned int id)
 }
 
 // IsProperlyPaired returns true if this primer is properly paired.
-bool artic::Amplicon::IsProperlyPaired(void) { return _isProperlyPaired; }
+bool artic::Amplicon::IsProperlyPaired(void) const { return _isProperlyPaired; }
 
 // GetName returns the name for the amplicon (combines primer IDs).
 const std::string artic::Amplicon::GetName(void) const { return std::string(_fPrimer->GetName() + "_" + _rPrimer->GetName()); }
@@ -531,7 +618,7 @@ const std::string artic::Amplicon::GetName(void) const { return std::string(_fPr
 unsigned int artic::Amplicon::GetID(void) const { return _id; }
 
 // GetPrimerPoolID returns the pool ID for the primer pair (0 returned if primers not properly paired).
-std::size_t artic::Amplicon::GetPrimerPoolID(void)
+std::size_t artic::Amplicon::GetPrimerPoolID(void) const
 {
     if (!_isProperlyPaired)
     {
@@ -541,20 +628,51 @@ std::size_t artic::Amplicon::GetPrimerPoolID(void)
 }
 
 // GetMaxSpan returns the start and end of the amplicon, including the primer sequence.
-std::pair<int64_t, int64_t> artic::Amplicon::GetMaxSpan(void) { return std::pair(_fPrimer->GetStart(), _rPrimer->GetEnd()); }
+std::pair<int64_t, int64_t> artic::Amplicon::GetMaxSpan(void) const { return std::pair(_fPrimer->GetStart(), _rPrimer->GetEnd()); }
 
 // GetMinSpan returns the start and end of the amplicon, excluding the primer sequence.
-std::pair<int64_t, int64_t> artic::Amplicon::GetMinSpan(void) { return std::pair(_fPrimer->GetEnd(), _rPrimer->GetStart()); }
+std::pair<int64_t, int64_t> artic::Amplicon::GetMinSpan(void) const { return std::pair(_fPrimer->GetEnd(), _rPrimer->GetStart()); }
 
 // GetForwardPrimer returns a pointer to the forward primer in the amplicon.
-const artic::Primer* artic::Amplicon::GetForwardPrimer(void) { return _fPrimer; }
+const artic::Primer* artic::Amplicon::GetForwardPrimer(void) const { return _fPrimer; }
 
 // GetReversePrimer returns a pointer to the reverse primer in the amplicon.
-const artic::Primer* artic::Amplicon::GetReversePrimer(void) { return _rPrimer; }
+const artic::Primer* artic::Amplicon::GetReversePrimer(void) const { return _rPrimer; }
 
 // AddKmers adds the k-mers from a sequence to the amplicon.
 void artic::Amplicon::AddKmers(const char* seq, uint32_t seqLen, uint32_t kSize)
 {
     artic::GetEncodedKmers(seq, seqLen, kSize, _kmers);
     return;
-}
\ No newline at end of file
+}
+
+// PrimerCursor constructor.
+artic::PrimerCursor::PrimerCursor(const PrimerScheme* primerScheme)
+    : _primerScheme(primerScheme)
+{
+    if (!_primerScheme)
+        throw std::runtime_error("primer cursor requires a primer scheme");
+    Reset();
+}
+
+// FindPrimers returns a primer pair with the nearest forward and reverse primer for a given segment start and end.
+// Note: the primer pair may not be correctly paired, check using the IsProperlyPaired() method
+artic::Amplicon artic::PrimerCursor::FindPrimers(int64_t segStart, int64_t segEnd)
+{
+    const auto& fLocations = _primerScheme->_fPrimerLocations;
+    const auto& rLocations = _primerScheme->_rPrimerLocations;
+    _fIndex = seekPrimer(fLocations, _fIndex, _lastStart, segStart);
+    _rIndex = seekPrimer(rLocations, _rIndex, _lastEnd, segEnd);
+    _lastStart = segStart;
+    _lastEnd = segEnd;
+    return Amplicon(nearestPrimer(fLocations, _fIndex, segStart), nearestPrimer(rLocations, _rIndex, segEnd));
+}
+
+// Reset moves the cursor back to the start of the scheme.
+void artic::PrimerCursor::Reset(void)
+{
+    _fIndex = 0;
+    _rIndex = 0;
+    _lastStart = std::numeric_limits<int64_t>::min();
+    _lastEnd = std::numeric_limits<int64_t>::min();
+}
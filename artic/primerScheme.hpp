@@ -1,25 +1,44 @@
 #ifndef PRIMERSCHEME_H
 #define PRIMERSCHEME_H
 
-#include <boost/dynamic_bitset.hpp>
 #include <htslib/faidx.h>
 #include <string>
 //#include <unordered_map>
 #include <vector>
 
+#include "builtinSchemes.hpp"
 #include "bytell_hash_map.hpp"
 #include "kmers.hpp"
+#include "refStore.hpp"
 
 namespace artic
 {
     class Primer;
     class PrimerScheme;
     class Amplicon;
+    class PrimerCursor;
     //typedef std::unordered_map<std::string, Primer> primermap_t;
     //typedef std::unordered_map<artic::kmer_t, std::vector<unsigned int>> kmermap_t;
     typedef ska::bytell_hash_map<std::string, Primer> primermap_t;
     typedef ska::bytell_hash_map<artic::kmer_t, std::vector<unsigned int>> kmermap_t;
 
+    // SchemePosition is the primer scheme annotation for a single reference position.
+    typedef struct SchemePosition
+    {
+        uint16_t ampliconID; // the first amplicon (by scheme order) whose span, including primers, covers the position (0 = none)
+        uint8_t coverage;    // the number of amplicons whose span, excluding primers, covers the position
+        uint8_t primerPools; // bit flags for the primer pools with a primer site at the position (bit 0 = pool ID 1)
+
+        // IsOverlap returns true if the position is covered by multiple amplicons.
+        bool IsOverlap(void) const { return coverage > 1; }
+
+        // IsPrimerSite returns true if the position is within a primer site (any pool).
+        bool IsPrimerSite(void) const { return primerPools != 0; }
+
+        // InPrimerPool returns true if the position is within a primer site of the provided pool.
+        bool InPrimerPool(std::size_t poolID) const { return (poolID != 0) && (primerPools & (1U << (poolID - 1))); }
+    } SchemePosition;
+
     // SchemeArgs is used to pass arguments to the scheme functions.
     typedef struct SchemeArgs
     {
@@ -28,6 +47,7 @@ namespace artic
         std::string outDir;
         std::string refSeqFile;     // fasta file with reference sequence
         std::string schemeFile;     // bed file with primer coordinates
+        std::string builtinScheme;  // name of a builtin scheme to use instead of schemeFile
         std::string primerSeqsFile; // fasta file with primer sequences
         std::string insertsFile;    // bed file with insert coordinates
     } SchemeArgs;
@@ -78,11 +98,14 @@ namespace artic
         std::size_t GetPrimerPoolID(void) const;
 
         // IsForward returns the primer direction (true = forward, false = reverse).
-        bool IsForward(void);
+        bool IsForward(void) const;
 
         // GetSeq returns the primer sequence from a reference.
         void GetSeq(faidx_t* reference, const std::string& refID, std::string& primerSeq) const;
 
+        // GetSeq returns the primer sequence from a packed reference.
+        void GetSeq(const RefStore& reference, const std::string& refID, std::string& primerSeq) const;
+
     private:
         int64_t _start;        // the reference start position of the primer (0-based, half-open)
         int64_t _end;          // the reference end position of the primer (0-based, half-open) -- NOT INCLUDED IN PRIMER
@@ -95,14 +118,26 @@ namespace artic
 
     //******************************************************************************
     // PrimerScheme class handles the ARTIC style primer schemes.
+    //
+    // NOTES:
+    // * the scheme is frozen once constructed, all the query methods are const
+    // * const methods don't modify any shared state, so one scheme can be queried from many threads
+    // * the scheme is move-only, share it between threads by pointer or reference
     //******************************************************************************
     class PrimerScheme
     {
     public:
         // PrimerScheme constructors and destructor.
         PrimerScheme(const std::string& inputFile);
+        PrimerScheme(const BuiltinScheme& builtinScheme);
+        PrimerScheme(PrimerScheme&& other) = default;
+        PrimerScheme& operator=(PrimerScheme&& other) = default;
         ~PrimerScheme(void);
 
+        // PrimerScheme can't be copied as the amplicons point to primers owned by the scheme.
+        PrimerScheme(const PrimerScheme&) = delete;
+        PrimerScheme& operator=(const PrimerScheme&) = delete;
+
         // GetFileName returns the filename that the primer scheme was loaded from.
         const std::string& GetFileName(void) const;
 
@@ -110,28 +145,28 @@ namespace artic
         const std::string& GetReferenceName(void) const;
 
         // GetNumPrimers returns the total number of primers in the scheme.
-        unsigned int GetNumPrimers(void);
+        unsigned int GetNumPrimers(void) const;
 
         // GetMinPrimerLen returns the minimum primer length in the scheme.
-        unsigned int GetMinPrimerLen(void);
+        unsigned int GetMinPrimerLen(void) const;
 
         // GetMaxPrimerLen returns the maximum primer length in the scheme.
-        unsigned int GetMaxPrimerLen(void);
+        unsigned int GetMaxPrimerLen(void) const;
 
         // GetNumAlts returns the number of alts in the primer scheme.
-        unsigned int GetNumAlts(void);
+        unsigned int GetNumAlts(void) const;
 
         // GetNumAmplicons returns the number of amplicons in the primer scheme (after alts merged and primer pairs matched).
-        unsigned int GetNumAmplicons(void);
+        unsigned int GetNumAmplicons(void) const;
 
         // GetMeanAmpliconSpan returns the mean amplicon span (including primer sequence).
-        unsigned int GetMeanAmpliconSpan(void);
+        unsigned int GetMeanAmpliconSpan(void) const;
 
         // GetMaxAmpliconSpan returns the max amplicon span (including primer sequence).
-        unsigned int GetMaxAmpliconSpan(void);
+        unsigned int GetMaxAmpliconSpan(void) const;
 
         // GetPrimerPools returns all the primer pools found in the primer scheme.
-        std::vector<std::string> GetPrimerPools(void);
+        std::vector<std::string> GetPrimerPools(void) const;
 
         // GetPrimerPool returns the primer pool for the provided pool ID.
         const std::string& GetPrimerPool(std::size_t poolID) const;
@@ -140,37 +175,57 @@ namespace artic
         std::size_t GetPrimerPoolID(const std::string& poolName) const;
 
         // GetRefStart returns the first position in the reference covered by the primer scheme.
-        int64_t GetRefStart(void);
+        int64_t GetRefStart(void) const;
 
         // GetRefEnd returns the last position in the reference covered by the primer scheme.
-        int64_t GetRefEnd(void);
+        int64_t GetRefEnd(void) const;
 
         // GetNumOverlaps returns the number of reference positions covered by more than one amplicon.
-        unsigned int GetNumOverlaps(void);
+        unsigned int GetNumOverlaps(void) const;
 
         // GetExpAmplicons returns a vector containing the amplicons the scheme expects to produce.
-        const std::vector<Amplicon>& GetExpAmplicons(void);
+        const std::vector<Amplicon>& GetExpAmplicons(void) const;
 
         // GetAmpliconName returns a string name for an amplicon in the scheme, based on the provided amplicon int ID.
-        const std::string GetAmpliconName(unsigned int id);
+        const std::string GetAmpliconName(unsigned int id) const;
 
         // GetAmplicon returns an amplicon from the scheme, based on the provided amplicon int ID.
-        const Amplicon& GetAmplicon(unsigned int id);
+        const Amplicon& GetAmplicon(unsigned int id) const;
 
         // FindPrimers returns pointers to the nearest forward and reverse primer, given an alignment segment's start and end position.
-        Amplicon FindPrimers(int64_t segStart, int64_t segEnd);
+        Amplicon FindPrimers(int64_t segStart, int64_t segEnd) const;
+
+        // GetPrimerCursor returns a cursor for finding primers for alignment segments that arrive in coordinate order.
+        PrimerCursor GetPrimerCursor(void) const;
 
         // CheckAmpliconOverlap returns true if the queried position is covered by multiple amplicons (incl. primer sequence).
-        bool CheckAmpliconOverlap(int64_t pos);
+        bool CheckAmpliconOverlap(int64_t pos) const;
 
         // CheckPrimerSite returns true if the queried position is within a primer site of the scheme (either pool).
-        bool CheckPrimerSite(int64_t pos);
+        bool CheckPrimerSite(int64_t pos) const;
+
+        // GetPosition returns the scheme annotation for a reference position, or an empty annotation if outside the scheme bounds.
+        const SchemePosition& GetPosition(int64_t pos) const;
+
+        // AnnotatePositions fills the provided vector with the scheme annotation of each queried position (positions should be sorted for sequential access).
+        void AnnotatePositions(const std::vector<int64_t>& positions, std::vector<SchemePosition>& annotations) const;
 
         // GetPrimerKmers will int encode k-mers from all primers in the scheme and deposit them in the provided map, linked to their amplicon primer origin(s).
-        void GetPrimerKmers(const std::string& reference, uint32_t kSize, kmermap_t& kmerMap);
+        void GetPrimerKmers(const std::string& reference, uint32_t kSize, kmermap_t& kmerMap) const;
+
+        // GetPrimerKmers will int encode k-mers from all primers in the scheme using a packed reference.
+        void GetPrimerKmers(const RefStore& reference, uint32_t kSize, kmermap_t& kmerMap) const;
+
+        // GetPrimerKmers will int encode spaced seed k-mers from all primers in the scheme using a packed reference.
+        void GetPrimerKmers(const RefStore& reference, const SpacedSeed& seed, kmermap_t& kmerMap) const;
 
     private:
+        friend class PrimerCursor;
         void _loadScheme(const std::string& filename);                  // _loadScheme will load an input file and create the primer objects.
+        void _loadScheme(const BuiltinScheme& builtinScheme);           // _loadScheme will create the primer objects from a builtin scheme.
+        void _checkReference(const std::string& refID);                 // _checkReference will record the scheme reference ID, or check it matches the existing one.
+        std::size_t _addPrimerPool(const std::string& poolName);        // _addPrimerPool will add a primer pool to the scheme (if it is new) and return its ID.
+        void _addPrimer(const Primer& primer);                          // _addPrimer will add a primer to the scheme, merging it if it's an alt.
         void _validateScheme(void);                                     // _validateScheme will check all forward primers have a paired reverse primer and record some primer scheme stats.
         std::string _filename;                                          // the file that the scheme was loaded from
         std::string _referenceID;                                       // the ID of the reference sequence covered by the primer scheme
@@ -181,15 +236,15 @@ namespace artic
         unsigned int _maxAmpliconSpan;                                  // the max amplicon span (incl. primers)
         unsigned int _minPrimerLen;                                     // the minimum primer length in the scheme
         unsigned int _maxPrimerLen;                                     // the maximum primer length in the scheme
+        unsigned int _numOverlaps;                                      // the number of reference positions covered by more than one amplicon
         int64_t _refStart;                                              // the first position in the reference covered by the primer scheme
         int64_t _refEnd;                                                // the last position in the reference covered by the primer scheme
         std::vector<std::string> _primerPools;                          // the primer pool IDs found in the primer scheme
         primermap_t _fPrimers;                                          // the forward primers for the scheme
         primermap_t _rPrimers;                                          // the reverse primers for the scheme
-        std::vector<std::pair<int64_t, std::string>> _fPrimerLocations; // the start position and primerID of each forward primer in the scheme
-        std::vector<std::pair<int64_t, std::string>> _rPrimerLocations; // the end position and primerID of each reverse primer in the scheme
-        boost::dynamic_bitset<> _ampliconOverlaps;                      // bit vector encoding all the overlap positions in the scheme
-        boost::dynamic_bitset<> _primerSites;                           // primer sites, stored in a bit vector and offset by primer pool ID
+        std::vector<std::pair<int64_t, const Primer*>> _fPrimerLocations; // the start position of each forward primer in the scheme, sorted by position
+        std::vector<std::pair<int64_t, const Primer*>> _rPrimerLocations; // the end position of each reverse primer in the scheme, sorted by position
+        std::vector<SchemePosition> _positions;                         // the annotation track for each position from _refStart to _refEnd (inclusive)
         std::vector<Amplicon> _expAmplicons;                            // the expected amplicons produced by the scheme
     };
 
@@ -200,13 +255,13 @@ namespace artic
     {
     public:
         // Amplicon constructor.
-        Amplicon(Primer* p1, Primer* p2);
+        Amplicon(const Primer* p1, const Primer* p2);
 
         // SetID will assign an ID to the amplicon.
         void SetID(unsigned int id);
 
         // IsProperlyPaired returns true if the amplicon primers are properly paired.
-        bool IsProperlyPaired(void);
+        bool IsProperlyPaired(void) const;
 
         // GetName returns the name for the amplicon (combines primer IDs).
         const std::string GetName(void) const;
@@ -215,31 +270,61 @@ namespace artic
         unsigned int GetID(void) const;
 
         // GetPrimerPool returns the pool ID for the primer pair (0 returned if not properly paired).
-        std::size_t GetPrimerPoolID(void);
+        std::size_t GetPrimerPoolID(void) const;
 
         // GetMaxSpan returns the start and end of the amplicon, including the primer sequence.
-        std::pair<int64_t, int64_t> GetMaxSpan(void);
+        std::pair<int64_t, int64_t> GetMaxSpan(void) const;
 
         // GetMinSpan returns the start and end of the amplicon, excluding the primer sequence.
-        std::pair<int64_t, int64_t> GetMinSpan(void);
+        std::pair<int64_t, int64_t> GetMinSpan(void) const;
 
         // GetForwardPrimer returns a pointer to the forward primer in the amplicon.
-        const Primer* GetForwardPrimer(void);
+        const Primer* GetForwardPrimer(void) const;
 
         // GetReversePrimer returns a pointer to the reverse primer in the amplicon.
-        const Primer* GetReversePrimer(void);
+        const Primer* GetReversePrimer(void) const;
 
         // AddKmers adds the k-mers from a sequence to the amplicon.
         void AddKmers(const char* seq, uint32_t seqLen, uint32_t kSize);
 
     private:
-        Primer* _fPrimer;        // pointer to the forward primer object
-        Primer* _rPrimer;        // pointer to the reverse primer object
+        const Primer* _fPrimer;  // pointer to the forward primer object
+        const Primer* _rPrimer;  // pointer to the reverse primer object
         bool _isProperlyPaired;  // denotes if amplicon has properly paired primers
         unsigned int _id;        // the amplicon identifier
         artic::kmerset_t _kmers; // the set of k-mers for this amplicon
     };
 
+    //******************************************************************************
+    // PrimerCursor finds primers for alignment segments that arrive in coordinate order.
+    //
+    // NOTES:
+    // * the cursor steps through the scheme primer locations from the previous segment position
+    // * if a segment position is a long way from the previous one (e.g. unsorted input), the cursor falls back to a binary search
+    // * results are the same as PrimerScheme::FindPrimers, regardless of input order
+    // * the cursor must not outlive the scheme that created it
+    // * cursors are cheap, use one per thread when sharing a scheme
+    //******************************************************************************
+    class PrimerCursor
+    {
+    public:
+        // PrimerCursor constructor.
+        PrimerCursor(const PrimerScheme* primerScheme);
+
+        // FindPrimers returns the nearest forward and reverse primer, given an alignment segment's start and end position.
+        Amplicon FindPrimers(int64_t segStart, int64_t segEnd);
+
+        // Reset moves the cursor back to the start of the scheme.
+        void Reset(void);
+
+    private:
+        const PrimerScheme* _primerScheme; // the scheme being searched
+        std::size_t _fIndex;               // the current index in the scheme forward primer locations
+        std::size_t _rIndex;               // the current index in the scheme reverse primer locations
+        int64_t _lastStart;                // the previous segment start
+        int64_t _lastEnd;                  // the previous segment end
+    };
+
 } // namespace artic
 
 #endif
\ No newline at end of file
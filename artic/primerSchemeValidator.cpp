@@ -9,9 +9,22 @@ artic::PrimerScheme artic::ValidateScheme(SchemeArgs& args)
 {
     // check there is a scheme loaded or try loading one
     LOG_TRACE("reading scheme")
-    if (args.schemeFile.size() == 0)
+    const artic::BuiltinScheme* builtin = nullptr;
+    if (args.builtinScheme.size() != 0)
+    {
+        builtin = artic::FindBuiltinScheme(args.builtinScheme);
+        if (!builtin)
+        {
+            std::string available;
+            for (const auto& scheme : artic::BUILTIN_SCHEMES)
+                available += " " + std::string(scheme.name);
+            throw std::runtime_error("builtin scheme not found - " + args.builtinScheme + " (available:" + (available.empty() ? " none" : available) + ")");
+        }
+        LOG_TRACE("\tusing builtin scheme:\t{}", args.builtinScheme);
+    }
+    else if (args.schemeFile.size() == 0)
         LOG_ERROR("no primer scheme file was provided");
-    auto ps = artic::PrimerScheme(args.schemeFile);
+    auto ps = (builtin) ? artic::PrimerScheme(*builtin) : artic::PrimerScheme(args.schemeFile);
 
     // get primer sequences if requested
     if (args.primerSeqsFile.size() != 0)
@@ -21,23 +34,22 @@ artic::PrimerScheme artic::ValidateScheme(SchemeArgs& args)
         LOG_TRACE("collecting primer sequences")
         if (args.refSeqFile.size() == 0)
             LOG_ERROR("no reference sequence provided, can't output primer sequences");
-        faidx_t* fai = fai_load(args.refSeqFile.c_str());
+        artic::RefStore reference(args.refSeqFile);
+        LOG_TRACE("\tpacked reference size:\t{} bytes", reference.GetPackedSize());
         std::ofstream fh;
         fh.open(args.primerSeqsFile);
         for (auto amplicon : ps.GetExpAmplicons())
         {
             auto fpName = (amplicon.GetForwardPrimer()->GetNumAlts()) ? amplicon.GetForwardPrimer()->GetName() + std::string("_alts_merged") : amplicon.GetForwardPrimer()->GetName();
             auto rpName = (amplicon.GetReversePrimer()->GetNumAlts()) ? amplicon.GetReversePrimer()->GetName() + std::string("_alts_merged") : amplicon.GetReversePrimer()->GetName();
-            amplicon.GetForwardPrimer()->GetSeq(fai, ps.GetReferenceName(), fpSeq);
-            amplicon.GetReversePrimer()->GetSeq(fai, ps.GetReferenceName(), rpSeq);
+            amplicon.GetForwardPrimer()->GetSeq(reference, ps.GetReferenceName(), fpSeq);
+            amplicon.GetReversePrimer()->GetSeq(reference, ps.GetReferenceName(), rpSeq);
             fh << ">" << fpName << std::endl
                << fpSeq << std::endl;
             fh << ">" << rpName << std::endl
                << rpSeq << std::endl;
         }
         fh.close();
-        if (fai)
-            fai_destroy(fai);
         LOG_TRACE("\twritten to file: {}", args.primerSeqsFile);
     }
 
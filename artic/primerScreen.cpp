@@ -0,0 +1,503 @@
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <exception>
+#include <iomanip>
+#include <thread>
+
+#include "fastqReader.hpp"
+#include "log.hpp"
+#include "primerScreen.hpp"
+#include "refStore.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ARTIC_SCREEN_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // siteHits are the best hits for a primer site in a group of genomes, one per lane.
+    struct siteHits
+    {
+        int64_t edits[artic::PRIMERSCREEN_LANES]; // the fewest edits for the site
+        int64_t hasNs[artic::PRIMERSCREEN_LANES]; // non-zero if the best hit has Ns in it
+        int64_t ends[artic::PRIMERSCREEN_LANES];  // the genome position of the last base of the best hit
+    };
+
+    // findSitesScalar finds the best hit for a site in each genome of a group, one genome at a time.
+    // Myers' bit-vector edit distance is run over each window, with the site as the pattern and a free start in the genome, so that
+    // the score after each base is the fewest edits for the site ending there (Ns match any base but are tracked for the hit).
+    // The best hit has the fewest edits, then no Ns, then is closest to the reference position.
+    void findSitesScalar(const uint64_t* peq, uint32_t len, const char* const* seqs, int64_t windowStart, const int64_t* windowEnds, int64_t refStart, siteHits& hits)
+    {
+        uint64_t lastBit = uint64_t(1) << (len - 1);
+        uint64_t siteMask = (len == artic::PRIMERSCREEN_MAX_SITE_LENGTH) ? ~uint64_t(0) : (uint64_t(1) << len) - 1;
+        for (std::size_t lane = 0; lane < artic::PRIMERSCREEN_LANES; lane++)
+        {
+            uint64_t pv = ~uint64_t(0);
+            uint64_t mv = 0;
+            uint64_t ns = 0;
+            int64_t edits = len;
+            hits.edits[lane] = INT64_MAX;
+            hits.hasNs[lane] = 1;
+            hits.ends[lane] = windowStart;
+            int64_t bestDistance = INT64_MAX;
+            for (auto pos = windowStart; pos < windowEnds[lane]; pos++)
+            {
+                auto base = artic::nt2char[uint8_t(seqs[lane][pos])];
+                uint64_t eq = (base > 3) ? ~uint64_t(0) : peq[base];
+                ns = (ns << 1) | (base > 3);
+                uint64_t xv = eq | mv;
+                uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+                uint64_t ph = mv | ~(xh | pv);
+                uint64_t mh = pv & xh;
+                if (ph & lastBit)
+                    edits++;
+                else if (mh & lastBit)
+                    edits--;
+                ph <<= 1;
+                mh <<= 1;
+                pv = mh | ~(xv | ph);
+                mv = ph & xv;
+                int64_t hasNs = (ns & siteMask) != 0;
+                auto distance = std::abs(pos + 1 - int64_t(len) - refStart);
+                if (edits < hits.edits[lane] || (edits == hits.edits[lane] && (hasNs < hits.hasNs[lane] || (hasNs == hits.hasNs[lane] && distance < bestDistance))))
+                {
+                    hits.edits[lane] = edits;
+                    hits.hasNs[lane] = hasNs;
+                    hits.ends[lane] = pos;
+                    bestDistance = distance;
+                }
+            }
+        }
+    }
+
+#ifdef ARTIC_SCREEN_DISPATCH
+    // findSitesAVX2 finds the best hit for a site in each genome of a group at once (as per findSitesScalar), with a genome in each 64-bit lane.
+    // The windows all start at the same place, so a lane is masked out of the hits once it passes the end of its window.
+    __attribute__((target("avx2"))) void findSitesAVX2(const uint64_t* peq, uint32_t len, const char* const* seqs, int64_t windowStart, const int64_t* windowEnds, int64_t refStart, siteHits& hits)
+    {
+        const __m256i ones = _mm256_set1_epi64x(-1);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i lastBit = _mm256_set1_epi64x(int64_t(uint64_t(1) << (len - 1)));
+        const __m256i siteMask = _mm256_set1_epi64x((len == artic::PRIMERSCREEN_MAX_SITE_LENGTH) ? -1 : int64_t((uint64_t(1) << len) - 1));
+        const __m256i ends = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(windowEnds));
+        __m256i pv = ones;
+        __m256i mv = zero;
+        __m256i ns = zero;
+        __m256i edits = _mm256_set1_epi64x(len);
+        __m256i bestEdits = _mm256_set1_epi64x(INT64_MAX);
+        __m256i bestHasNs = ones;
+        __m256i bestDistance = _mm256_set1_epi64x(INT64_MAX);
+        __m256i bestEnds = _mm256_set1_epi64x(windowStart);
+        int64_t maxEnd = *std::max_element(windowEnds, windowEnds + artic::PRIMERSCREEN_LANES);
+
+        const uint64_t eqs[5] = {peq[0], peq[1], peq[2], peq[3], ~uint64_t(0)};
+        for (auto pos = windowStart; pos < maxEnd; pos++)
+        {
+            // look up the match mask for the base in each lane (lanes past their window read an N, which matches everything)
+            uint8_t codes[artic::PRIMERSCREEN_LANES];
+            for (std::size_t lane = 0; lane < artic::PRIMERSCREEN_LANES; lane++)
+                codes[lane] = (pos < windowEnds[lane]) ? artic::nt2char[uint8_t(seqs[lane][pos])] : 4;
+            __m256i eq = _mm256_set_epi64x(eqs[codes[3]], eqs[codes[2]], eqs[codes[1]], eqs[codes[0]]);
+            __m256i nbits = _mm256_set_epi64x(codes[3] >> 2, codes[2] >> 2, codes[1] >> 2, codes[0] >> 2);
+            ns = _mm256_or_si256(_mm256_slli_epi64(ns, 1), nbits);
+
+            // step each lane (the edit count goes up where ph has the last bit set and down where mh does, which the compares give as -1)
+            __m256i xv = _mm256_or_si256(eq, mv);
+            __m256i xh = _mm256_or_si256(_mm256_xor_si256(_mm256_add_epi64(_mm256_and_si256(eq, pv), pv), pv), eq);
+            __m256i ph = _mm256_or_si256(mv, _mm256_andnot_si256(_mm256_or_si256(xh, pv), ones));
+            __m256i mh = _mm256_and_si256(pv, xh);
+            edits = _mm256_sub_epi64(edits, _mm256_cmpeq_epi64(_mm256_and_si256(ph, lastBit), lastBit));
+            edits = _mm256_add_epi64(edits, _mm256_cmpeq_epi64(_mm256_and_si256(mh, lastBit), lastBit));
+            ph = _mm256_slli_epi64(ph, 1);
+            mh = _mm256_slli_epi64(mh, 1);
+            pv = _mm256_or_si256(mh, _mm256_andnot_si256(_mm256_or_si256(xv, ph), ones));
+            mv = _mm256_and_si256(ph, xv);
+
+            // keep the best hit in each lane that is still in its window (the distance is the same for every lane)
+            __m256i hasNs = _mm256_andnot_si256(_mm256_cmpeq_epi64(_mm256_and_si256(ns, siteMask), zero), ones);
+            __m256i distance = _mm256_set1_epi64x(std::abs(pos + 1 - int64_t(len) - refStart));
+            __m256i fewerNs = _mm256_andnot_si256(hasNs, bestHasNs);
+            __m256i closer = _mm256_and_si256(_mm256_cmpeq_epi64(hasNs, bestHasNs), _mm256_cmpgt_epi64(bestDistance, distance));
+            __m256i better = _mm256_or_si256(_mm256_cmpgt_epi64(bestEdits, edits), _mm256_and_si256(_mm256_cmpeq_epi64(edits, bestEdits), _mm256_or_si256(fewerNs, closer)));
+            better = _mm256_and_si256(better, _mm256_cmpgt_epi64(ends, _mm256_set1_epi64x(pos)));
+            bestEdits = _mm256_blendv_epi8(bestEdits, edits, better);
+            bestHasNs = _mm256_blendv_epi8(bestHasNs, hasNs, better);
+            bestDistance = _mm256_blendv_epi8(bestDistance, distance, better);
+            bestEnds = _mm256_blendv_epi8(bestEnds, _mm256_set1_epi64x(pos), better);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hits.edits), bestEdits);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hits.hasNs), bestHasNs);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hits.ends), bestEnds);
+    }
+#endif
+
+} // namespace
+
+// PrimerScreen constructor.
+artic::PrimerScreen::PrimerScreen(const artic::PrimerScheme* primerScheme, const std::string& refFile, const std::vector<std::string>& genomeFiles, unsigned int numThreads, std::ostream& output)
+    : _primerScheme(primerScheme), _refFile(refFile), _genomeFiles(genomeFiles), _output(&output), _numThreads(numThreads), _searchWindow(100), _threePrimeBases(5), _threePrimeWeight(3), _riskScore(3), _riskProportion(0.01), _kernel(GetKmerKernel()), _numGenomes(0)
+{
+    if (_numThreads == 0)
+        throw std::runtime_error("number of screening threads must be > 0");
+    _loadSites();
+}
+
+// SetSearchWindow sets the number of bases either side of each primer site to search in a genome.
+void artic::PrimerScreen::SetSearchWindow(unsigned int searchWindow) { _searchWindow = searchWindow; }
+
+// SetThreePrimeWeighting sets the number of bases at the 3' end of a primer where edits count extra, and the weight of those edits.
+void artic::PrimerScreen::SetThreePrimeWeighting(unsigned int threePrimeBases, unsigned int threePrimeWeight)
+{
+    if (threePrimeWeight == 0)
+        throw std::runtime_error("3' mismatch weight must be > 0");
+    _threePrimeBases = threePrimeBases;
+    _threePrimeWeight = threePrimeWeight;
+    _loadSites();
+}
+
+// SetRiskScore sets the weighted edit score at which a primer is at risk of dropout for a genome.
+void artic::PrimerScreen::SetRiskScore(unsigned int riskScore)
+{
+    if (riskScore == 0)
+        throw std::runtime_error("risk score must be > 0");
+    _riskScore = riskScore;
+}
+
+// SetRiskProportion sets the proportion of genomes (with data) that must be at risk for a primer to be reported as at risk of dropout.
+void artic::PrimerScreen::SetRiskProportion(float riskProportion)
+{
+    if (riskProportion <= 0 || riskProportion > 1)
+        throw std::runtime_error("risk proportion must be > 0 and <= 1");
+    _riskProportion = riskProportion;
+}
+
+// SetKernel sets the instruction set used to search for the primer sites (AVX2 screens several genomes at once, anything else is scalar).
+void artic::PrimerScreen::SetKernel(KmerKernel kernel)
+{
+    if (kernel > GetKmerKernel())
+        throw std::runtime_error("kernel not supported by this CPU: " + GetKmerKernelName(kernel));
+    _kernel = kernel;
+}
+
+// Run will screen the genomes and write a line per primer to the output.
+void artic::PrimerScreen::Run(void)
+{
+    // check the input files before starting any threads
+    if (_genomeFiles.empty())
+        throw std::runtime_error("no genome files provided");
+    for (const auto& file : _genomeFiles)
+        if (!boost::filesystem::exists(file))
+            throw std::runtime_error("supplied file does not exist:\t" + file);
+    for (auto& counts : _counts)
+        counts.noData = counts.mismatched = counts.threePrime = counts.atRisk = 0;
+    _numGenomes = 0;
+
+    // set up the queues, allowing a couple of batches per worker to be in flight (as per the Amplitigger)
+    artic::BoundedQueue<genomeBatch> batches(_numThreads * 2);
+    artic::BoundedQueue<genomeBatch> emptyBatches(_numThreads * 3 + 1);
+    LOG_TRACE("screening genomes");
+    LOG_TRACE("\tscreening threads:\t{}", _numThreads);
+    LOG_TRACE("\tsearch kernel:\t{}", (_kernel == KmerKernel::avx2) ? "avx2 (" + std::to_string(PRIMERSCREEN_LANES) + " genomes at a time)" : "scalar");
+    LOG_TRACE("\tsearch window:\t{} bases either side of each primer site", _searchWindow);
+    LOG_TRACE("\t3' mismatches:\tlast {} bases of each primer, weight {}", _threePrimeBases, _threePrimeWeight);
+    LOG_TRACE("\trisk score:\t{}", _riskScore);
+
+    // start the workers and then the parser, catching the first error from any thread
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto guard = [&](auto&& task) {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error)
+                error = std::current_exception();
+            batches.Close();
+            emptyBatches.Close();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < _numThreads; i++)
+        workers.emplace_back([&] { guard([&] { _screenGenomes(batches, emptyBatches); }); });
+    std::thread parser([&] { guard([&] { _parseGenomes(batches, emptyBatches); }); });
+    parser.join();
+    for (auto& worker : workers)
+        worker.join();
+    if (error)
+        std::rethrow_exception(error);
+    _writeCounts();
+
+    // print some stats
+    std::size_t numAtRisk = 0;
+    for (std::size_t i = 0; i < _counts.size(); i++)
+    {
+        if (!IsAtRisk(i))
+            continue;
+        LOG_WARN("primer at risk of dropout:\t{} ({} of {} genomes)", _counts[i].primerName, _counts[i].atRisk, _numGenomes - _counts[i].noData);
+        numAtRisk++;
+    }
+    LOG_TRACE("finished screening genomes");
+    LOG_TRACE("\ttotal genomes:\t{}", _numGenomes);
+    LOG_TRACE("\ttotal primers:\t{}", _counts.size());
+    LOG_TRACE("\tprimers at risk of dropout:\t{}", numAtRisk);
+}
+
+// GetNumGenomes returns the number of genomes screened.
+uint64_t artic::PrimerScreen::GetNumGenomes(void) const { return _numGenomes; }
+
+// GetCounts returns the screening results for each primer, in scheme order.
+const std::vector<artic::PrimerScreenCounts>& artic::PrimerScreen::GetCounts(void) const { return _counts; }
+
+// IsAtRisk returns true if a primer is at risk of dropout (indexed as per GetCounts).
+bool artic::PrimerScreen::IsAtRisk(std::size_t primerIndex) const
+{
+    if (primerIndex >= _counts.size())
+        throw std::runtime_error("primer index out of range: " + std::to_string(primerIndex));
+    const auto& counts = _counts[primerIndex];
+    auto withData = _numGenomes - counts.noData;
+    return withData != 0 && counts.atRisk >= _riskProportion * withData;
+}
+
+// _loadSites encodes the primer sites from the reference.
+void artic::PrimerScreen::_loadSites(void)
+{
+    artic::RefStore reference(_refFile);
+    _sites.clear();
+    _counts.clear();
+    std::string seq;
+    for (const auto& amplicon : _primerScheme->GetExpAmplicons())
+    {
+        for (auto primer : {amplicon.GetForwardPrimer(), amplicon.GetReversePrimer()})
+        {
+            auto name = (primer->GetNumAlts()) ? primer->GetName() + std::string("_alts_merged") : primer->GetName();
+            reference.GetSeq(_primerScheme->GetReferenceName(), primer->GetStart(), primer->GetEnd(), seq);
+            if (seq.size() > PRIMERSCREEN_MAX_SITE_LENGTH)
+                throw std::runtime_error("primer site is too long to screen (max " + std::to_string(PRIMERSCREEN_MAX_SITE_LENGTH) + " bases): " + name);
+
+            // the 3' end of a forward primer is the last base of the site, for a reverse primer it's the first
+            primerSite site{{0, 0, 0, 0}, 0, std::string(seq.size(), 0), uint32_t(seq.size())};
+            for (std::size_t i = 0; i < seq.size(); i++)
+            {
+                auto base = artic::nt2char[uint8_t(seq[i])];
+                if (base > 3)
+                    throw std::runtime_error("primer site has non-ACGT bases in the reference: " + name);
+                site.peq[base] |= uint64_t(1) << i;
+                site.bases[i] = base;
+                bool threePrime = (primer->IsForward()) ? (i + _threePrimeBases >= seq.size()) : (i < _threePrimeBases);
+                if (threePrime)
+                    site.threePrimeMask |= uint64_t(1) << i;
+            }
+            _sites.emplace_back(site);
+            _counts.push_back({name, primer->GetStart(), primer->GetEnd(), primer->IsForward(), 0, 0, 0, 0});
+        }
+    }
+}
+
+// _parseGenomes reads the genome files and queues batches of genomes.
+void artic::PrimerScreen::_parseGenomes(artic::BoundedQueue<genomeBatch>& batches, artic::BoundedQueue<genomeBatch>& emptyBatches)
+{
+    genomeBatch batch;
+    for (const auto& file : _genomeFiles)
+    {
+        artic::FastqReader reader(file, nullptr);
+        LOG_TRACE("\treading file:\t{}", file);
+        while (true)
+        {
+            // grab a recycled batch if there is one
+            if (batch.size == 0 && batch.genomes.empty())
+                emptyBatches.TryPop(batch);
+
+            // read the next genome into the batch
+            if (batch.size == batch.genomes.size())
+                batch.genomes.emplace_back();
+            if (!reader.Read(batch.genomes[batch.size]))
+                break;
+            _numGenomes++;
+
+            // queue the batch once full
+            if (++batch.size == PRIMERSCREEN_BATCH_SIZE)
+            {
+                if (!batches.Push(std::move(batch)))
+                    return;
+                batch = genomeBatch();
+            }
+        }
+    }
+
+    // queue the last batch and let the workers know there are no more
+    if (batch.size != 0)
+        batches.Push(std::move(batch));
+    batches.Close();
+}
+
+// _screenGenomes screens batches of genomes until the queue is closed.
+void artic::PrimerScreen::_screenGenomes(artic::BoundedQueue<genomeBatch>& batches, artic::BoundedQueue<genomeBatch>& emptyBatches)
+{
+    // each worker keeps its own counts, adding them to the totals once the queue is closed, and its own alignment matrix to reuse
+    auto counts = _counts;
+    std::vector<unsigned int> scores;
+    for (auto& primer : counts)
+        primer.noData = primer.mismatched = primer.threePrime = primer.atRisk = 0;
+    genomeBatch batch;
+    while (batches.Pop(batch))
+    {
+        const std::string* seqs[PRIMERSCREEN_LANES];
+        for (std::size_t i = 0; i < batch.size; i += PRIMERSCREEN_LANES)
+        {
+            auto numSeqs = std::min(batch.size - i, std::size_t(PRIMERSCREEN_LANES));
+            for (std::size_t lane = 0; lane < numSeqs; lane++)
+                seqs[lane] = &batch.genomes[i + lane].seq;
+            _screenGroup(seqs, numSeqs, counts, scores);
+        }
+
+        // send the batch back to the parser for reuse
+        batch.size = 0;
+        emptyBatches.Push(std::move(batch));
+        batch = genomeBatch();
+    }
+    std::lock_guard<std::mutex> lock(_countsMutex);
+    for (std::size_t i = 0; i < counts.size(); i++)
+    {
+        _counts[i].noData += counts[i].noData;
+        _counts[i].mismatched += counts[i].mismatched;
+        _counts[i].threePrime += counts[i].threePrime;
+        _counts[i].atRisk += counts[i].atRisk;
+    }
+}
+
+// _screenGroup finds the best match for each primer site in a group of up to PRIMERSCREEN_LANES genomes.
+void artic::PrimerScreen::_screenGroup(const std::string* const* seqs, std::size_t numSeqs, std::vector<PrimerScreenCounts>& counts, std::vector<unsigned int>& scores) const
+{
+    const char* bases[PRIMERSCREEN_LANES];
+    int64_t windowEnds[PRIMERSCREEN_LANES];
+    siteHits hits;
+    for (std::size_t i = 0; i < _sites.size(); i++)
+    {
+        // the window starts at the same place in every genome, lanes without a genome (or without room for the site) get an empty window
+        const auto& site = _sites[i];
+        auto windowStart = std::max(int64_t(0), counts[i].start - int64_t(_searchWindow));
+        for (std::size_t lane = 0; lane < PRIMERSCREEN_LANES; lane++)
+        {
+            bases[lane] = nullptr;
+            windowEnds[lane] = windowStart;
+            if (lane >= numSeqs)
+                continue;
+            auto windowEnd = std::min(int64_t(seqs[lane]->size()), counts[i].end + int64_t(_searchWindow));
+            if (windowEnd - windowStart < int64_t(site.len))
+            {
+                counts[i].noData++;
+                continue;
+            }
+            bases[lane] = seqs[lane]->data();
+            windowEnds[lane] = windowEnd;
+        }
+#ifdef ARTIC_SCREEN_DISPATCH
+        if (_kernel == KmerKernel::avx2)
+            findSitesAVX2(site.peq, site.len, bases, windowStart, windowEnds, counts[i].start, hits);
+        else
+#endif
+            findSitesScalar(site.peq, site.len, bases, windowStart, windowEnds, counts[i].start, hits);
+
+        // score the hits
+        for (std::size_t lane = 0; lane < numSeqs; lane++)
+        {
+            if (bases[lane] == nullptr)
+                continue;
+            if (hits.hasNs[lane])
+            {
+                counts[i].noData++;
+                continue;
+            }
+            if (hits.edits[lane] == 0)
+                continue;
+
+            // align the site to the hit to weight the 3' edits (the weighted alignment can use at most this many extra genome bases)
+            bool threePrime = false;
+            auto hitStart = std::max(windowStart, hits.ends[lane] + 1 - int64_t(site.len) - int64_t(hits.edits[lane] * _threePrimeWeight));
+            auto score = _alignSite(site, *seqs[lane], hitStart, hits.ends[lane] + 1, scores, threePrime);
+            counts[i].mismatched++;
+            if (threePrime)
+                counts[i].threePrime++;
+            if (score >= _riskScore)
+                counts[i].atRisk++;
+        }
+    }
+}
+
+// _alignSite aligns a site to the genome bases ending at a hit (using the scores as scratch), returning the weighted score.
+unsigned int artic::PrimerScreen::_alignSite(const primerSite& site, const std::string& seq, int64_t start, int64_t end, std::vector<unsigned int>& scores, bool& threePrime) const
+{
+    // fill the weighted edit matrix, with a free start in the genome and the site anchored to the end of the hit
+    // (an insertion is 3' if the site bases either side of it are both 3')
+    std::size_t rows = site.len + 1;
+    std::size_t cols = end - start + 1;
+    auto isThreePrime = [&](std::size_t i) { return ((site.threePrimeMask >> i) & 1) != 0; };
+    auto isThreePrimeIns = [&](std::size_t row) { return isThreePrime(row - 1) && (row == site.len || isThreePrime(row)); };
+    auto weight = [&](std::size_t i) { return isThreePrime(i) ? _threePrimeWeight : 1; };
+    auto insWeight = [&](std::size_t row) { return isThreePrimeIns(row) ? _threePrimeWeight : 1; };
+    if (scores.size() < rows * cols)
+        scores.resize(rows * cols);
+    std::fill(scores.begin(), scores.begin() + cols, 0);
+    for (std::size_t row = 1; row < rows; row++)
+    {
+        scores[row * cols] = scores[(row - 1) * cols] + weight(row - 1);
+        for (std::size_t col = 1; col < cols; col++)
+        {
+            auto base = artic::nt2char[uint8_t(seq[start + col - 1])];
+            bool match = base > 3 || base == uint8_t(site.bases[row - 1]);
+            scores[row * cols + col] = std::min({scores[(row - 1) * cols + col - 1] + (match ? 0 : weight(row - 1)),
+                                                 scores[(row - 1) * cols + col] + weight(row - 1),
+                                                 scores[row * cols + col - 1] + insWeight(row)});
+        }
+    }
+
+    // trace back from the end of the hit to see if any of the edits were in the 3' bases
+    threePrime = false;
+    std::size_t row = rows - 1;
+    std::size_t col = cols - 1;
+    while (row > 0)
+    {
+        auto score = scores[row * cols + col];
+        if (col > 0)
+        {
+            auto base = artic::nt2char[uint8_t(seq[start + col - 1])];
+            bool match = base > 3 || base == uint8_t(site.bases[row - 1]);
+            if (score == scores[(row - 1) * cols + col - 1] + (match ? 0 : weight(row - 1)))
+            {
+                threePrime |= !match && isThreePrime(row - 1);
+                row--;
+                col--;
+                continue;
+            }
+            if (score == scores[row * cols + col - 1] + insWeight(row))
+            {
+                threePrime |= isThreePrimeIns(row);
+                col--;
+                continue;
+            }
+        }
+        threePrime |= isThreePrime(row - 1);
+        row--;
+    }
+    return scores[(rows - 1) * cols + cols - 1];
+}
+
+// _writeCounts writes a line per primer to the output.
+void artic::PrimerScreen::_writeCounts(void)
+{
+    *_output << "#primer\tstart\tend\tgenomes\tnoData\tmismatched\tthreePrime\tatRisk\tatRiskProportion\tdropoutRisk\n";
+    for (std::size_t i = 0; i < _counts.size(); i++)
+    {
+        const auto& counts = _counts[i];
+        auto withData = _numGenomes - counts.noData;
+        *_output << counts.primerName << "\t" << counts.start << "\t" << counts.end << "\t" << withData << "\t" << counts.noData << "\t" << counts.mismatched << "\t" << counts.threePrime << "\t" << counts.atRisk
+                 << "\t" << std::fixed << std::setprecision(4) << ((withData != 0) ? double(counts.atRisk) / double(withData) : 0.0)
+                 << "\t" << (IsAtRisk(i) ? "yes" : "no") << "\n";
+    }
+    _output->flush();
+}
@@ -0,0 +1,135 @@
+#ifndef PRIMERSCREEN_H
+#define PRIMERSCREEN_H
+
+#include <iostream>
+#include <kseq++/kseq++.hpp>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "boundedQueue.hpp"
+#include "kmers.hpp"
+#include "primerScheme.hpp"
+
+namespace artic
+{
+    // PRIMERSCREEN_BATCH_SIZE is the number of genomes passed from the parser to a worker in one go.
+    const unsigned int PRIMERSCREEN_BATCH_SIZE = 64;
+
+    // PRIMERSCREEN_MAX_SITE_LENGTH is the longest primer site that can be screened (one bit per base in a 64-bit word).
+    const unsigned int PRIMERSCREEN_MAX_SITE_LENGTH = 64;
+
+    // PRIMERSCREEN_LANES is the number of genomes searched at once for a primer site (one per 64-bit lane of an AVX2 register).
+    const std::size_t PRIMERSCREEN_LANES = 4;
+
+    // PrimerScreenCounts are the screening results for one primer across the genome collection.
+    struct PrimerScreenCounts
+    {
+        std::string primerName; // the primer name (with _alts_merged appended if alts were merged into it)
+        int64_t start;          // the reference start of the primer site (0-based, half-open)
+        int64_t end;            // the reference end of the primer site (0-based, half-open)
+        bool forward;           // true if the primer is a forward primer (3' end at the site end), false if reverse (3' end at the site start)
+        uint64_t noData;        // the number of genomes with Ns at (or no sequence for) the primer site
+        uint64_t mismatched;    // the number of genomes with at least one edit (substitution or indel) at the primer site
+        uint64_t threePrime;    // the number of genomes with at least one edit in the 3' bases of the primer
+        uint64_t atRisk;        // the number of genomes where the weighted edit score reaches the risk score
+    };
+
+    //******************************************************************************
+    // PrimerScreen checks the primer binding sites of a scheme against a collection of genomes, to find primers at risk of dropout.
+    //
+    // NOTES:
+    // * genomes are expected to be assemblies in the same orientation as the scheme reference (e.g. a GISAID dump)
+    // * each primer site is searched for within a window around its reference position, allowing for indels and trimmed genome ends
+    // * sites are found with Myers' bit-vector edit distance, with the site as the pattern in a 64-bit word (so sites can be up to 64 bases,
+    //   including merged alts), giving the fewest edits for a site ending at each genome position in one pass over the window
+    // * workers screen their genomes in groups of PRIMERSCREEN_LANES, and with AVX2 a site is searched for in every genome of a group at
+    //   once (a genome per 64-bit lane), falling back to one genome at a time on other CPUs (SetKernel)
+    // * substitutions, insertions and deletions are all single edits, so an indel in a binding site counts once
+    // * the best hit has the fewest edits, then no Ns, then is closest to the reference position
+    // * the best hit is then aligned to the site with edits in the 3' bases of a primer given extra weight, to get the weighted score
+    // * Ns match any base, but a best hit with Ns in it has no data for the primer
+    // * one thread parses the genome files and queues batches of genomes for a pool of workers, which keep their own counts until the end
+    //******************************************************************************
+    class PrimerScreen
+    {
+    public:
+        // PrimerScreen constructor.
+        PrimerScreen(const artic::PrimerScheme* primerScheme, const std::string& refFile, const std::vector<std::string>& genomeFiles, unsigned int numThreads = 1, std::ostream& output = std::cout);
+
+        // SetSearchWindow sets the number of bases either side of each primer site to search in a genome.
+        void SetSearchWindow(unsigned int searchWindow);
+
+        // SetThreePrimeWeighting sets the number of bases at the 3' end of a primer where edits count extra, and the weight of those edits.
+        void SetThreePrimeWeighting(unsigned int threePrimeBases, unsigned int threePrimeWeight);
+
+        // SetRiskScore sets the weighted edit score at which a primer is at risk of dropout for a genome.
+        void SetRiskScore(unsigned int riskScore);
+
+        // SetRiskProportion sets the proportion of genomes (with data) that must be at risk for a primer to be reported as at risk of dropout.
+        void SetRiskProportion(float riskProportion);
+
+        // SetKernel sets the instruction set used to search for the primer sites (AVX2 screens several genomes at once, anything else is scalar).
+        void SetKernel(KmerKernel kernel);
+
+        // Run will screen the genomes and write a line per primer to the output.
+        void Run(void);
+
+        // GetNumGenomes returns the number of genomes screened.
+        uint64_t GetNumGenomes(void) const;
+
+        // GetCounts returns the screening results for each primer, in scheme order.
+        const std::vector<PrimerScreenCounts>& GetCounts(void) const;
+
+        // IsAtRisk returns true if a primer is at risk of dropout (indexed as per GetCounts).
+        bool IsAtRisk(std::size_t primerIndex) const;
+
+    private:
+        // primerSite is an encoded primer site and the masks used to score it.
+        struct primerSite
+        {
+            uint64_t peq[4];         // the match masks for each base (bit i is set if base i of the site is A, C, G or T)
+            uint64_t threePrimeMask; // bit i is set if base i of the site is in the 3' end of the primer
+            std::string bases;       // the 2-bit codes of the site (reference strand)
+            uint32_t len;            // the length of the site
+        };
+
+        // genomeBatch is a batch of genomes passed from the parser to a worker.
+        struct genomeBatch
+        {
+            std::vector<klibpp::KSeq> genomes; // the genome holders (may be larger than the batch)
+            std::size_t size = 0;              // the number of genomes in the batch
+        };
+
+        void _loadSites(void);                                                                                                                                          // encodes the primer sites from the reference
+        void _parseGenomes(BoundedQueue<genomeBatch>& batches, BoundedQueue<genomeBatch>& emptyBatches);                                                                // reads the genome files and queues batches of genomes
+        void _screenGenomes(BoundedQueue<genomeBatch>& batches, BoundedQueue<genomeBatch>& emptyBatches);                                                               // screens batches of genomes until the queue is closed
+        void _screenGroup(const std::string* const* seqs, std::size_t numSeqs, std::vector<PrimerScreenCounts>& counts, std::vector<unsigned int>& scores) const;       // finds the best match for each primer site in a group of up to PRIMERSCREEN_LANES genomes
+        unsigned int _alignSite(const primerSite& site, const std::string& seq, int64_t start, int64_t end, std::vector<unsigned int>& scores, bool& threePrime) const; // aligns a site to the genome bases ending at a hit (using the scores as scratch), returning the weighted score
+        void _writeCounts(void);                                                                                                                                        // writes a line per primer to the output
+
+        // data holders
+        const artic::PrimerScheme* _primerScheme;    // the loaded primer scheme
+        const std::string _refFile;                  // the reference fasta file
+        const std::vector<std::string> _genomeFiles; // the genome FASTA files to screen
+        std::ostream* _output;                       // where the primer results are written
+        std::vector<primerSite> _sites;              // the encoded primer sites, in scheme order
+        std::vector<PrimerScreenCounts> _counts;     // the screening results for each primer, in scheme order
+        std::mutex _countsMutex;                     // guards the counts while workers add to them
+
+        // user parameters
+        unsigned int _numThreads;       // the number of screening threads
+        unsigned int _searchWindow;     // the number of bases either side of a primer site to search
+        unsigned int _threePrimeBases;  // the number of bases at the 3' end of a primer where edits count extra
+        unsigned int _threePrimeWeight; // the weight of a 3' edit
+        unsigned int _riskScore;        // the weighted edit score at which a primer is at risk for a genome
+        float _riskProportion;          // the proportion of genomes at risk for a primer to be reported
+        KmerKernel _kernel;             // the instruction set used to search for the primer sites
+
+        // counters
+        uint64_t _numGenomes; // number of genomes screened (only updated by the parser)
+    };
+
+} // namespace artic
+
+#endif
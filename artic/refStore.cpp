@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <kseq++/seqio.hpp>
+
+#include "kmers.hpp"
+#include "refStore.hpp"
+
+using namespace klibpp;
+
+// BASES_PER_WORD is the number of 2-bit bases packed into each word of a sequence.
+const int64_t BASES_PER_WORD = 32;
+
+// getBase returns the 2-bit encoding of a base in a packed sequence.
+static inline uint8_t getBase(const std::vector<uint64_t>& bases, int64_t pos)
+{
+    return (bases[pos / BASES_PER_WORD] >> ((pos % BASES_PER_WORD) * 2)) & 3ULL;
+}
+
+// firstNrun returns the first N run that ends after the provided position.
+static inline std::vector<std::pair<int64_t, int64_t>>::const_iterator firstNrun(const std::vector<std::pair<int64_t, int64_t>>& nRuns, int64_t pos)
+{
+    return std::upper_bound(nRuns.begin(), nRuns.end(), pos, [](int64_t p, const std::pair<int64_t, int64_t>& run) { return p < run.second; });
+}
+
+// RefStore constructor.
+artic::RefStore::RefStore(const std::string& fastaFile)
+    : _filename(fastaFile)
+{
+    if (fastaFile.size() == 0)
+        throw std::runtime_error("no reference sequence provided");
+    if (!boost::filesystem::exists(fastaFile))
+        throw std::runtime_error("supplied reference file does not exist:\t" + fastaFile);
+
+    // read each sequence and pack it
+    KSeq record;
+    SeqStreamIn iss(fastaFile.c_str());
+    while (iss >> record)
+    {
+        if (HasSeq(record.name))
+            throw std::runtime_error("duplicate sequence ID in reference file: " + record.name);
+        _addSeq(record.name, record.seq);
+    }
+    if (_seqs.size() == 0)
+        throw std::runtime_error("no sequences found in reference file: " + fastaFile);
+}
+
+// GetFileName returns the FASTA file that the store was loaded from.
+const std::string& artic::RefStore::GetFileName(void) const { return _filename; }
+
+// GetNumSeqs returns the number of sequences in the store.
+std::size_t artic::RefStore::GetNumSeqs(void) const { return _seqs.size(); }
+
+// HasSeq returns true if the store contains the provided sequence ID.
+bool artic::RefStore::HasSeq(const std::string& seqID) const { return _seqs.find(seqID) != _seqs.end(); }
+
+// GetSeqLen returns the length of a sequence in the store.
+int64_t artic::RefStore::GetSeqLen(const std::string& seqID) const
+{
+    auto it = _seqs.find(seqID);
+    if (it == _seqs.end())
+        throw std::runtime_error("sequence not found in reference: " + seqID);
+    return it->second.length;
+}
+
+// GetPackedSize returns the number of bytes used to hold the packed bases and N runs.
+std::size_t artic::RefStore::GetPackedSize(void) const
+{
+    std::size_t size = 0;
+    for (const auto& seq : _seqs)
+        size += (seq.second.bases.size() * sizeof(uint64_t)) + (seq.second.nRuns.size() * sizeof(std::pair<int64_t, int64_t>));
+    return size;
+}
+
+// GetSeq will decode a region of a sequence into the provided string (uppercase, N for non-ACGT).
+void artic::RefStore::GetSeq(const std::string& seqID, int64_t start, int64_t end, std::string& seq) const
+{
+    const auto& packed = _getPackedSeq(seqID, start, end);
+    seq.resize(end - start);
+    for (int64_t i = start; i < end; ++i)
+        seq[i - start] = artic::char2nt[getBase(packed.bases, i)];
+
+    // overwrite any N runs within the region
+    for (auto nRun = firstNrun(packed.nRuns, start); nRun != packed.nRuns.end() && nRun->first < end; ++nRun)
+        for (int64_t i = std::max(nRun->first, start); i < std::min(nRun->second, end); ++i)
+            seq[i - start] = 'N';
+    return;
+}
+
+// CountMismatches returns the number of bases in a query that don't match the reference, starting from the provided position.
+unsigned int artic::RefStore::CountMismatches(const std::string& seqID, int64_t start, const char* query, uint32_t queryLen) const
+{
+    int64_t end = start + queryLen;
+    const auto& packed = _getPackedSeq(seqID, start, end);
+    unsigned int mismatches = 0;
+    auto nRun = firstNrun(packed.nRuns, start);
+    for (int64_t i = start; i < end; ++i)
+    {
+        if (nRun != packed.nRuns.end() && i >= nRun->second)
+            ++nRun;
+
+        // N in either sequence counts as a mismatch
+        uint8_t base = artic::nt2char[static_cast<uint8_t>(query[i - start])];
+        if ((base > 3) || (nRun != packed.nRuns.end() && i >= nRun->first) || (base != getBase(packed.bases, i)))
+            mismatches++;
+    }
+    return mismatches;
+}
+
+// _getPackedSeq returns a sequence after checking the region is within it.
+const artic::RefStore::PackedSeq& artic::RefStore::_getPackedSeq(const std::string& seqID, int64_t start, int64_t end) const
+{
+    auto it = _seqs.find(seqID);
+    if (it == _seqs.end())
+        throw std::runtime_error("sequence not found in reference: " + seqID);
+    if ((start < 0) || (start > end) || (end > it->second.length))
+        throw std::runtime_error("requested region is outside of reference sequence " + seqID + " (" + std::to_string(start) + "-" + std::to_string(end) + ")");
+    return it->second;
+}
+
+// _addSeq packs a sequence and adds it to the store.
+void artic::RefStore::_addSeq(const std::string& seqID, const std::string& seq)
+{
+    PackedSeq packed;
+    packed.length = seq.size();
+    packed.bases.resize((packed.length + BASES_PER_WORD - 1) / BASES_PER_WORD, 0);
+    for (int64_t i = 0; i < packed.length; ++i)
+    {
+        uint8_t base = artic::nt2char[static_cast<uint8_t>(seq[i])];
+
+        // record non-ACGT bases as N runs, extending the last run if they are adjacent
+        if (base > 3)
+        {
+            if (!packed.nRuns.empty() && packed.nRuns.back().second == i)
+                packed.nRuns.back().second++;
+            else
+                packed.nRuns.emplace_back(i, i + 1);
+            continue;
+        }
+        packed.bases[i / BASES_PER_WORD] |= uint64_t(base) << ((i % BASES_PER_WORD) * 2);
+    }
+    _seqs.emplace(seqID, std::move(packed));
+}
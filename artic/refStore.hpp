@@ -0,0 +1,67 @@
+#ifndef REFSTORE_H
+#define REFSTORE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bytell_hash_map.hpp"
+
+namespace artic
+{
+    //******************************************************************************
+    // RefStore holds reference sequences in memory as 2-bit packed bases.
+    //
+    // NOTES:
+    // * all the sequences in the FASTA file are loaded once, on construction
+    // * bases are packed 32 to a 64-bit word, so a 30 kb genome is ~8 KB
+    // * any non-ACGT bases are stored as N runs in a side table (packed as A)
+    // * coordinates are 0-based, half-open (as per BED)
+    // * the store is read-only once loaded, so it can be shared between threads
+    //******************************************************************************
+    class RefStore
+    {
+    public:
+        // RefStore constructor.
+        RefStore(const std::string& fastaFile);
+
+        // GetFileName returns the FASTA file that the store was loaded from.
+        const std::string& GetFileName(void) const;
+
+        // GetNumSeqs returns the number of sequences in the store.
+        std::size_t GetNumSeqs(void) const;
+
+        // HasSeq returns true if the store contains the provided sequence ID.
+        bool HasSeq(const std::string& seqID) const;
+
+        // GetSeqLen returns the length of a sequence in the store.
+        int64_t GetSeqLen(const std::string& seqID) const;
+
+        // GetPackedSize returns the number of bytes used to hold the packed bases and N runs.
+        std::size_t GetPackedSize(void) const;
+
+        // GetSeq will decode a region of a sequence into the provided string (uppercase, N for non-ACGT).
+        void GetSeq(const std::string& seqID, int64_t start, int64_t end, std::string& seq) const;
+
+        // CountMismatches returns the number of bases in a query that don't match the reference, starting from the provided position.
+        unsigned int CountMismatches(const std::string& seqID, int64_t start, const char* query, uint32_t queryLen) const;
+
+    private:
+        // PackedSeq is a single 2-bit packed sequence.
+        typedef struct PackedSeq
+        {
+            int64_t length;                                 // the number of bases in the sequence
+            std::vector<uint64_t> bases;                    // the 2-bit packed bases, 32 per word
+            std::vector<std::pair<int64_t, int64_t>> nRuns; // the start and end of each run of non-ACGT bases, sorted by start
+        } PackedSeq;
+
+        const PackedSeq& _getPackedSeq(const std::string& seqID, int64_t start, int64_t end) const; // returns a sequence after checking the region is within it
+        void _addSeq(const std::string& seqID, const std::string& seq);                            // packs a sequence and adds it to the store
+
+        std::string _filename;                              // the FASTA file that the store was loaded from
+        ska::bytell_hash_map<std::string, PackedSeq> _seqs; // the packed sequences, keyed by sequence ID
+    };
+
+} // namespace artic
+
+#endif
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include "fastqReader.hpp"
+#include "schemeDetector.hpp"
+
+// SchemeDetector constructor (builds the combined index from the primers of two or more candidate schemes, which must share a reference).
+artic::SchemeDetector::SchemeDetector(const std::vector<artic::PrimerScheme>& schemes, const std::vector<std::string>& schemeNames, const artic::RefStore& reference, uint32_t kSize, uint32_t endWindow, uint32_t minHits)
+    : _schemeNames(schemeNames), _kSize(kSize), _endWindow(endWindow), _minHits(minHits), _numReads(0), _scanner(&SchemeDetector::_scanKmers<0>)
+{
+    if (schemes.size() < 2)
+        throw std::runtime_error("at least two candidate schemes are needed to detect a scheme");
+    if (schemes.size() > MAX_DETECTOR_SCHEMES)
+        throw std::runtime_error("too many candidate schemes (max " + std::to_string(MAX_DETECTOR_SCHEMES) + ")");
+    if (schemeNames.size() != schemes.size())
+        throw std::runtime_error("number of scheme names does not match the number of schemes");
+    if (_kSize == 0 || _kSize > MAX_K_SIZE)
+        throw std::runtime_error("k-mer size must be > 0 and <= " + std::to_string(MAX_K_SIZE));
+    if (_endWindow < _kSize)
+        throw std::runtime_error("read end window must be >= the k-mer size");
+    if (_minHits == 0)
+        throw std::runtime_error("minimum number of read ends for a primer k-mer must be > 0");
+
+    // collect the schemes for each primer k-mer
+    std::unordered_map<kmer_t, uint64_t> schemeMap;
+    _schemeKmers.assign(schemes.size(), 0);
+    for (std::size_t i = 0; i < schemes.size(); i++)
+    {
+        artic::kmermap_t kmerMap;
+        schemes[i].GetPrimerKmers(reference, _kSize, kmerMap);
+        for (const auto& kmer : kmerMap)
+            schemeMap[kmer.first] |= (1ULL << i);
+        _schemeKmers[i] = kmerMap.size();
+    }
+    std::vector<entry> entries;
+    entries.reserve(schemeMap.size());
+    for (const auto& kmer : schemeMap)
+        entries.push_back({kmer.first, kmer.second});
+    _kmers = artic::KmerTable<entry>(std::move(entries), _kSize);
+    _counts.assign(_kmers.GetEntries().size(), 0);
+
+    // select the read end scan once, with the k-mer size fixed at compile time
+    artic::DispatchKmerSize<artic::MAX_K_SIZE>(_kSize, [&](auto k) { _scanner = &SchemeDetector::_scanKmers<decltype(k)::value>; });
+}
+
+// GetNumSchemes returns the number of candidate schemes.
+std::size_t artic::SchemeDetector::GetNumSchemes(void) const { return _schemeNames.size(); }
+
+// GetSchemeName returns the name of a candidate scheme.
+const std::string& artic::SchemeDetector::GetSchemeName(std::size_t schemeID) const
+{
+    if (schemeID >= _schemeNames.size())
+        throw std::runtime_error("scheme ID not found in detector: " + std::to_string(schemeID));
+    return _schemeNames[schemeID];
+}
+
+// GetNumKmers returns the number of distinct primer k-mers in the combined index.
+std::size_t artic::SchemeDetector::GetNumKmers(void) const { return _kmers.GetEntries().size(); }
+
+// GetMemoryUsage returns the number of bytes used by the index and the k-mer counts.
+std::size_t artic::SchemeDetector::GetMemoryUsage(void) const { return _kmers.GetMemoryUsage() + (_counts.size() * sizeof(uint32_t)); }
+
+// GetNumReads returns the number of reads added.
+uint64_t artic::SchemeDetector::GetNumReads(void) const { return _numReads; }
+
+// AddRead will count the primer k-mers found at the ends of a read.
+void artic::SchemeDetector::AddRead(const std::string& seq)
+{
+    _numReads++;
+    uint32_t seqLen = seq.size();
+    uint32_t window = std::min(seqLen, _endWindow);
+    (this->*_scanner)(seq.c_str(), window, false);
+    (this->*_scanner)(seq.c_str() + seqLen - window, window, true);
+}
+
+// AddReads will add the reads from a FASTQ file, stopping once the total number of reads added reaches maxReads (0 for no limit), and returns the number added from the file.
+uint64_t artic::SchemeDetector::AddReads(const std::string& fileName, uint64_t maxReads)
+{
+    artic::FastqReader reader(fileName, nullptr);
+    klibpp::KSeq record;
+    uint64_t numAdded = 0;
+    while ((maxReads == 0 || _numReads < maxReads) && reader.Read(record))
+    {
+        AddRead(record.seq);
+        numAdded++;
+    }
+    return numAdded;
+}
+
+// GetScores returns the evidence for each candidate scheme, best first.
+std::vector<artic::SchemeScore> artic::SchemeDetector::GetScores(void) const
+{
+    const auto& entries = _kmers.GetEntries();
+    std::vector<SchemeScore> scores;
+    for (std::size_t i = 0; i < _schemeNames.size(); i++)
+        scores.push_back({i, _schemeKmers[i], 0, 0, 0});
+    for (std::size_t i = 0; i < entries.size(); i++)
+    {
+        if (!_isSeen(i))
+            continue;
+        for (auto& score : scores)
+            if (entries[i].schemes & (1ULL << score.schemeID))
+                score.numSeen++;
+    }
+    for (auto& score : scores)
+    {
+        score.containment = (score.numKmers != 0) ? float(score.numSeen) / float(score.numKmers) : 0;
+        score.score = int64_t(score.numSeen) - int64_t(score.numKmers - score.numSeen);
+    }
+
+    // ties go to the most complete scheme, and then to the first given
+    std::sort(scores.begin(), scores.end(), [](const SchemeScore& lhs, const SchemeScore& rhs) {
+        if (lhs.score != rhs.score)
+            return lhs.score > rhs.score;
+        if (lhs.containment != rhs.containment)
+            return lhs.containment > rhs.containment;
+        return lhs.schemeID < rhs.schemeID;
+    });
+    return scores;
+}
+
+// GetConfidence returns the proportion of the k-mers that differ between the top two schemes which agree with the top scheme (0 if nothing has been seen or the top two can't be told apart).
+float artic::SchemeDetector::GetConfidence(void) const
+{
+    auto scores = GetScores();
+    if (scores.front().numSeen == 0)
+        return 0;
+
+    // a differing k-mer agrees with the top scheme if it is only in the top scheme and was seen, or only in the runner up and wasn't seen
+    auto top = 1ULL << scores[0].schemeID;
+    auto runnerUp = 1ULL << scores[1].schemeID;
+    const auto& entries = _kmers.GetEntries();
+    uint32_t numDiffering = 0;
+    uint32_t numAgreeing = 0;
+    for (std::size_t i = 0; i < entries.size(); i++)
+    {
+        bool inTop = entries[i].schemes & top;
+        if (inTop == bool(entries[i].schemes & runnerUp))
+            continue;
+        numDiffering++;
+        if (inTop == _isSeen(i))
+            numAgreeing++;
+    }
+    return (numDiffering != 0) ? float(numAgreeing) / float(numDiffering) : 0;
+}
+
+// _scanKmers counts the read k-mers that match the outermost primer k-mers in a read end (K fixes the k-mer size, 0 for runtime).
+template <uint32_t K>
+void artic::SchemeDetector::_scanKmers(const char* seq, uint32_t len, bool tail)
+{
+    _hits.clear();
+    const auto* first = _kmers.GetEntries().data();
+    for (const auto& kmer : artic::KmerScanner<K>(seq, len, _kSize))
+        if (auto entry = _kmers.Find<K>(kmer.kmer))
+            _hits.emplace_back(entry - first, kmer.end);
+    if (_hits.empty())
+        return;
+
+    // primer k-mers further in than the outermost primer (e.g. from primers of other schemes in the amplicon overlaps) are ignored
+    uint32_t maxGap = (DETECTOR_PRIMER_SPAN > _kSize) ? DETECTOR_PRIMER_SPAN - _kSize : 0;
+    uint32_t outermost = (tail) ? _hits.back().second : _hits.front().second;
+    for (const auto& hit : _hits)
+        if (((tail) ? outermost - hit.second : hit.second - outermost) <= maxGap)
+            _counts[hit.first]++;
+}
+
+// _isSeen returns true if a k-mer has been found at enough read ends.
+bool artic::SchemeDetector::_isSeen(std::size_t i) const { return _counts[i] >= _minHits; }
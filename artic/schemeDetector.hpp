@@ -0,0 +1,104 @@
+#ifndef SCHEMEDETECTOR_H
+#define SCHEMEDETECTOR_H
+
+#include <string>
+#include <vector>
+
+#include "kmerTable.hpp"
+#include "kmers.hpp"
+#include "primerScheme.hpp"
+#include "refStore.hpp"
+
+namespace artic
+{
+    // MAX_DETECTOR_SCHEMES is the maximum number of schemes a SchemeDetector can hold (one bit per scheme for each k-mer).
+    const std::size_t MAX_DETECTOR_SCHEMES = 64;
+
+    // DETECTOR_PRIMER_SPAN is the longest primer expected, only primer k-mers within this many bases of the outermost primer k-mer hit at each read end are counted.
+    const uint32_t DETECTOR_PRIMER_SPAN = 40;
+
+    // SchemeScore is the evidence for one of the candidate schemes.
+    struct SchemeScore
+    {
+        std::size_t schemeID; // the candidate scheme (the order the schemes were given in)
+        uint32_t numKmers;    // the number of primer k-mers in the scheme
+        uint32_t numSeen;     // the number of primer k-mers seen (found at the minimum number of read ends)
+        float containment;    // the proportion of the scheme primer k-mers seen
+        int64_t score;        // the number of primer k-mers seen minus the number not seen, which ranks the schemes
+    };
+
+    //******************************************************************************
+    // SchemeDetector finds the primer scheme used for a sample by streaming reads through a combined index of the primer k-mers of several candidate schemes.
+    //
+    // NOTES:
+    // * the primer k-mers of all the schemes are held in one index, each k-mer records the schemes it came from as bit flags
+    // * schemes for the same virus tile the same genome, so any scheme's primers will be found somewhere in the reads,
+    //   only the outermost primer k-mer hits at each read end are counted as that is where the primers of the scheme used will be
+    // * a primer k-mer is seen once it is at the end of enough reads, which stops sequencing errors and chance matches counting
+    // * schemes are ranked by the primer k-mers seen minus those not seen, so a scheme is not picked just for having more primers (e.g. V4.1 over V4)
+    // * the confidence is the proportion of the k-mers that differ between the top two schemes which agree with the top scheme
+    // * the combined index is a KmerTable, probed by a read end scan with the k-mer size fixed at compile time (selected once when the index is built)
+    //******************************************************************************
+    class SchemeDetector
+    {
+    public:
+        // SchemeDetector constructor (builds the combined index from the primers of two or more candidate schemes, which must share a reference).
+        SchemeDetector(const std::vector<PrimerScheme>& schemes, const std::vector<std::string>& schemeNames, const RefStore& reference, uint32_t kSize = 15, uint32_t endWindow = 100, uint32_t minHits = 3);
+
+        // GetNumSchemes returns the number of candidate schemes.
+        std::size_t GetNumSchemes(void) const;
+
+        // GetSchemeName returns the name of a candidate scheme.
+        const std::string& GetSchemeName(std::size_t schemeID) const;
+
+        // GetNumKmers returns the number of distinct primer k-mers in the combined index.
+        std::size_t GetNumKmers(void) const;
+
+        // GetMemoryUsage returns the number of bytes used by the index and the k-mer counts.
+        std::size_t GetMemoryUsage(void) const;
+
+        // GetNumReads returns the number of reads added.
+        uint64_t GetNumReads(void) const;
+
+        // AddRead will count the primer k-mers found at the ends of a read.
+        void AddRead(const std::string& seq);
+
+        // AddReads will add the reads from a FASTQ file, stopping once the total number of reads added reaches maxReads (0 for no limit), and returns the number added from the file.
+        uint64_t AddReads(const std::string& fileName, uint64_t maxReads = 0);
+
+        // GetScores returns the evidence for each candidate scheme, best first.
+        std::vector<SchemeScore> GetScores(void) const;
+
+        // GetConfidence returns the proportion of the k-mers that differ between the top two schemes which agree with the top scheme (0 if nothing has been seen or the top two can't be told apart).
+        float GetConfidence(void) const;
+
+    private:
+        // entry is a primer k-mer and the schemes it came from.
+        struct entry
+        {
+            kmer_t kmer;      // the canonical primer k-mer
+            uint64_t schemes; // bit flags for the schemes with the k-mer (bit 0 = the first scheme)
+        };
+
+        // scanKmers_t is a _scanKmers specialisation.
+        typedef void (SchemeDetector::*scanKmers_t)(const char* seq, uint32_t len, bool tail);
+
+        template <uint32_t K>
+        void _scanKmers(const char* seq, uint32_t len, bool tail); // counts the read k-mers that match the outermost primer k-mers in a read end (K fixes the k-mer size, 0 for runtime)
+        bool _isSeen(std::size_t i) const;                         // returns true if a k-mer has been found at enough read ends
+
+        std::vector<std::string> _schemeNames;            // the names of the candidate schemes
+        std::vector<uint32_t> _schemeKmers;               // the number of primer k-mers in each scheme
+        uint32_t _kSize;                                  // the k-mer size
+        uint32_t _endWindow;                              // the number of bases to search at each read end
+        uint32_t _minHits;                                // the number of read ends a primer k-mer must be found at to be seen
+        uint64_t _numReads;                               // the number of reads added
+        KmerTable<entry> _kmers;                          // the primer k-mers of all the schemes
+        scanKmers_t _scanner;                             // the _scanKmers specialisation for the k-mer size
+        std::vector<uint32_t> _counts;                    // the number of times each primer k-mer has been found at a read end
+        std::vector<std::pair<uint32_t, uint32_t>> _hits; // the entry and read position of each primer k-mer hit in the read end being scanned
+    };
+
+} // namespace artic
+
+#endif
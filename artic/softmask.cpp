@@ -106,8 +106,8 @@ void artic::Softmasker::_softmask(bool maskPrimers)
 }
 
 // Softmasker constructor.
-artic::Softmasker::Softmasker(artic::PrimerScheme* primerScheme, const std::string& bamFile, const std::string& userCmd, unsigned int minMAPQ, unsigned int normalise, bool removeBadPairs, bool noReadGroups, bool primerStart, const std::string& reportFilename)
-    : _primerScheme(primerScheme), _minMAPQ(minMAPQ), _normalise(normalise), _removeBadPairs(removeBadPairs), _noReadGroups(noReadGroups), _maskPrimerStart(primerStart)
+artic::Softmasker::Softmasker(const artic::PrimerScheme* primerScheme, const std::string& bamFile, const std::string& userCmd, unsigned int minMAPQ, unsigned int normalise, bool removeBadPairs, bool noReadGroups, bool primerStart, const std::string& reportFilename)
+    : _primerScheme(primerScheme), _primerCursor(primerScheme), _minMAPQ(minMAPQ), _normalise(normalise), _removeBadPairs(removeBadPairs), _noReadGroups(noReadGroups), _maskPrimerStart(primerStart)
 {
 
     // get the input BAM or use STDIN if none given
@@ -199,7 +199,7 @@ void artic::Softmasker::Run(bool verbose)
         }
 
         // get predicted amplicon for this alignment record based on the nearest primers
-        auto amplicon = _primerScheme->FindPrimers(_curRec->core.pos, bam_endpos(_curRec));
+        auto amplicon = _primerCursor.FindPrimers(_curRec->core.pos, bam_endpos(_curRec));
         _curAmplicon = &amplicon;
 
         // add a primer pool readgroup to the alignment record based on the primer pairing
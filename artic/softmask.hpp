@@ -27,7 +27,7 @@ namespace artic
     {
     public:
         // Softmasker constructor and destructor.
-        Softmasker(artic::PrimerScheme* primerScheme, const std::string& bamFile, const std::string& userCmd, unsigned int minMAPQ, unsigned int normalise, bool removeBadPairs, bool noReadGroups, bool primerStart, const std::string& reportFilename);
+        Softmasker(const artic::PrimerScheme* primerScheme, const std::string& bamFile, const std::string& userCmd, unsigned int minMAPQ, unsigned int normalise, bool removeBadPairs, bool noReadGroups, bool primerStart, const std::string& reportFilename);
         ~Softmasker(void);
 
         // Run will perform the softmasking on the open BAM file.
@@ -40,7 +40,8 @@ namespace artic
         void _softmask(bool maskPrimers);     // performs the CIGAR string adjustment for the current record
 
         // data holders
-        artic::PrimerScheme* _primerScheme;                          // the loaded primer scheme
+        const artic::PrimerScheme* _primerScheme;                    // the loaded primer scheme
+        artic::PrimerCursor _primerCursor;                           // finds primers for the (usually coordinate sorted) alignment records
         htsFile* _inputBAM;                                          // the input BAM for softmasking
         bam_hdr_t* _bamHeader;                                       // the input BAM header
         bam1_t* _curRec;                                             // the current alignment record being processed
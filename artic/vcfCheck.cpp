@@ -6,7 +6,7 @@
 #include "version.hpp"
 
 // VcfChecker constructor.
-artic::VcfChecker::VcfChecker(artic::PrimerScheme* primerScheme, const std::string& vcfIn, const std::string& reportOut, const std::string& vcfOut, float minQual)
+artic::VcfChecker::VcfChecker(const artic::PrimerScheme* primerScheme, const std::string& vcfIn, const std::string& reportOut, const std::string& vcfOut, float minQual)
     : _primerScheme(primerScheme), _inputVCFfilename(vcfIn), _outputReportfilename(reportOut), _outputVCFfilename(vcfOut), _minQual(minQual)
 {
     // get the input VCF ready
@@ -118,8 +118,11 @@ void artic::VcfChecker::_getRecordStats()
     LOG_TRACE("variant at pos {}: {}->{}", adjustedPos, _prevRec->d.allele[0], _prevRec->d.allele[1]);
     bool discardRec = false;
 
+    // get the scheme annotation for this position (position has already been checked against scheme bounds)
+    const auto& site = _primerScheme->GetPosition(_prevRec->pos);
+
     // check if in primer site
-    if (_primerScheme->CheckPrimerSite(_prevRec->pos))
+    if (site.IsPrimerSite())
     {
         LOG_WARN("\tlocated within a primer sequence");
         _numPrimerSeq++;
@@ -134,7 +137,7 @@ void artic::VcfChecker::_getRecordStats()
     }
 
     // check amplicon overlap
-    if (_primerScheme->CheckAmpliconOverlap(_prevRec->pos))
+    if (site.IsOverlap())
     {
         LOG_TRACE("\tlocated within an amplicon overlap region");
         _numAmpOverlap++;
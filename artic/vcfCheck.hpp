@@ -15,7 +15,7 @@ namespace artic
     {
     public:
         // VcfChecker constructor and destructor.
-        VcfChecker(artic::PrimerScheme* primerScheme, const std::string& vcfIn, const std::string& reportOut, const std::string& vcfOut, float minQual);
+        VcfChecker(const artic::PrimerScheme* primerScheme, const std::string& vcfIn, const std::string& reportOut, const std::string& vcfOut, float minQual);
         ~VcfChecker(void);
 
         // Run will perform the filtering on the open VCF file.
@@ -30,15 +30,15 @@ namespace artic
         void _getRecordStats();
 
         // data holders
-        artic::PrimerScheme* _primerScheme; // the loaded primer scheme
-        std::string _inputVCFfilename;      // the filename of the input VCF file
-        std::string _outputReportfilename;  // the filename of the output report
-        std::string _outputVCFfilename;     // the filename of the output VCF file
-        vcfFile* _inputVCF;                 // the input VCF for filtering
-        bcf_hdr_t* _vcfHeader;              // the input VCF header
-        bcf1_t* _curRec;                    // the current VCF record being processed
-        bcf1_t* _prevRec;                   // the previous VCF record, used to check against
-        vcfFile* _outputVCF;                // the output VCF file
+        const artic::PrimerScheme* _primerScheme; // the loaded primer scheme
+        std::string _inputVCFfilename;            // the filename of the input VCF file
+        std::string _outputReportfilename;        // the filename of the output report
+        std::string _outputVCFfilename;           // the filename of the output VCF file
+        vcfFile* _inputVCF;                       // the input VCF for filtering
+        bcf_hdr_t* _vcfHeader;                    // the input VCF header
+        bcf1_t* _curRec;                          // the current VCF record being processed
+        bcf1_t* _prevRec;                         // the previous VCF record, used to check against
+        vcfFile* _outputVCF;                      // the output VCF file
 
         // user parameters
         float _minQual; // the QUAL threshold for keeping records
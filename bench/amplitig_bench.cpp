@@ -0,0 +1,129 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <artic/amplitig.hpp>
+#include <artic/log.hpp>
+#include <artic/primerScheme.hpp>
+#include <artic/refStore.hpp>
+#include <tests/testHelpers.hpp>
+using namespace artic;
+
+// some benchmark parameters
+const std::string schemeFile = std::string(TEST_DATA_PATH) + "SCoV2.scheme.v3.bed";
+const std::string refFile = std::string(TEST_DATA_PATH) + "SCoV2.reference.fasta";
+const std::string readsFile = "amplitig_bench.fastq";
+const unsigned int readsPerAmplicon = 200;
+const float minPrimerKmers = 0.2;
+float errorRate = 0.06;
+
+// binConfig is a k-mer setup to benchmark.
+struct binConfig
+{
+    std::string name;                  // the name to report
+    unsigned int kmerSize;             // the contiguous k-mer size (used if there are no seeds)
+    std::vector<std::string> patterns; // the spaced seed patterns
+};
+
+// simulateRead adds substitutions, insertions and deletions to a sequence, half of them as reverse complements.
+std::string simulateRead(const std::string& seq, bool reverse, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> errorDist(0.0, 1.0);
+    std::uniform_int_distribution<int> baseDist(0, 3);
+    std::string read;
+    for (auto base : seq)
+    {
+        float error = errorDist(rng);
+        if (error < errorRate * 0.5)
+            read += "ACGT"[(nt2char[uint8_t(base)] + 1 + baseDist(rng) % 3) % 4]; // substitution
+        else if (error < errorRate * 0.75)
+            read += std::string(1, base) + "ACGT"[baseDist(rng)]; // insertion
+        else if (error >= errorRate)
+            read += base; // no error (otherwise a deletion)
+    }
+    return (reverse) ? reverseComplement(read) : read;
+}
+
+// amplitig_bench reports the binning sensitivity and throughput of contiguous and spaced seed k-mers on simulated reads (usage: amplitig_bench [error rate]).
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        errorRate = std::stof(argv[1]);
+    if (errorRate < 0.0 || errorRate >= 1.0)
+    {
+        std::cerr << "error rate must be >= 0 and < 1" << std::endl;
+        return 1;
+    }
+    Log::Init("amplitig_bench");
+    Log::GetClientLogger()->set_level(spdlog::level::off);
+
+    // simulate reads for each amplicon, skipping those over the read length limit
+    auto ps = PrimerScheme(schemeFile);
+    RefStore reference(refFile);
+    std::mt19937 rng(42);
+    std::ofstream fh(readsFile);
+    std::string seq;
+    unsigned int numReads = 0;
+    for (const auto& amplicon : ps.GetExpAmplicons())
+    {
+        reference.GetSeq(ps.GetReferenceName(), amplicon.GetForwardPrimer()->GetStart(), amplicon.GetReversePrimer()->GetEnd(), seq);
+        for (unsigned int i = 0; i < readsPerAmplicon; i++)
+        {
+            auto read = simulateRead(seq, i % 2, rng);
+            if (read.size() > ps.GetMaxAmpliconSpan() * 1.1)
+                continue;
+            fh << "@" << amplicon.GetName() << "_" << i << "\n"
+               << read << "\n+\n"
+               << std::string(read.size(), 'I') << "\n";
+            numReads++;
+        }
+    }
+    fh.close();
+    std::cout << "reads: " << numReads << " (up to " << readsPerAmplicon << " per amplicon), error rate = " << errorRate << ", min. primer k-mers = " << minPrimerKmers << std::endl;
+
+    // bin the reads with each config (the seeds are symmetric, so their canonical k-mers tolerate the same substitutions on either strand)
+    std::vector<binConfig> configs = {
+        {"k=11", 11, {}},
+        {"k=15", 15, {}},
+        {"1 seed (w=11)", 0, {"110111010111011"}},
+        {"1 seed (w=12)", 0, {"1101101111011011"}},
+        {"2 seeds (w=11)", 0, {"110111010111011", "11011001110011011"}},
+    };
+    std::cout << std::left << std::setw(18) << "config" << std::setw(14) << "sensitivity" << std::setw(14) << "misbinned" << "throughput" << std::endl;
+    for (const auto& config : configs)
+    {
+        std::ostringstream output;
+        Amplitigger amplitigger(&ps, refFile, {readsFile}, config.patterns.empty() ? config.kmerSize : 11, minPrimerKmers, 1, output);
+        if (!config.patterns.empty())
+            amplitigger.SetSpacedSeeds(config.patterns);
+        auto start = std::chrono::steady_clock::now();
+        amplitigger.Run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        // a read is correct if one of its bins is the amplicon it came from
+        std::unordered_map<std::string, bool> reads;
+        std::string line;
+        std::istringstream lines(output.str());
+        while (std::getline(lines, line))
+        {
+            auto readName = line.substr(0, line.find('\t'));
+            auto ampliconName = line.substr(line.find('\t') + 1, line.rfind('\t') - line.find('\t') - 1);
+            reads[readName] = reads[readName] || (readName.substr(0, readName.rfind('_')) == ampliconName);
+        }
+        unsigned int correct = 0;
+        for (const auto& read : reads)
+            correct += read.second;
+        std::cout << std::left << std::setw(18) << config.name << std::fixed << std::setprecision(2)
+                  << std::setw(14) << (100.0 * correct / numReads) << std::setw(14) << (100.0 * (reads.size() - correct) / numReads)
+                  << std::setprecision(0) << (numReads / elapsed.count()) << " reads/s" << std::endl;
+    }
+    std::remove(readsFile.c_str());
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <artic/kmers.hpp>
+using namespace artic;
+
+// some benchmark parameters
+const unsigned int numReads = 20000;
+const unsigned int readLength = 500;
+const unsigned int numRounds = 5;
+unsigned int kSize = 15;
+
+// legacyEncodedKmers is the original per-base k-mer loop (nt2char lookup per base, no reserve), kept as a baseline.
+void legacyEncodedKmers(const char* seq, uint32_t seqLen, uint32_t kSize, kmerset_t& kmers)
+{
+    uint64_t kmerMask = (1ULL << (2 * kSize)) - 1;
+    uint64_t bitShift = 2 * (kSize - 1);
+    kmer_t x[2];
+    x[0] = x[1] = 0;
+    uint32_t l = 0;
+    for (uint32_t i = 0; i < seqLen; i++)
+    {
+        uint8_t base = (uint8_t)seq[i] < 128 ? nt2char[static_cast<uint8_t>(seq[i])] : 4;
+        if (base > 3)
+            continue;
+        x[0] = (x[0] << 2 | base) & kmerMask;
+        x[1] = x[1] >> 2 | (uint64_t)(3ULL - base) << bitShift;
+        if (++l >= kSize)
+            (x[0] <= x[1]) ? kmers.emplace_back(x[0]) : kmers.emplace_back(x[1]);
+    }
+}
+
+// runBenchmark times a k-mer function over all the reads and returns the throughput in Mbases/s.
+template <typename F>
+double runBenchmark(const std::vector<std::string>& reads, F kmerFunc, uint64_t& checksum)
+{
+    kmerset_t kmers;
+    checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int round = 0; round < numRounds; round++)
+        for (const auto& read : reads)
+        {
+            kmers.clear();
+            kmerFunc(read.c_str(), read.size(), kSize, kmers);
+            for (auto kmer : kmers)
+                checksum += kmer;
+        }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return (double(numReads) * readLength * numRounds) / elapsed.count() / 1e6;
+}
+
+// kmers_bench compares the throughput of the k-mer kernels on simulated reads (usage: kmers_bench [k-mer size]).
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        kSize = std::stoi(argv[1]);
+    if (kSize == 0 || kSize >= MAX_K_SIZE)
+    {
+        std::cerr << "k-mer size must be > 0 and < " << MAX_K_SIZE << std::endl;
+        return 1;
+    }
+
+    // simulate some reads, with the odd N
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> baseDist(0, 199);
+    std::vector<std::string> reads(numReads);
+    for (auto& read : reads)
+    {
+        read.resize(readLength);
+        for (auto& base : read)
+        {
+            int b = baseDist(rng);
+            base = (b < 199) ? "ACGT"[b % 4] : 'N';
+        }
+    }
+    std::cout << "reads: " << numReads << " x " << readLength << " bp, k = " << kSize << ", rounds = " << numRounds << std::endl;
+    std::cout << "detected kernel: " << GetKmerKernelName(GetKmerKernel()) << std::endl;
+
+    // run the baseline
+    uint64_t expected;
+    double baseline = runBenchmark(reads, legacyEncodedKmers, expected);
+    std::cout << std::left << std::setw(10) << "legacy" << std::fixed << std::setprecision(1) << baseline << " Mbases/s" << std::endl;
+
+    // run each kernel supported by the CPU and check the output is identical
+    for (int kernel = int(KmerKernel::scalar); kernel <= int(GetKmerKernel()); kernel++)
+    {
+        uint64_t checksum;
+        auto kmerFunc = [kernel](const char* seq, uint32_t seqLen, uint32_t k, kmerset_t& kmers) { GetEncodedKmers(seq, seqLen, k, kmers, KmerKernel(kernel)); };
+        double throughput = runBenchmark(reads, kmerFunc, checksum);
+        std::cout << std::left << std::setw(10) << GetKmerKernelName(KmerKernel(kernel)) << std::fixed << std::setprecision(1) << throughput << " Mbases/s (" << std::setprecision(2) << throughput / baseline << "x)";
+        if (checksum != expected)
+        {
+            std::cout << " - output does not match the baseline" << std::endl;
+            return 1;
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
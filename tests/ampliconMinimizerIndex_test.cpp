@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include <artic/ampliconMinimizerIndex.hpp>
+using namespace artic;
+
+// some test parameters
+const std::string minimizerScheme = std::string(TEST_DATA_PATH) + "SCoV2.scheme.v3.bed";
+const std::string minimizerReference = std::string(TEST_DATA_PATH) + "SCoV2.reference.fasta";
+
+// index built from the amplicon inserts of a scheme
+TEST(ampliconminimizerindex, scheme)
+{
+    auto ps = artic::PrimerScheme(minimizerScheme);
+    artic::RefStore reference(minimizerReference);
+    EXPECT_THROW(artic::AmpliconMinimizerIndex(ps, reference, 0, 10), std::runtime_error);
+    EXPECT_THROW(artic::AmpliconMinimizerIndex(ps, reference, artic::MAX_K_SIZE + 1, 10), std::runtime_error);
+    EXPECT_THROW(artic::AmpliconMinimizerIndex(ps, reference, 15, 0), std::runtime_error);
+    artic::AmpliconMinimizerIndex index(ps, reference, 15, 10);
+    EXPECT_EQ(index.GetKmerSize(), 15);
+    EXPECT_EQ(index.GetWindowSize(), 10);
+    EXPECT_GT(index.GetNumMinimizers(), 0);
+    EXPECT_GT(index.GetNumShared(), 0);
+    EXPECT_THROW(index.GetNumMinimizers(0U), std::runtime_error);
+    EXPECT_THROW(index.GetNumMinimizers(ps.GetNumAmplicons() + 1), std::runtime_error);
+
+    // every insert minimizer should be found for its amplicon, with shared minimizers coming from the overlaps of neighbouring amplicons
+    std::size_t numCounted = 0;
+    std::vector<artic::Kmer> minimizers;
+    std::string seq;
+    for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+    {
+        numCounted += index.GetNumMinimizers(id);
+        auto insert = ps.GetAmplicon(id).GetMinSpan();
+        reference.GetSeq(ps.GetReferenceName(), insert.first, insert.second, seq);
+        minimizers.clear();
+        artic::GetMinimizers(seq.c_str(), seq.size(), 15, 10, minimizers);
+        for (const auto& minimizer : minimizers)
+        {
+            auto entry = index.Find(minimizer.kmer);
+            if (!entry)
+                continue;
+            EXPECT_TRUE(entry->ampliconID == id || entry->sharedID == id);
+            EXPECT_EQ(entry->forward, minimizer.forward);
+            if (entry->sharedID != artic::NO_AMPLICON)
+            {
+                EXPECT_EQ(entry->sharedID, entry->ampliconID + 1);
+            }
+        }
+    }
+    EXPECT_EQ(numCounted, index.GetNumMinimizers() + index.GetNumShared());
+    EXPECT_EQ(index.Find(0), nullptr);
+    EXPECT_LT(index.GetMemoryUsage(), 1024 * 1024);
+}
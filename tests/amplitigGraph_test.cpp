@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+#include <artic/amplitigGraph.hpp>
+#include <tests/testHelpers.hpp>
+using namespace artic;
+
+// some test parameters
+const uint32_t graphKmerSize = 15;
+
+// graph construction and k-mer counting
+TEST(amplitiggraph, counts)
+{
+    EXPECT_THROW(artic::AmplitigGraph(0), std::runtime_error);
+    EXPECT_THROW(artic::AmplitigGraph(artic::MAX_K_SIZE + 1), std::runtime_error);
+
+    // k-mers from reverse strand reads are counted on the reference strand, non-ACGT bases break the k-mers
+    artic::AmplitigGraph graph(4);
+    EXPECT_EQ(graph.GetKmerSize(), 4);
+    std::string seq = "ACGTTGCA";
+    graph.AddRead(seq.c_str(), seq.size(), false);
+    auto rc = reverseComplement(seq);
+    graph.AddRead(rc.c_str(), rc.size(), true);
+    std::string withN = "ACGTNGCA";
+    graph.AddRead(withN.c_str(), withN.size(), false);
+    EXPECT_EQ(graph.GetNumReads(), 3);
+    EXPECT_EQ(graph.GetNumKmers(), 5);
+    EXPECT_EQ(graph.GetCount(0b00011011), 3); // ACGT
+    EXPECT_EQ(graph.GetCount(0b11100100), 2); // TGCA
+    EXPECT_EQ(graph.GetCount(0b11101001), 0); // TGGC
+
+    // the table should grow as k-mers are added (a random sequence should have no repeated 15-mers)
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> baseDist(0, 3);
+    std::string longSeq;
+    for (unsigned int i = 0; i < 5000; i++)
+        longSeq += artic::char2nt[baseDist(rng)];
+    artic::AmplitigGraph bigGraph(graphKmerSize);
+    bigGraph.AddRead(longSeq.c_str(), longSeq.size(), false);
+    EXPECT_EQ(bigGraph.GetNumKmers(), longSeq.size() - graphKmerSize + 1);
+}
+
+// amplitigs walked between anchors
+TEST(amplitiggraph, amplitig)
+{
+    // simulate an amplicon, with reads from both strands and some with substitution errors
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> baseDist(0, 3);
+    std::string amplicon;
+    for (unsigned int i = 0; i < 400; i++)
+        amplicon += artic::char2nt[baseDist(rng)];
+    artic::AmplitigGraph graph(graphKmerSize);
+    for (unsigned int i = 0; i < 10; i++)
+    {
+        std::string read = amplicon;
+        if (i % 3 == 0)
+            for (unsigned int j = 0; j < 8; j++)
+                read[(i * 41 + j * 47) % read.size()] = artic::char2nt[(artic::nt2char[uint8_t(read[(i * 41 + j * 47) % read.size()])] + 1) % 4];
+        if (i % 2)
+            read = reverseComplement(read);
+        graph.AddRead(read.c_str(), read.size(), i % 2);
+    }
+
+    // the heaviest path should skip the errors
+    auto startAnchor = amplicon.substr(0, graphKmerSize);
+    auto endAnchor = amplicon.substr(amplicon.size() - graphKmerSize);
+    std::string amplitig;
+    EXPECT_TRUE(graph.GetAmplitig(startAnchor, endAnchor, 3, amplicon.size() * 1.5, amplitig));
+    EXPECT_EQ(amplitig, amplicon);
+
+    // a path can be cut short by the max. length or the min. k-mer count
+    EXPECT_FALSE(graph.GetAmplitig(startAnchor, endAnchor, 3, amplicon.size() - 1, amplitig));
+    EXPECT_FALSE(graph.GetAmplitig(startAnchor, endAnchor, 11, amplicon.size() * 1.5, amplitig));
+
+    // the end anchor has to be reached
+    EXPECT_FALSE(graph.GetAmplitig(startAnchor, std::string(graphKmerSize, 'A'), 3, amplicon.size() * 1.5, amplitig));
+
+    // a heavier branch that runs into a dead end shouldn't stop the path being found
+    std::string decoy = amplicon.substr(0, 200);
+    for (unsigned int i = 0; i < 100; i++)
+        decoy += artic::char2nt[baseDist(rng)];
+    for (unsigned int i = 0; i < 15; i++)
+        graph.AddRead(decoy.c_str(), decoy.size(), false);
+    EXPECT_TRUE(graph.GetAmplitig(startAnchor, endAnchor, 3, amplicon.size() * 1.5, amplitig));
+    EXPECT_EQ(amplitig, amplicon);
+
+    // anchors must be ACGT k-mers
+    EXPECT_THROW(graph.GetAmplitig("ACGT", endAnchor, 3, 1000, amplitig), std::runtime_error);
+    EXPECT_THROW(graph.GetAmplitig(std::string(graphKmerSize, 'N'), endAnchor, 3, 1000, amplitig), std::runtime_error);
+}
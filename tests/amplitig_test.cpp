@@ -0,0 +1,792 @@
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <chrono>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <artic/amplitig.hpp>
+#include <artic/log.hpp>
+#include <tests/testHelpers.hpp>
+using namespace artic;
+
+// some test parameters
+const std::string amplitigScheme = std::string(TEST_DATA_PATH) + "SCoV2.scheme.v3.bed";
+const std::string amplitigReference = std::string(TEST_DATA_PATH) + "SCoV2.reference.fasta";
+const std::string amplitigReads = std::string(TEST_DATA_PATH) + "amplitig.test.fastq";
+const unsigned int readsPerAmplicon = 4;
+
+// simulateReads writes a FASTQ of reads for every amplicon in a scheme (half reverse complemented), plus some short reads.
+unsigned int simulateReads(const artic::PrimerScheme& ps, const std::string& fileName)
+{
+    artic::RefStore reference(amplitigReference);
+    std::ofstream fh(fileName);
+    unsigned int numReads = 0;
+    for (const auto& read : simulateAmpliconReads(ps, reference, readsPerAmplicon))
+    {
+        fh << "@" << read.name << "\n"
+           << read.seq << "\n+\n"
+           << std::string(read.seq.size(), 'I') << "\n";
+        numReads++;
+    }
+    fh << "@short\nACGTACGT\n+\nIIIIIIII\n";
+    return ++numReads;
+}
+
+// binning simulated reads
+TEST(amplitigger, run)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    auto numReads = simulateReads(ps, amplitigReads);
+
+    // bin with one thread and then with several, the counts should be the same
+    std::vector<uint64_t> counts;
+    for (unsigned int numThreads : {1, 4})
+    {
+        std::ostringstream output;
+        artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, numThreads, output);
+        amplitigger.Run();
+        EXPECT_EQ(amplitigger.GetNumReads(), numReads);
+        EXPECT_EQ(amplitigger.GetNumDroppedShort(), 1);
+        EXPECT_EQ(amplitigger.GetNumUnbinned(), 0);
+
+        // each read should be binned to the amplicon it came from (multibinned reads also get a line for each extra amplicon)
+        std::unordered_map<std::string, std::vector<std::string>> readBins;
+        std::string line;
+        std::istringstream lines(output.str());
+        unsigned int numLines = 0;
+        while (std::getline(lines, line))
+        {
+            auto readName = line.substr(0, line.find('\t'));
+            auto ampliconName = line.substr(line.find('\t') + 1, line.rfind('\t') - line.find('\t') - 1);
+            readBins[readName].emplace_back(ampliconName);
+            numLines++;
+        }
+        EXPECT_EQ(readBins.size(), numReads - 1 - amplitigger.GetNumDroppedLong());
+        // amplicon 17 reads span 18_LEFT and 18_LEFT_alt2, which give more k-mer hits than the amplicon 17 primers
+        unsigned int misbinned = 0;
+        for (const auto& read : readBins)
+            if (std::find(read.second.begin(), read.second.end(), read.first.substr(0, read.first.rfind('_'))) == read.second.end())
+                misbinned++;
+        EXPECT_LE(misbinned, readsPerAmplicon);
+        EXPECT_GE(numLines, readBins.size() + amplitigger.GetNumMultibinned());
+
+        // collect the per-amplicon counts
+        std::vector<uint64_t> threadCounts;
+        for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+            threadCounts.emplace_back(amplitigger.GetAmpliconCount(id));
+        if (counts.empty())
+            counts = threadCounts;
+        EXPECT_EQ(counts, threadCounts);
+        EXPECT_THROW(amplitigger.GetAmpliconCount(0), std::runtime_error);
+
+        // a second run should only count its own reads
+        amplitigger.Run();
+        EXPECT_EQ(amplitigger.GetNumReads(), numReads);
+        EXPECT_EQ(amplitigger.GetNumFiles(), 1);
+        EXPECT_EQ(amplitigger.GetAmpliconCount(1), counts.front());
+    }
+
+    // reads outside the length limits are dropped before binning
+    {
+        std::ostringstream output;
+        artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 1, output);
+        EXPECT_THROW(amplitigger.SetReadLengthLimits(500, 400), std::runtime_error);
+        amplitigger.SetReadLengthLimits(100000, 200000);
+        amplitigger.Run();
+        EXPECT_EQ(amplitigger.GetNumDroppedShort(), numReads);
+    }
+    std::remove(amplitigReads.c_str());
+
+    // catch missing files
+    artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 2);
+    EXPECT_THROW(amplitigger.Run(), std::runtime_error);
+}
+
+// binned reads written to FASTQ files per amplicon and per pool
+TEST(amplitigger, fastqOutput)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    simulateReads(ps, amplitigReads);
+    const std::string prefix = std::string(TEST_DATA_PATH) + "amplitig.test";
+
+    // per amplicon, each file should hold the reads counted for its amplicon
+    artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 4);
+    amplitigger.SetFastqOutput(prefix, artic::BinOutput::amplicon, 2);
+    amplitigger.Run();
+    ASSERT_EQ(amplitigger.GetFastqFiles().size(), ps.GetNumAmplicons());
+    for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+    {
+        auto fileName = amplitigger.GetFastqFiles().at(id - 1);
+        EXPECT_EQ(fileName, prefix + "." + ps.GetAmpliconName(id) + ".fastq.gz");
+        klibpp::KSeq record;
+        klibpp::SeqStreamIn iss(fileName.c_str());
+        uint64_t numRecords = 0;
+        while (iss >> record)
+        {
+            EXPECT_EQ(record.seq.size(), record.qual.size());
+            numRecords++;
+        }
+        EXPECT_EQ(numRecords, amplitigger.GetAmpliconCount(id));
+        std::remove(fileName.c_str());
+    }
+
+    // per pool, each binned read should be written once to the pool of each of its amplicons
+    std::ostringstream output;
+    artic::Amplitigger poolAmplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 4, output);
+    poolAmplitigger.SetFastqOutput(prefix, artic::BinOutput::pool);
+    poolAmplitigger.Run();
+    ASSERT_EQ(poolAmplitigger.GetFastqFiles().size(), ps.GetPrimerPools().size());
+    std::unordered_map<std::string, unsigned int> written;
+    std::string line;
+    std::istringstream lines(output.str());
+    std::unordered_map<std::string, bool> expected;
+    while (std::getline(lines, line))
+    {
+        auto readName = line.substr(0, line.find('\t'));
+        auto ampliconName = line.substr(line.find('\t') + 1, line.rfind('\t') - line.find('\t') - 1);
+        for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+            if (ps.GetAmpliconName(id) == ampliconName)
+                expected[readName + "\t" + ps.GetPrimerPool(ps.GetAmplicon(id).GetPrimerPoolID())] = true;
+    }
+    for (const auto& fileName : poolAmplitigger.GetFastqFiles())
+    {
+        auto poolName = fileName.substr(prefix.size() + 1, fileName.size() - prefix.size() - 10);
+        klibpp::KSeq record;
+        klibpp::SeqStreamIn iss(fileName.c_str());
+        while (iss >> record)
+            written[record.name + "\t" + poolName]++;
+        std::remove(fileName.c_str());
+    }
+    EXPECT_EQ(written.size(), expected.size());
+    for (const auto& read : written)
+    {
+        EXPECT_EQ(read.second, 1) << read.first;
+        EXPECT_TRUE(expected.count(read.first)) << read.first;
+    }
+    std::remove(amplitigReads.c_str());
+
+    // catch unwritable outputs
+    amplitigger.SetFastqOutput(std::string(TEST_DATA_PATH) + "missing/amplitig.test", artic::BinOutput::amplicon);
+    EXPECT_THROW(amplitigger.Run(), std::runtime_error);
+}
+
+// primer search at the read ends, with a full scan fallback for reads with adapters
+TEST(amplitigger, endWindow)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    auto numReads = simulateReads(ps, amplitigReads);
+
+    // the primers are at the ends of the simulated reads, so the windows should find them all
+    // (reads from the longest amplicons are dropped before binning as they include the primers)
+    std::ostringstream output;
+    artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 2, output);
+    EXPECT_THROW(amplitigger.SetEndWindow(ps.GetMinPrimerLen() - 1), std::runtime_error);
+    amplitigger.SetEndWindow(60);
+    amplitigger.Run();
+    EXPECT_EQ(amplitigger.GetNumReads(), numReads);
+    EXPECT_EQ(amplitigger.GetNumUnbinned(), 0);
+    EXPECT_EQ(amplitigger.GetNumFullScans(), 0);
+    uint64_t numBinned = 0;
+    for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+    {
+        auto count = amplitigger.GetAmpliconCount(id);
+        EXPECT_TRUE(count == 0 || count == readsPerAmplicon) << ps.GetAmpliconName(id);
+        numBinned += count;
+    }
+    EXPECT_EQ(numBinned, numReads - 1 - amplitigger.GetNumDroppedLong());
+
+    // reads with adapters covering the windows should fall back to a full scan
+    const std::string adapterReads = std::string(TEST_DATA_PATH) + "amplitig.adapters.test.fastq";
+    artic::RefStore reference(amplitigReference);
+    // (the middle of the amplicon is cut out to keep the read under the length limit)
+    const unsigned int ampliconID = 1;
+    const auto& amplicon = ps.GetAmplicon(ampliconID);
+    std::string seq;
+    reference.GetSeq(ps.GetReferenceName(), amplicon.GetForwardPrimer()->GetStart(), amplicon.GetReversePrimer()->GetEnd(), seq);
+    std::string adapter(ps.GetMinPrimerLen(), 'T');
+    std::ofstream fh(adapterReads);
+    fh << ">adapters_0\n"
+       << adapter << seq.substr(0, 150) << seq.substr(seq.size() - 150) << adapter << "\n";
+    fh.close();
+    artic::Amplitigger adapterAmplitigger(&ps, amplitigReference, {adapterReads}, 11, 0.4, 1, output);
+    adapterAmplitigger.SetEndWindow(ps.GetMinPrimerLen());
+    adapterAmplitigger.Run();
+    EXPECT_EQ(adapterAmplitigger.GetNumFullScans(), 1);
+    EXPECT_EQ(adapterAmplitigger.GetAmpliconCount(ampliconID), 1);
+    std::remove(adapterReads.c_str());
+    std::remove(amplitigReads.c_str());
+}
+
+// binning reads with spaced seeds
+TEST(amplitigger, spacedSeeds)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    auto numReads = simulateReads(ps, amplitigReads);
+
+    // patterns must be valid and fit within the primers
+    std::ostringstream output;
+    artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 2, output);
+    EXPECT_THROW(amplitigger.SetSpacedSeeds({}), std::runtime_error);
+    EXPECT_THROW(amplitigger.SetSpacedSeeds({"0110111010111011"}), std::runtime_error);
+    EXPECT_THROW(amplitigger.SetSpacedSeeds({std::string(ps.GetMinPrimerLen() + 1, '1')}), std::runtime_error);
+
+    // bin using two seeds, the reads should go to the amplicons they came from
+    // (amplicon 13 reads span 14_LEFT and 14_LEFT_alt4, which outvote the amplicon 13 primers but not by enough to bin to 14)
+    amplitigger.SetSpacedSeeds({"110111010111011", "11011001110011011"});
+    amplitigger.Run();
+    EXPECT_EQ(amplitigger.GetNumReads(), numReads);
+    EXPECT_LE(amplitigger.GetNumUnbinned(), readsPerAmplicon);
+    for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+    {
+        auto count = amplitigger.GetAmpliconCount(id);
+        EXPECT_TRUE(count == 0 || count >= readsPerAmplicon) << ps.GetAmpliconName(id);
+    }
+    std::remove(amplitigReads.c_str());
+}
+
+// trimming the primers from binned FASTQ reads
+TEST(amplitigger, primerTrimming)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    simulateReads(ps, amplitigReads);
+    const std::string prefix = std::string(TEST_DATA_PATH) + "amplitig.trim.test";
+
+    // the reads have no errors, so the trimmed reads should be the amplicon inserts
+    artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 2);
+    amplitigger.SetFastqOutput(prefix, artic::BinOutput::amplicon);
+    amplitigger.SetPrimerTrimming(true);
+    amplitigger.Run();
+    artic::RefStore reference(amplitigReference);
+    std::unordered_map<std::string, std::string> inserts;
+    std::string seq;
+    for (const auto& amplicon : ps.GetExpAmplicons())
+    {
+        reference.GetSeq(ps.GetReferenceName(), amplicon.GetForwardPrimer()->GetEnd(), amplicon.GetReversePrimer()->GetStart(), seq);
+        inserts[amplicon.GetName()] = seq;
+    }
+    uint64_t numRecords = 0;
+    uint64_t numInserts = 0;
+    for (const auto& fileName : amplitigger.GetFastqFiles())
+    {
+        klibpp::KSeq record;
+        klibpp::SeqStreamIn iss(fileName.c_str());
+        while (iss >> record)
+        {
+            EXPECT_EQ(record.seq.size(), record.qual.size());
+            std::string insert = inserts.at(record.name.substr(0, record.name.rfind('_')));
+            if (record.name.back() % 2)
+                insert = reverseComplement(insert);
+            numInserts += (record.seq == insert);
+            numRecords++;
+        }
+        std::remove(fileName.c_str());
+    }
+
+    // amplicon 17 reads are binned to 18 (see the run test), so they are trimmed to its primer hits instead
+    EXPECT_GT(numRecords, 0);
+    EXPECT_LE(numRecords - numInserts, readsPerAmplicon);
+    EXPECT_GT(amplitigger.GetNumTrimmedBases(), 0);
+    std::remove(amplitigReads.c_str());
+
+    // adapters beyond the primers should be trimmed too
+    const std::string adapterReads = std::string(TEST_DATA_PATH) + "amplitig.adapters.test.fastq";
+    const std::string adapter = "AATGTACTTCGTTCAGTTACGTATTGCT";
+    const auto& amplicon = ps.GetAmplicon(1);
+    reference.GetSeq(ps.GetReferenceName(), amplicon.GetForwardPrimer()->GetStart(), amplicon.GetReversePrimer()->GetEnd(), seq);
+    std::ofstream fh(adapterReads);
+    fh << ">adapters_0\n"
+       << adapter << seq.substr(0, 150) << seq.substr(seq.size() - 150) << adapter << "\n";
+    fh.close();
+    artic::Amplitigger adapterAmplitigger(&ps, amplitigReference, {adapterReads}, 11, 0.4, 1);
+    adapterAmplitigger.SetFastqOutput(prefix, artic::BinOutput::pool);
+    adapterAmplitigger.SetPrimerTrimming(true);
+    adapterAmplitigger.Run();
+    const auto& insert = inserts.at(amplicon.GetName());
+    std::string expected = insert.substr(0, 150 - amplicon.GetForwardPrimer()->GetLen()) + insert.substr(insert.size() - (150 - amplicon.GetReversePrimer()->GetLen()));
+    unsigned int numAdapterReads = 0;
+    for (const auto& fileName : adapterAmplitigger.GetFastqFiles())
+    {
+        klibpp::KSeq record;
+        klibpp::SeqStreamIn iss(fileName.c_str());
+        while (iss >> record)
+        {
+            EXPECT_EQ(record.seq, expected);
+            numAdapterReads++;
+        }
+        std::remove(fileName.c_str());
+    }
+    EXPECT_EQ(numAdapterReads, 1);
+    EXPECT_EQ(adapterAmplitigger.GetNumTrimmedBases(), adapter.size() * 2 + amplicon.GetForwardPrimer()->GetLen() + amplicon.GetReversePrimer()->GetLen());
+    std::remove(adapterReads.c_str());
+}
+
+// capping the FASTQ depth per amplicon strand
+TEST(amplitigger, depthCap)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    simulateReads(ps, amplitigReads);
+    const std::string prefix = std::string(TEST_DATA_PATH) + "amplitig.cap.test";
+
+    // half the simulated reads are reverse complemented (odd numbered), so a cap of 1 should keep one read per strand
+    std::vector<std::string> sampled;
+    for (auto run : std::vector<std::pair<artic::DepthCapMode, unsigned int>>{{artic::DepthCapMode::firstN, 1}, {artic::DepthCapMode::reservoir, 1}, {artic::DepthCapMode::reservoir, 4}})
+    {
+        auto mode = run.first;
+        artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, run.second);
+        amplitigger.SetFastqOutput(prefix, artic::BinOutput::amplicon);
+        amplitigger.SetDepthCap(1, mode, 42);
+        amplitigger.Run();
+        uint64_t numBinned = 0;
+        uint64_t numWritten = 0;
+        std::string readNames;
+        for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+        {
+            numBinned += amplitigger.GetAmpliconCount(id);
+            klibpp::KSeq record;
+            klibpp::SeqStreamIn iss(amplitigger.GetFastqFiles().at(id - 1).c_str());
+            unsigned int strands[2] = {0, 0};
+            while (iss >> record)
+            {
+                strands[record.name.back() % 2]++;
+                readNames.append(record.name).append("\n");
+                numWritten++;
+            }
+            EXPECT_LE(strands[0], 1) << ps.GetAmpliconName(id);
+            EXPECT_LE(strands[1], 1) << ps.GetAmpliconName(id);
+            if (amplitigger.GetAmpliconCount(id) == readsPerAmplicon)
+            {
+                EXPECT_EQ(strands[0] + strands[1], 2) << ps.GetAmpliconName(id);
+            }
+            std::remove(amplitigger.GetFastqFiles().at(id - 1).c_str());
+        }
+        EXPECT_EQ(amplitigger.GetNumCapped(), numBinned - numWritten);
+
+        // reservoir sampling should pick the same reads regardless of the number of threads
+        sampled.emplace_back(readNames);
+    }
+    EXPECT_EQ(sampled[1], sampled[2]);
+    EXPECT_FALSE(sampled[1].empty());
+    std::remove(amplitigReads.c_str());
+}
+
+// amplitigs and a draft genome built from simulated reads
+TEST(amplitigger, consensus)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    simulateReads(ps, amplitigReads);
+    const std::string prefix = std::string(TEST_DATA_PATH) + "amplitig.consensus.test";
+    const unsigned int k = 15;
+    artic::RefStore reference(amplitigReference);
+    std::string refSeq;
+    for (unsigned int numThreads : {1, 4})
+    {
+        artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, numThreads);
+        EXPECT_THROW(amplitigger.SetConsensusOutput("", k, 2), std::runtime_error);
+        EXPECT_THROW(amplitigger.SetConsensusOutput(prefix, ps.GetMinPrimerLen() + 1, 2), std::runtime_error);
+        EXPECT_THROW(amplitigger.SetConsensusOutput(prefix, k, 0), std::runtime_error);
+        EXPECT_THROW(amplitigger.GetAmplitig(1), std::runtime_error);
+        amplitigger.SetConsensusOutput(prefix, k, 2);
+        amplitigger.Run();
+
+        // the reads are error free, so each amplitig should match the reference between its anchors (amplicons with reads too long or misbinned won't have one)
+        unsigned int numAmplitigs = 0;
+        for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+        {
+            const auto& amplitig = amplitigger.GetAmplitig(id);
+            if (amplitig.empty())
+                continue;
+            const auto& amplicon = ps.GetAmplicon(id);
+            reference.GetSeq(ps.GetReferenceName(), amplicon.GetForwardPrimer()->GetEnd() - k, amplicon.GetReversePrimer()->GetStart() + k, refSeq);
+            EXPECT_EQ(amplitig, refSeq) << ps.GetAmpliconName(id);
+            numAmplitigs++;
+        }
+        EXPECT_GE(numAmplitigs, ps.GetNumAmplicons() - 10);
+
+        // the draft genome should have the reference length, with Ns in the gaps
+        const auto& draft = amplitigger.GetDraftGenome();
+        auto draftStart = ps.GetAmplicon(1).GetForwardPrimer()->GetEnd() - k;
+        reference.GetSeq(ps.GetReferenceName(), draftStart, ps.GetAmplicon(ps.GetNumAmplicons()).GetReversePrimer()->GetStart() + k, refSeq);
+        ASSERT_EQ(draft.size(), refSeq.size());
+        unsigned int mismatches = 0;
+        for (std::size_t i = 0; i < draft.size(); i++)
+            if (draft[i] != 'N' && draft[i] != refSeq[i])
+                mismatches++;
+        EXPECT_EQ(mismatches, 0);
+        EXPECT_LT(std::count(draft.begin(), draft.end(), 'N'), draft.size() / 5);
+
+        // check the FASTA files
+        klibpp::KSeq record;
+        klibpp::SeqStreamIn amplitigs((prefix + ".amplitigs.fasta").c_str());
+        unsigned int numRecords = 0;
+        while (amplitigs >> record)
+            numRecords++;
+        EXPECT_EQ(numRecords, numAmplitigs);
+        klibpp::SeqStreamIn drafts((prefix + ".draft.fasta").c_str());
+        ASSERT_TRUE(drafts >> record);
+        EXPECT_EQ(record.name, "amplitig.consensus.test");
+        EXPECT_EQ(record.seq, draft);
+        std::remove((prefix + ".amplitigs.fasta").c_str());
+        std::remove((prefix + ".draft.fasta").c_str());
+    }
+    std::remove(amplitigReads.c_str());
+}
+
+// reads holding more than one amplicon split into sub-reads
+TEST(amplitigger, chimeraSplitting)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    artic::RefStore reference(amplitigReference);
+
+    // normal reads shouldn't be split
+    auto numReads = simulateReads(ps, amplitigReads);
+    std::vector<uint64_t> counts[2];
+    for (bool split : {false, true})
+    {
+        std::ostringstream output;
+        artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 2, output);
+        amplitigger.SetChimeraSplitting(split);
+        amplitigger.Run();
+        EXPECT_EQ(amplitigger.GetNumReads(), numReads);
+        EXPECT_EQ(amplitigger.GetNumSplit(), 0);
+        for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+            counts[split].emplace_back(amplitigger.GetAmpliconCount(id));
+    }
+    EXPECT_EQ(counts[0], counts[1]);
+
+    // simulate concatemers of neighbouring and overlapping amplicons, with some parts reverse complemented
+    std::vector<std::vector<unsigned int>> concatemers = {{2, 4}, {5, 6}, {20, 22}, {30, 31}, {40, 41}, {50, 52}, {70, 71}, {80, 82}, {24, 26, 28}};
+    std::ofstream fh(amplitigReads);
+    std::string seq;
+    unsigned int numSubReads = 0;
+    for (std::size_t i = 0; i < concatemers.size(); i++)
+    {
+        std::string read;
+        for (std::size_t j = 0; j < concatemers[i].size(); j++)
+        {
+            const auto& amplicon = ps.GetAmplicon(concatemers[i][j]);
+            reference.GetSeq(ps.GetReferenceName(), amplicon.GetForwardPrimer()->GetStart(), amplicon.GetReversePrimer()->GetEnd(), seq);
+            read.append(((i + j) % 3 == 2) ? reverseComplement(seq) : seq);
+            numSubReads++;
+        }
+        fh << "@concatemer" << i << "\n"
+           << read << "\n+\n"
+           << std::string(read.size(), 'I') << "\n";
+    }
+    fh.close();
+
+    // without splitting they are dropped as too long
+    {
+        artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 1);
+        amplitigger.Run();
+        EXPECT_EQ(amplitigger.GetNumDroppedLong(), concatemers.size());
+    }
+
+    // each sub-read should be binned to the amplicon it came from, and written to that amplicon's FASTQ
+    const std::string prefix = std::string(TEST_DATA_PATH) + "amplitig.split.test";
+    for (unsigned int endWindow : {0, 60})
+    {
+        std::ostringstream output;
+        artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 2, output);
+        amplitigger.SetChimeraSplitting(true);
+        amplitigger.SetEndWindow(endWindow);
+        amplitigger.SetFastqOutput(prefix, artic::BinOutput::amplicon);
+        amplitigger.SetPrimerTrimming(true);
+        amplitigger.Run();
+        EXPECT_EQ(amplitigger.GetNumDroppedLong(), 0);
+        EXPECT_EQ(amplitigger.GetNumSplit(), concatemers.size());
+        EXPECT_EQ(amplitigger.GetNumSubReads(), numSubReads);
+        std::unordered_map<std::string, std::string> subReads;
+        std::string line;
+        std::istringstream lines(output.str());
+        while (std::getline(lines, line))
+            subReads[line.substr(0, line.find('\t'))] = line.substr(line.find('\t') + 1, line.rfind('\t') - line.find('\t') - 1);
+        EXPECT_EQ(subReads.size(), numSubReads);
+        for (std::size_t i = 0; i < concatemers.size(); i++)
+            for (std::size_t j = 0; j < concatemers[i].size(); j++)
+                EXPECT_EQ(subReads["concatemer" + std::to_string(i) + "_" + std::to_string(j + 1)], ps.GetAmpliconName(concatemers[i][j]));
+
+        // the sub-reads are trimmed to their amplicon inserts
+        unsigned int numRecords = 0;
+        for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+        {
+            klibpp::KSeq record;
+            klibpp::SeqStreamIn iss(amplitigger.GetFastqFiles().at(id - 1).c_str());
+            const auto& amplicon = ps.GetAmplicon(id);
+            while (iss >> record)
+            {
+                EXPECT_EQ(subReads[record.name], ps.GetAmpliconName(id));
+                EXPECT_LE(record.seq.size(), amplicon.GetReversePrimer()->GetStart() - amplicon.GetForwardPrimer()->GetEnd() + 2) << record.name;
+                numRecords++;
+            }
+            std::remove(amplitigger.GetFastqFiles().at(id - 1).c_str());
+        }
+        EXPECT_EQ(numRecords, numSubReads);
+    }
+    std::remove(amplitigReads.c_str());
+}
+
+// reads binned from FASTQ files as they are written to a directory
+TEST(amplitigger, watch)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    const std::string watchDir = std::string(TEST_DATA_PATH) + "amplitig.watch.test";
+    const std::string snapshotFile = std::string(TEST_DATA_PATH) + "amplitig.watch.test.json";
+    boost::filesystem::remove_all(watchDir);
+    boost::filesystem::create_directory(watchDir);
+    auto numReads = simulateReads(ps, amplitigReads);
+    artic::Amplitigger runner(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 2);
+    runner.Run();
+    {
+        artic::Amplitigger amplitigger(&ps, amplitigReference, {}, 11, 0.4, 2);
+        EXPECT_THROW(amplitigger.Run(), std::runtime_error);
+        EXPECT_THROW(amplitigger.Watch(watchDir + "/missing", snapshotFile, 0, 1), std::runtime_error);
+        EXPECT_THROW(amplitigger.Watch(watchDir, snapshotFile, 0, 0), std::runtime_error);
+    }
+
+    // one file is in the directory before watching starts and another is written during the run, each should only be read once
+    boost::filesystem::copy_file(amplitigReads, watchDir + "/chunk_0.fastq");
+    artic::Amplitigger amplitigger(&ps, amplitigReference, {}, 11, 0.4, 2);
+    std::thread writer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        boost::filesystem::copy_file(amplitigReads, watchDir + "/chunk_1.fastq.tmp");
+        boost::filesystem::rename(watchDir + "/chunk_1.fastq.tmp", watchDir + "/chunk_1.fastq");
+    });
+    amplitigger.Watch(watchDir, snapshotFile, 0, 2, 1);
+    writer.join();
+    EXPECT_EQ(amplitigger.GetNumFiles(), 2);
+    EXPECT_EQ(amplitigger.GetNumReads(), numReads * 2);
+    for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+    {
+        EXPECT_EQ(amplitigger.GetAmpliconCount(id), runner.GetAmpliconCount(id) * 2);
+        EXPECT_DOUBLE_EQ(amplitigger.GetAmpliconDepth(id), runner.GetAmpliconDepth(id) * 2);
+    }
+    EXPECT_DOUBLE_EQ(runner.GetAmpliconDepth(1), readsPerAmplicon);
+
+    // check the final snapshot
+    boost::property_tree::ptree snapshot;
+    boost::property_tree::read_json(snapshotFile, snapshot);
+    EXPECT_TRUE(snapshot.get<bool>("finished"));
+    EXPECT_EQ(snapshot.get<unsigned int>("files"), 2);
+    EXPECT_EQ(snapshot.get<uint64_t>("reads.total"), numReads * 2);
+    EXPECT_FALSE(snapshot.get<bool>("allAtTarget"));
+    const auto& amplicons = snapshot.get_child("amplicons");
+    ASSERT_EQ(amplicons.size(), ps.GetNumAmplicons());
+    EXPECT_EQ(amplicons.front().second.get<std::string>("name"), ps.GetAmpliconName(1));
+    EXPECT_EQ(amplicons.front().second.get<uint64_t>("reads"), runner.GetAmpliconCount(1) * 2);
+    boost::filesystem::remove_all(watchDir);
+    std::remove(snapshotFile.c_str());
+    std::remove(amplitigReads.c_str());
+}
+
+// watching stops once every amplicon has reached the target depth
+TEST(amplitigger, watchTarget)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+
+    // use the first 3 amplicons of the scheme
+    const std::string schemeFile = std::string(TEST_DATA_PATH) + "amplitig.watch.test.bed";
+    std::ifstream schemeIn(amplitigScheme);
+    std::ofstream schemeOut(schemeFile);
+    std::string line;
+    for (unsigned int i = 0; i < 6 && std::getline(schemeIn, line); i++)
+        schemeOut << line << "\n";
+    schemeOut.close();
+    auto ps = artic::PrimerScheme(schemeFile);
+    ASSERT_EQ(ps.GetNumAmplicons(), 3);
+    const std::string watchDir = std::string(TEST_DATA_PATH) + "amplitig.watch.test";
+    const std::string snapshotFile = std::string(TEST_DATA_PATH) + "amplitig.watch.test.json";
+    boost::filesystem::remove_all(watchDir);
+    boost::filesystem::create_directory(watchDir);
+
+    // the read length limit comes from the longest amplicon insert, so the reads need a deletion to all be under it
+    artic::RefStore reference(amplitigReference);
+    std::ofstream fh(watchDir + "/chunk_0.fastq");
+    std::string seq;
+    for (const auto& amplicon : ps.GetExpAmplicons())
+    {
+        reference.GetSeq(ps.GetReferenceName(), amplicon.GetForwardPrimer()->GetStart(), amplicon.GetReversePrimer()->GetEnd(), seq);
+        seq.erase(seq.size() / 2, 60);
+        for (unsigned int i = 0; i < readsPerAmplicon; i++)
+            fh << "@" << amplicon.GetName() << "_" << i << "\n"
+               << seq << "\n+\n"
+               << std::string(seq.size(), 'I') << "\n";
+    }
+    fh.close();
+
+    // the idle timeout is long enough that the test would fail if it was used
+    artic::Amplitigger amplitigger(&ps, amplitigReference, {}, 11, 0.4, 2);
+    auto start = std::chrono::steady_clock::now();
+    amplitigger.Watch(watchDir, snapshotFile, readsPerAmplicon, 60, 1);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(30));
+    boost::property_tree::ptree snapshot;
+    boost::property_tree::read_json(snapshotFile, snapshot);
+    EXPECT_TRUE(snapshot.get<bool>("allAtTarget"));
+    EXPECT_EQ(snapshot.get<unsigned int>("ampliconsAtTarget"), 3);
+    for (const auto& amplicon : snapshot.get_child("amplicons"))
+        EXPECT_TRUE(amplicon.second.get<bool>("atTarget"));
+    boost::filesystem::remove_all(watchDir);
+    std::remove(snapshotFile.c_str());
+    std::remove(schemeFile.c_str());
+}
+
+// reads without primers binned by the amplicon insert minimizers
+TEST(amplitigger, minimizerFallback)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    artic::RefStore reference(amplitigReference);
+
+    // simulate fragments of each amplicon that hold no primers (neighbouring primers sit in the amplicon overlaps), with ~5% substitutions and half reverse complemented
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> errorDist(0, 19);
+    std::uniform_int_distribution<int> baseDist(1, 3);
+    std::ofstream fh(amplitigReads);
+    std::string seq;
+    unsigned int numReads = 0;
+    for (unsigned int id = 1; id <= ps.GetNumAmplicons(); id++)
+    {
+        const auto& amplicon = ps.GetAmplicon(id);
+        auto start = amplicon.GetForwardPrimer()->GetEnd();
+        auto end = amplicon.GetReversePrimer()->GetStart();
+        if (id > 1)
+            start = std::max(start, ps.GetAmplicon(id - 1).GetReversePrimer()->GetEnd());
+        if (id < ps.GetNumAmplicons())
+            end = std::min(end, ps.GetAmplicon(id + 1).GetForwardPrimer()->GetStart());
+        if (end - start < 100)
+            continue;
+        reference.GetSeq(ps.GetReferenceName(), start, end, seq);
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            std::string read = seq;
+            for (auto& base : read)
+                if (errorDist(rng) == 0)
+                    base = artic::char2nt[(artic::nt2char[uint8_t(base)] + baseDist(rng)) % 4];
+            if (i % 2)
+                read = reverseComplement(read);
+            fh << "@" << amplicon.GetName() << "_" << i << "\n"
+               << read << "\n+\n"
+               << std::string(read.size(), 'I') << "\n";
+            numReads++;
+        }
+    }
+    fh.close();
+
+    // without the fallback the reads aren't binned
+    {
+        std::ostringstream output;
+        artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 2, output);
+        amplitigger.Run();
+        EXPECT_EQ(amplitigger.GetNumReads(), numReads);
+        EXPECT_EQ(amplitigger.GetNumUnbinned(), numReads);
+        EXPECT_EQ(amplitigger.GetNumRescued(), 0);
+    }
+
+    // with the fallback nearly all of them should be binned, to the amplicon they came from
+    std::ostringstream output;
+    artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 2, output);
+    EXPECT_THROW(amplitigger.SetMinimizerFallback(15, 10, 0), std::runtime_error);
+    EXPECT_THROW(amplitigger.SetMinimizerFallback(15, 0, 0.1), std::runtime_error);
+    amplitigger.SetMinimizerFallback();
+    amplitigger.Run();
+    EXPECT_GE(amplitigger.GetNumRescued(), numReads * 0.95);
+    EXPECT_LE(amplitigger.GetNumUnbinned(), numReads * 0.05);
+    EXPECT_LE(amplitigger.GetNumMultibinned(), numReads * 0.05);
+    std::string line;
+    std::istringstream lines(output.str());
+    unsigned int misbinned = 0;
+    while (std::getline(lines, line))
+    {
+        auto readName = line.substr(0, line.find('\t'));
+        auto ampliconName = line.substr(line.find('\t') + 1, line.rfind('\t') - line.find('\t') - 1);
+        if (readName.substr(0, readName.rfind('_')) != ampliconName)
+            misbinned++;
+    }
+    EXPECT_LE(misbinned, numReads * 0.05);
+    std::remove(amplitigReads.c_str());
+}
+
+// abundance report in place of the read assignments
+TEST(amplitigger, abundance)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("get_amplitigs");
+    auto ps = artic::PrimerScheme(amplitigScheme);
+    simulateReads(ps, amplitigReads);
+    std::ostringstream output;
+    artic::Amplitigger amplitigger(&ps, amplitigReference, {amplitigReads}, 11, 0.4, 4, output);
+    amplitigger.SetAbundanceReport(true);
+    amplitigger.Run();
+    std::remove(amplitigReads.c_str());
+
+    // there should be a line for each amplicon and each pool, with counts matching the amplitigger
+    std::string line;
+    std::istringstream lines(output.str());
+    unsigned int numAmplicons = 0;
+    unsigned int numPools = 0;
+    uint64_t ampliconTotal = 0;
+    uint64_t poolTotal = 0;
+    std::unordered_map<std::string, unsigned int> dropouts;
+    while (std::getline(lines, line))
+    {
+        if (line[0] == '#')
+            continue;
+        std::vector<std::string> fields;
+        std::istringstream fieldStream(line);
+        std::string field;
+        while (std::getline(fieldStream, field, '\t'))
+            fields.emplace_back(field);
+        if (fields[0] == "amplicon")
+        {
+            ASSERT_EQ(fields.size(), 5);
+            numAmplicons++;
+            EXPECT_EQ(fields[1], ps.GetAmpliconName(numAmplicons));
+            EXPECT_EQ(fields[2], ps.GetPrimerPool(ps.GetAmplicon(numAmplicons).GetPrimerPoolID()));
+            EXPECT_EQ(std::stoull(fields[3]), amplitigger.GetAmpliconCount(numAmplicons));
+            ampliconTotal += std::stoull(fields[3]);
+            if (fields[3] == "0")
+                dropouts[fields[2]]++;
+        }
+        else
+        {
+            ASSERT_EQ(fields[0], "pool");
+            ASSERT_EQ(fields.size(), 4);
+            numPools++;
+            EXPECT_EQ(fields[1], ps.GetPrimerPool(numPools));
+            EXPECT_EQ(std::stoull(fields[2]), amplitigger.GetPoolCount(numPools));
+            EXPECT_EQ(std::stoul(fields[3]), dropouts[fields[1]]);
+            poolTotal += std::stoull(fields[2]);
+        }
+    }
+    EXPECT_EQ(numAmplicons, ps.GetNumAmplicons());
+    EXPECT_EQ(numPools, ps.GetPrimerPools().size());
+    EXPECT_EQ(ampliconTotal, poolTotal);
+    EXPECT_EQ(poolTotal, amplitigger.GetNumReads() - amplitigger.GetNumDroppedShort() - amplitigger.GetNumDroppedLong() - amplitigger.GetNumUnbinned() + amplitigger.GetNumMultibinned());
+    EXPECT_THROW(amplitigger.GetPoolCount(0), std::runtime_error);
+    EXPECT_THROW(amplitigger.GetPoolCount(numPools + 1), std::runtime_error);
+}
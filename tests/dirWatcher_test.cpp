@@ -0,0 +1,56 @@
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include <artic/dirWatcher.hpp>
+using namespace artic;
+
+// some test parameters
+const std::string watchDir = std::string(TEST_DATA_PATH) + "dirWatcher.test";
+
+// writeFile writes a small FASTQ file.
+void writeFile(const std::string& fileName)
+{
+    std::ofstream fh(fileName);
+    fh << "@read\nACGT\n+\nIIII\n";
+}
+
+// files already in a directory and those written to it
+TEST(dirwatcher, newFiles)
+{
+    boost::filesystem::remove_all(watchDir);
+    EXPECT_THROW(artic::DirWatcher{watchDir}, std::runtime_error);
+    boost::filesystem::create_directory(watchDir);
+    writeFile(watchDir + "/a.fastq");
+    writeFile(watchDir + "/notes.txt");
+    artic::DirWatcher watcher(watchDir);
+    EXPECT_EQ(watcher.GetDir(), watchDir);
+
+    // the existing FASTQ files are returned straight away
+    std::vector<std::string> files;
+    watcher.GetNewFiles(100, files);
+    ASSERT_EQ(files.size(), 1);
+    EXPECT_EQ(boost::filesystem::path(files[0]).filename().string(), "a.fastq");
+    watcher.GetNewFiles(100, files);
+    EXPECT_TRUE(files.empty());
+
+    // new files are returned once complete (polling needs a couple of goes to see that a file has stopped growing)
+    writeFile(watchDir + "/b.fq.gz");
+    writeFile(watchDir + "/c.fastq");
+    writeFile(watchDir + "/a.fastq");
+    std::vector<std::string> newFiles;
+    for (unsigned int i = 0; i < 5 && newFiles.size() < 2; i++)
+    {
+        watcher.GetNewFiles(500, files);
+        newFiles.insert(newFiles.end(), files.begin(), files.end());
+    }
+    ASSERT_EQ(newFiles.size(), 2);
+    EXPECT_EQ(boost::filesystem::path(newFiles[0]).filename().string(), "b.fq.gz");
+    EXPECT_EQ(boost::filesystem::path(newFiles[1]).filename().string(), "c.fastq");
+    EXPECT_EQ(watcher.GetNumFiles(), 3);
+    watcher.GetNewFiles(100, files);
+    EXPECT_TRUE(files.empty());
+    boost::filesystem::remove_all(watchDir);
+}
@@ -0,0 +1,131 @@
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include <artic/fastqReader.hpp>
+using namespace artic;
+
+// some test parameters
+const std::string readerPrefix = std::string(TEST_DATA_PATH) + "fastqReader.test";
+const unsigned int readerNumReads = 20000;
+
+// simulateFastq returns random FASTQ records, enough to fill several inflate chunks and BGZF blocks.
+std::string simulateFastq(std::vector<std::string>& seqs)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> baseDist(0, 3);
+    std::uniform_int_distribution<int> lenDist(50, 400);
+    std::string records;
+    for (unsigned int i = 0; i < readerNumReads; i++)
+    {
+        std::string seq;
+        for (int j = lenDist(rng); j > 0; j--)
+            seq += "ACGT"[baseDist(rng)];
+        records += "@read_" + std::to_string(i) + " comment\n" + seq + "\n+\n" + std::string(seq.size(), 'I') + "\n";
+        seqs.emplace_back(seq);
+    }
+    return records;
+}
+
+// readAll reads every record from a file, checking them against the simulated sequences.
+void readAll(const std::string& fileName, hts_tpool* threadPool, bool isBGZF, const std::vector<std::string>& seqs, std::size_t numBytes)
+{
+    artic::FastqReader reader(fileName, threadPool);
+    EXPECT_EQ(reader.GetFileName(), fileName);
+    EXPECT_EQ(reader.IsBGZF(), isBGZF);
+    klibpp::KSeq record;
+    unsigned int numReads = 0;
+    while (reader.Read(record))
+    {
+        ASSERT_LT(numReads, seqs.size());
+        EXPECT_EQ(record.name, "read_" + std::to_string(numReads));
+        EXPECT_EQ(record.comment, "comment");
+        EXPECT_EQ(record.seq, seqs[numReads]);
+        EXPECT_EQ(record.qual.size(), record.seq.size());
+        numReads++;
+    }
+    EXPECT_EQ(numReads, seqs.size());
+    EXPECT_EQ(reader.GetNumBytes(), numBytes);
+    EXPECT_FALSE(reader.Read(record));
+}
+
+// uncompressed, gzip and BGZF input
+TEST(fastqreader, formats)
+{
+    std::vector<std::string> seqs;
+    auto records = simulateFastq(seqs);
+
+    // write the same records three ways
+    {
+        std::ofstream fh(readerPrefix + ".fastq");
+        fh << records;
+    }
+    gzFile gz = gzopen((readerPrefix + ".gz.fastq.gz").c_str(), "wb");
+    ASSERT_NE(gz, nullptr);
+    ASSERT_EQ(gzwrite(gz, records.data(), records.size()), int(records.size()));
+    gzclose(gz);
+    BGZF* bgzf = bgzf_open((readerPrefix + ".bgzf.fastq.gz").c_str(), "w");
+    ASSERT_NE(bgzf, nullptr);
+    ASSERT_EQ(bgzf_write(bgzf, records.data(), records.size()), ssize_t(records.size()));
+    bgzf_close(bgzf);
+
+    // all should give the same records, with or without a thread pool
+    hts_tpool* threadPool = hts_tpool_init(4);
+    ASSERT_NE(threadPool, nullptr);
+    for (auto pool : {threadPool, (hts_tpool*)nullptr})
+    {
+        readAll(readerPrefix + ".fastq", pool, false, seqs, records.size());
+        readAll(readerPrefix + ".gz.fastq.gz", pool, false, seqs, records.size());
+        readAll(readerPrefix + ".bgzf.fastq.gz", pool, true, seqs, records.size());
+    }
+
+    // a reader can be dropped part way through a file
+    {
+        artic::FastqReader reader(readerPrefix + ".gz.fastq.gz", threadPool);
+        klibpp::KSeq record;
+        EXPECT_TRUE(reader.Read(record));
+        EXPECT_EQ(record.seq, seqs[0]);
+    }
+    hts_tpool_destroy(threadPool);
+    for (const auto& suffix : {".fastq", ".gz.fastq.gz", ".bgzf.fastq.gz"})
+        std::remove((readerPrefix + suffix).c_str());
+}
+
+// missing and truncated files
+TEST(fastqreader, errors)
+{
+    EXPECT_THROW(artic::FastqReader(readerPrefix + ".missing.fastq", nullptr), std::runtime_error);
+
+    // cut a gzip file short, which should be an error and not just the end of the reads
+    std::vector<std::string> seqs;
+    auto records = simulateFastq(seqs);
+    std::string compressed(compressBound(records.size()), '\0');
+    uLongf compressedLen = compressed.size();
+    z_stream zs = {};
+    ASSERT_EQ(deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY), Z_OK);
+    zs.next_in = (Bytef*)records.data();
+    zs.avail_in = records.size();
+    zs.next_out = (Bytef*)&compressed[0];
+    zs.avail_out = compressedLen;
+    ASSERT_EQ(deflate(&zs, Z_FINISH), Z_STREAM_END);
+    compressedLen = zs.total_out;
+    deflateEnd(&zs);
+    const std::string truncated = readerPrefix + ".truncated.fastq.gz";
+    {
+        std::ofstream fh(truncated, std::ios::binary);
+        fh.write(compressed.data(), compressedLen / 2);
+    }
+    artic::FastqReader reader(truncated, nullptr);
+    klibpp::KSeq record;
+    EXPECT_THROW(
+        {
+            while (reader.Read(record))
+                ;
+        },
+        std::runtime_error);
+    std::remove(truncated.c_str());
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <artic/kmerTable.hpp>
+using namespace artic;
+
+// some test parameters
+const uint32_t tableKmerSize = 15;
+
+// lookups in a table
+TEST(kmertable, find)
+{
+    artic::KmerTable<artic::Kmer> empty;
+    EXPECT_EQ(empty.Find(0), nullptr);
+    EXPECT_THROW(artic::KmerTable<artic::Kmer>({}, 0), std::runtime_error);
+    EXPECT_THROW(artic::KmerTable<artic::Kmer>({}, artic::MAX_K_SIZE + 1), std::runtime_error);
+
+    // every k-mer should be found (with and without a seed, and with the k-mer size fixed at compile time)
+    std::vector<artic::Kmer> kmers;
+    for (artic::kmer_t kmer = 0; kmer < 1000; kmer++)
+        kmers.push_back({kmer * 7919, uint32_t(kmer), true});
+    for (artic::kmer_t seed : {0ULL, 0x9e3779b97f4a7c15ULL})
+    {
+        artic::KmerTable<artic::Kmer> table(kmers, tableKmerSize, seed);
+        EXPECT_EQ(table.GetEntries().size(), kmers.size());
+        for (const auto& kmer : kmers)
+        {
+            ASSERT_NE(table.Find(kmer.kmer), nullptr);
+            EXPECT_EQ(table.Find(kmer.kmer)->end, kmer.end);
+            EXPECT_EQ(table.Find<tableKmerSize>(kmer.kmer), table.Find(kmer.kmer));
+        }
+        EXPECT_EQ(table.Find(1), nullptr);
+    }
+}
+
+// buckets for k-mers sampled by their hash
+TEST(kmertable, buckets)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> baseDist(0, 3);
+    std::string seq;
+    for (unsigned int i = 0; i < 30000; i++)
+        seq += artic::char2nt[baseDist(rng)];
+    std::vector<artic::Kmer> minimizers;
+    artic::GetMinimizers(seq.c_str(), seq.size(), tableKmerSize, 10, minimizers);
+    std::vector<artic::Kmer> entries;
+    std::unordered_set<artic::kmer_t> seen;
+    for (const auto& minimizer : minimizers)
+        if (seen.insert(minimizer.kmer).second)
+            entries.push_back(minimizer);
+
+    // minimizers all have low hashes, so without a seed they crowd in to the first buckets
+    // (~5.5k entries in 8192 buckets should leave about half of them empty when spread out)
+    artic::KmerTable<artic::Kmer> unseeded(entries, tableKmerSize);
+    artic::KmerTable<artic::Kmer> seeded(entries, tableKmerSize, 0x9e3779b97f4a7c15ULL);
+    EXPECT_GT(unseeded.GetNumEmptyBuckets(), 8192 * 0.65);
+    EXPECT_LT(seeded.GetNumEmptyBuckets(), 8192 * 0.55);
+    for (const auto& entry : entries)
+        EXPECT_NE(seeded.Find(entry.kmer), nullptr);
+}
@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <gtest/gtest.h>
 #include <string>
+#include <vector>
 
 #include <artic/kmers.hpp>
+#include <tests/testHelpers.hpp>
 using namespace artic;
 
 // some test parameters
@@ -109,3 +112,341 @@ TEST(kmers, encoding)
         std::cerr << "kmer int: " << std::to_string(kmer) << " kmer strings: " << decoded << "," << decoded_rc << std::endl;
     }
 }
+
+// the SIMD kernels should give identical encodings to the scalar kernel.
+TEST(kmers, kernels)
+{
+    std::cerr << "k-mer kernel: " << artic::GetKmerKernelName(artic::GetKmerKernel()) << std::endl;
+
+    // make a sequence with mixed case, ambiguous bases and some junk bytes
+    std::string alphabet = "ACGTacgtNnRY-*";
+    std::string seq;
+    uint32_t state = 42;
+    for (int i = 0; i < 1500; i++)
+    {
+        state = state * 1103515245 + 12345;
+        seq += ((state >> 16) % 50 == 0) ? char(state >> 8) : alphabet[(state >> 16) % ((i % 300 < 200) ? 8 : alphabet.size())];
+    }
+
+    // check every supported kernel against the scalar kernel, over all the block and vector edges
+    std::vector<uint8_t> expectedCodes(seq.size()), codes(seq.size());
+    for (int kernel = int(artic::KmerKernel::sse41); kernel <= int(artic::GetKmerKernel()); kernel++)
+    {
+        for (uint32_t len : {0, 1, 15, 16, 17, 31, 32, 33, 255, 256, 257, 600, 1500})
+        {
+            artic::EncodeBases(seq.c_str(), len, expectedCodes.data(), artic::KmerKernel::scalar);
+            artic::EncodeBases(seq.c_str(), len, codes.data(), artic::KmerKernel(kernel));
+            ASSERT_TRUE(std::equal(codes.begin(), codes.begin() + len, expectedCodes.begin()));
+            for (uint32_t k : {1, 5, 11, 17, 31})
+            {
+                artic::kmerset_t expected, kmers;
+                artic::GetEncodedKmers(seq.c_str(), len, k, expected, artic::KmerKernel::scalar);
+                artic::GetEncodedKmers(seq.c_str(), len, k, kmers, artic::KmerKernel(kernel));
+                ASSERT_EQ(kmers, expected);
+            }
+        }
+    }
+
+    // the scalar kernel should match nt2char
+    artic::EncodeBases(seq.c_str(), seq.size(), codes.data(), artic::KmerKernel::scalar);
+    for (std::size_t i = 0; i < seq.size(); i++)
+        ASSERT_EQ(codes[i], artic::nt2char[static_cast<uint8_t>(seq[i])]);
+}
+
+// the k-mer scanner should yield the same k-mers as GetEncodedKmers, with their positions.
+TEST(kmers, scanner)
+{
+    // check the k-mers and positions on a sequence with an N
+    std::string seq = "ACGTAGAAAAGGNACGTTTGCAaccgtA";
+    artic::kmerset_t expected;
+    artic::GetEncodedKmers(seq.c_str(), seq.size(), kSize, expected);
+    artic::kmerset_t kmers;
+    std::string decoded;
+    for (const auto& kmer : artic::KmerScanner(seq.c_str(), seq.size(), kSize))
+    {
+        kmers.emplace_back(kmer.kmer);
+        if (kmer.end <= 12 || kmer.end >= 13 + kSize)
+        {
+            (kmer.forward) ? artic::DecodeKmer(kmer.kmer, kSize, decoded) : artic::DecodeKmer_rc(kmer.kmer, kSize, decoded);
+            for (auto& base : decoded)
+                base = std::tolower(base);
+            std::string window = seq.substr(kmer.end - kSize, kSize);
+            for (auto& base : window)
+                base = std::tolower(base);
+            EXPECT_EQ(decoded, window);
+        }
+    }
+    EXPECT_EQ(kmers, expected);
+
+    // check the scanner over block edges and for each kernel, and that it can be reset and stopped early
+    std::string bigSeq;
+    for (int i = 0; i < 700; i++)
+        bigSeq += "ACGTTGCAAN"[(i * 7 + i / 3) % 10];
+    for (int kernel = int(artic::KmerKernel::scalar); kernel <= int(artic::GetKmerKernel()); kernel++)
+    {
+        expected.clear();
+        artic::GetEncodedKmers(bigSeq.c_str(), bigSeq.size(), 11, expected);
+        artic::KmerScanner scanner(bigSeq.c_str(), bigSeq.size(), 11, artic::KmerKernel(kernel));
+        artic::Kmer kmer;
+        for (int round = 0; round < 2; round++)
+        {
+            kmers.clear();
+            while (scanner.Next(kmer))
+                kmers.emplace_back(kmer.kmer);
+            ASSERT_EQ(kmers, expected);
+            ASSERT_FALSE(scanner.Next(kmer));
+            scanner.Reset();
+        }
+        int count = 0;
+        for (const auto& kmer : scanner)
+        {
+            if (kmer.end > 300)
+                break;
+            count++;
+        }
+        EXPECT_GT(count, 0);
+        EXPECT_LT(count, expected.size());
+    }
+
+    // empty and short sequences yield nothing
+    artic::KmerScanner empty("", 0, kSize);
+    for (const auto& kmer : empty)
+        FAIL() << "unexpected k-mer: " << kmer.kmer;
+    artic::KmerScanner shortSeq("ACG", 3, kSize);
+    for (const auto& kmer : shortSeq)
+        FAIL() << "unexpected k-mer: " << kmer.kmer;
+    EXPECT_THROW(artic::KmerScanner("ACG", 3, artic::MAX_K_SIZE + 1), std::runtime_error);
+}
+
+// spaced seed k-mers should match a brute force extraction of the kept positions, and ignore substitutions at the other positions
+TEST(kmers, spacedSeeds)
+{
+    // check the patterns
+    for (std::string pattern : std::vector<std::string>{"", "0110", "1102", std::string(artic::MAX_K_SIZE + 1, '1')})
+        EXPECT_THROW(artic::SpacedSeed seed(pattern), std::runtime_error) << pattern;
+    artic::SpacedSeed seed("111010010100110111");
+    EXPECT_EQ(seed.GetSpan(), 18);
+    EXPECT_EQ(seed.GetWeight(), 11);
+    EXPECT_FALSE(seed.IsContiguous());
+    EXPECT_TRUE(artic::SpacedSeed(std::string(artic::MAX_K_SIZE, '1')).IsContiguous());
+
+    // encodeKept gets the encoding of the kept bases in a window
+    auto encodeKept = [](const std::string& window, const std::string& pattern) {
+        kmer_t kmer = 0;
+        for (std::size_t i = 0; i < pattern.size(); i++)
+            if (pattern[i] == '1')
+                kmer = (kmer << 2) | artic::nt2char[uint8_t(window[i])];
+        return kmer;
+    };
+    // (N's are dropped by the scanner, so leave them out)
+    std::string seq;
+    for (int i = 0; i < 600; i++)
+        seq += "ACGTTGCAAG"[(i * 7 + i / 3) % 10];
+    for (const auto& pattern : std::vector<std::string>{"111010010100110111", "1101101111011011", "101", std::string(artic::MAX_K_SIZE, '1'), "1" + std::string(artic::MAX_K_SIZE - 2, '0') + "1"})
+    {
+        artic::SpacedSeed spacedSeed(pattern);
+        std::size_t numKmers = 0;
+        for (const auto& kmer : artic::KmerScanner(seq.c_str(), seq.size(), spacedSeed))
+        {
+            std::string window = seq.substr(kmer.end - pattern.size(), pattern.size());
+            auto fwd = encodeKept(window, pattern);
+            auto rc = encodeKept(reverseComplement(window), pattern);
+            ASSERT_EQ(kmer.kmer, std::min(fwd, rc)) << pattern << " " << window;
+            ASSERT_EQ(kmer.forward, fwd <= rc);
+            numKmers++;
+        }
+        EXPECT_GT(numKmers, 0) << pattern;
+    }
+
+    // a contiguous seed should give the same k-mers as a plain scan
+    artic::kmerset_t expected, kmers;
+    artic::GetEncodedKmers(seq.c_str(), seq.size(), 11, expected);
+    artic::SpacedSeed contiguous(std::string(11, '1'));
+    for (const auto& kmer : artic::KmerScanner(seq.c_str(), seq.size(), contiguous))
+        kmers.emplace_back(kmer.kmer);
+    EXPECT_EQ(kmers, expected);
+
+    // for a symmetric seed, a substitution at an ignored position should not change the k-mer on either strand
+    std::string pattern = "1101101111011011";
+    artic::SpacedSeed symmetric(pattern);
+    std::string window = "ACGTTGCAAGTCCATG";
+    for (std::size_t i = 0; i < pattern.size(); i++)
+    {
+        std::string mutated = window;
+        mutated[i] = (mutated[i] == 'A') ? 'C' : 'A';
+        artic::Kmer original, substituted;
+        artic::KmerScanner(window.c_str(), window.size(), symmetric).Next(original);
+        artic::KmerScanner(mutated.c_str(), mutated.size(), symmetric).Next(substituted);
+        EXPECT_EQ(original.kmer == substituted.kmer, pattern[i] == '0') << i;
+    }
+}
+
+// minimizers should match a brute force window search.
+TEST(kmers, minimizers)
+{
+    std::string seq;
+    uint32_t state = 7;
+    for (int i = 0; i < 2000; i++)
+    {
+        state = state * 1103515245 + 12345;
+        seq += "ACGT"[(state >> 16) % 4];
+    }
+    for (uint32_t w : {1, 5, 10})
+    {
+        const uint32_t k = 15;
+        std::vector<artic::Kmer> minimizers;
+        artic::GetMinimizers(seq.c_str(), seq.size(), k, w, minimizers);
+
+        // brute force, keeping the leftmost k-mer for tied hashes
+        std::vector<artic::Kmer> kmers;
+        for (const auto& kmer : artic::KmerScanner(seq.c_str(), seq.size(), k))
+            kmers.emplace_back(kmer);
+        std::vector<artic::Kmer> expected;
+        uint32_t last = UINT32_MAX;
+        for (uint32_t i = 0; i + w <= kmers.size(); i++)
+        {
+            uint32_t best = i;
+            for (uint32_t j = i + 1; j < i + w; j++)
+                if (artic::HashKmer(kmers[j].kmer, k) < artic::HashKmer(kmers[best].kmer, k))
+                    best = j;
+            if (best != last)
+                expected.emplace_back(kmers[best]);
+            last = best;
+        }
+        ASSERT_EQ(minimizers.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); i++)
+        {
+            EXPECT_EQ(minimizers[i].kmer, expected[i].kmer);
+            EXPECT_EQ(minimizers[i].end, expected[i].end);
+        }
+
+        // check the density is roughly 2/(w+1)
+        if (w > 1)
+        {
+            EXPECT_NEAR(double(minimizers.size()) / kmers.size(), 2.0 / (w + 1), 0.05);
+        }
+    }
+    std::vector<artic::Kmer> minimizers;
+    EXPECT_THROW(artic::GetMinimizers(seq.c_str(), seq.size(), 15, 0, minimizers), std::runtime_error);
+}
+
+// syncmers should match a brute force s-mer search.
+TEST(kmers, syncmers)
+{
+    std::string seq;
+    uint32_t state = 11;
+    for (int i = 0; i < 2000; i++)
+    {
+        state = state * 1103515245 + 12345;
+        seq += "ACGTN"[((state >> 16) % 100 == 0) ? 4 : (state >> 16) % 4];
+    }
+    const uint32_t k = 15;
+    const uint32_t s = 5;
+    for (auto type : {artic::SyncmerType::open, artic::SyncmerType::closed})
+    {
+        std::vector<artic::Kmer> syncmers;
+        artic::GetSyncmers(seq.c_str(), seq.size(), k, s, type, syncmers, 2);
+
+        // brute force on the sequence with the Ns removed (as they are skipped by the scanner)
+        std::string cleanSeq;
+        for (auto base : seq)
+            if (base != 'N')
+                cleanSeq += base;
+        std::vector<artic::kmer_t> expected;
+        artic::kmerset_t kmer, smers;
+        for (uint32_t i = 0; i + k <= cleanSeq.size(); i++)
+        {
+            kmer.clear();
+            smers.clear();
+            artic::GetEncodedKmers(cleanSeq.c_str() + i, k, k, kmer);
+            artic::GetEncodedKmers(cleanSeq.c_str() + i, k, s, smers);
+            uint32_t best = 0;
+            for (uint32_t j = 1; j < smers.size(); j++)
+                if (artic::HashKmer(smers[j], s) < artic::HashKmer(smers[best], s))
+                    best = j;
+            if ((type == artic::SyncmerType::closed) ? (best == 0 || best == k - s) : (best == 2))
+                expected.emplace_back(kmer.front());
+        }
+        ASSERT_EQ(syncmers.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); i++)
+            EXPECT_EQ(syncmers[i].kmer, expected[i]);
+
+        // closed syncmer density is roughly 2/(k-s+1), open is 1/(k-s+1)
+        double density = double(syncmers.size()) / (cleanSeq.size() - k + 1);
+        EXPECT_NEAR(density, ((type == artic::SyncmerType::closed) ? 2.0 : 1.0) / (k - s + 1), 0.05);
+    }
+    std::vector<artic::Kmer> syncmers;
+    EXPECT_THROW(artic::GetSyncmers(seq.c_str(), seq.size(), k, k + 1, artic::SyncmerType::closed, syncmers), std::runtime_error);
+    EXPECT_THROW(artic::GetSyncmers(seq.c_str(), seq.size(), k, s, artic::SyncmerType::open, syncmers, k), std::runtime_error);
+}
+
+// templated k-mer sizes and words should match the runtime k-mer size, and support k-mers > 32.
+TEST(kmers, templated)
+{
+    std::string seq;
+    uint32_t state = 3;
+    for (int i = 0; i < 600; i++)
+    {
+        state = state * 1103515245 + 12345;
+        seq += "ACGTacgt"[(state >> 16) % 8];
+    }
+
+    // k=15 in a 32-bit word should give the same k-mers as the runtime k-mer size
+    artic::kmerset_t expected;
+    artic::GetEncodedKmers(seq.c_str(), seq.size(), 15, expected);
+    std::vector<uint32_t> kmers32;
+    artic::GetEncodedKmers<15>(seq.c_str(), seq.size(), kmers32);
+    ASSERT_EQ(kmers32.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); i++)
+        ASSERT_EQ(kmers32[i], expected[i]);
+
+    // k=32 should use the full word
+    expected.clear();
+    artic::GetEncodedKmers(seq.c_str(), seq.size(), 32, expected);
+    std::string decoded;
+    artic::DecodeKmer(expected.front(), 32, decoded);
+    std::string window = seq.substr(0, 32);
+    std::transform(window.begin(), window.end(), window.begin(), ::toupper);
+    std::string windowRC;
+    artic::DecodeKmer_rc(expected.front(), 32, windowRC);
+    ASSERT_TRUE(decoded == window || windowRC == window);
+
+    // k=48 needs a 128-bit word, check each canonical k-mer decodes to the sequence window or its reverse complement
+    std::vector<artic::kmer128_t> kmers128;
+    artic::GetEncodedKmers<48>(seq.c_str(), seq.size(), kmers128);
+    ASSERT_EQ(kmers128.size(), seq.size() - 48 + 1);
+    for (std::size_t i = 0; i < kmers128.size(); i++)
+    {
+        window = seq.substr(i, 48);
+        std::transform(window.begin(), window.end(), window.begin(), ::toupper);
+        artic::DecodeKmer<48>(kmers128[i], decoded);
+        artic::DecodeKmer<48>(artic::GetRCencoding<48>(kmers128[i]), windowRC);
+        ASSERT_TRUE(decoded == window || windowRC == window);
+        ASSERT_LE(kmers128[i], artic::GetRCencoding<48>(kmers128[i]));
+    }
+
+    // the templated scanner and hash should match the runtime ones
+    artic::KmerScanner scanner(seq.c_str(), seq.size(), 15);
+    artic::KmerScanner<15> fixedScanner(seq.c_str(), seq.size(), 15);
+    artic::Kmer kmer, fixedKmer;
+    while (scanner.Next(kmer))
+    {
+        ASSERT_TRUE(fixedScanner.Next(fixedKmer));
+        ASSERT_EQ(fixedKmer.kmer, kmer.kmer);
+        ASSERT_EQ(fixedKmer.end, kmer.end);
+        ASSERT_EQ(fixedKmer.forward, kmer.forward);
+        ASSERT_EQ(artic::HashKmer<15>(kmer.kmer, 15), artic::HashKmer(kmer.kmer, 15));
+    }
+    EXPECT_FALSE(fixedScanner.Next(fixedKmer));
+    EXPECT_THROW(artic::KmerScanner<15>(seq.c_str(), seq.size(), 21), std::runtime_error);
+
+    // dispatching a runtime k-mer size
+    uint32_t dispatched = 0;
+    artic::DispatchKmerSize(48, [&](auto k) { dispatched = decltype(k)::value; });
+    EXPECT_EQ(dispatched, 48);
+    artic::DispatchKmerSize<artic::MAX_K_SIZE>(artic::MAX_K_SIZE, [&](auto k) { dispatched = decltype(k)::value; });
+    EXPECT_EQ(dispatched, artic::MAX_K_SIZE);
+    EXPECT_THROW(artic::DispatchKmerSize(0, [](auto) {}), std::runtime_error);
+    EXPECT_THROW(artic::DispatchKmerSize<artic::MAX_K_SIZE>(artic::MAX_K_SIZE + 1, [](auto) {}), std::runtime_error);
+    EXPECT_THROW(artic::DispatchKmerSize(artic::MAX_LONG_K_SIZE + 1, [](auto) {}), std::runtime_error);
+}
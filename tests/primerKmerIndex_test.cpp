@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <string>
+
+#include <artic/primerKmerIndex.hpp>
+#include <tests/testHelpers.hpp>
+using namespace artic;
+
+// some test parameters
+const std::string indexScheme = std::string(TEST_DATA_PATH) + "SCoV2.scheme.v3.bed";
+const std::string indexReference = std::string(TEST_DATA_PATH) + "SCoV2.reference.fasta";
+
+// index built from a primer k-mer map
+TEST(primerkmerindex, map)
+{
+    // empty index
+    artic::PrimerKmerIndex empty;
+    EXPECT_EQ(empty.GetNumKmers(), 0);
+    EXPECT_EQ(empty.Find(42), artic::NO_AMPLICON);
+
+    // k-mers shared by amplicons are dropped, k-mers repeated in one amplicon are kept
+    artic::kmermap_t kmerMap;
+    kmerMap[1] = {1};
+    kmerMap[2] = {1, 2};
+    kmerMap[3] = {3, 3};
+    kmerMap[4] = {65535};
+    artic::PrimerKmerIndex index(kmerMap, 11);
+    EXPECT_EQ(index.GetNumKmers(), 3);
+    EXPECT_EQ(index.GetNumShared(), 1);
+    EXPECT_EQ(index.Find(1), 1);
+    EXPECT_EQ(index.Find(2), artic::NO_AMPLICON);
+    EXPECT_EQ(index.Find(3), 3);
+    EXPECT_EQ(index.Find(4), 65535);
+    EXPECT_EQ(index.Find(5), artic::NO_AMPLICON);
+
+    // catch bad amplicon IDs and k-mer sizes
+    kmerMap[5] = {0};
+    EXPECT_THROW(artic::PrimerKmerIndex(kmerMap, 11), std::runtime_error);
+    EXPECT_THROW(artic::PrimerKmerIndex(artic::kmermap_t(), artic::MAX_K_SIZE + 1), std::runtime_error);
+}
+
+// index built from a primer scheme should agree with the primer k-mer map
+TEST(primerkmerindex, scheme)
+{
+    auto ps = artic::PrimerScheme(indexScheme);
+    artic::RefStore reference(indexReference);
+    for (uint32_t k : {11, 15, 22})
+    {
+        artic::PrimerKmerIndex index(ps, reference, k);
+        EXPECT_EQ(index.GetKmerSize(), k);
+        artic::kmermap_t kmerMap;
+        ps.GetPrimerKmers(reference, k, kmerMap);
+        EXPECT_EQ(index.GetNumKmers() + index.GetNumShared(), kmerMap.size());
+        EXPECT_LT(index.GetMemoryUsage(), 128 * 1024);
+        for (const auto& kmer : kmerMap)
+        {
+            bool unique = std::all_of(kmer.second.begin(), kmer.second.end(), [&](unsigned int id) { return id == kmer.second.front(); });
+            EXPECT_EQ(index.Find(kmer.first), (unique) ? kmer.second.front() : artic::NO_AMPLICON);
+        }
+
+        // k-mers from the amplicon inserts (away from the primers) should mostly miss
+        std::string insert;
+        reference.GetSeq(ps.GetReferenceName(), 1000, 1200, insert);
+        unsigned int hits = 0;
+        for (const auto& kmer : artic::KmerScanner(insert.c_str(), insert.size(), k))
+            if (index.Find(kmer.kmer) != artic::NO_AMPLICON && kmerMap.find(kmer.kmer) == kmerMap.end())
+                hits++;
+        EXPECT_EQ(hits, 0);
+
+        // hits should tell which strand a primer was read from
+        std::string primerSeq;
+        ps.GetAmplicon(1).GetForwardPrimer()->GetSeq(reference, ps.GetReferenceName(), primerSeq);
+        auto primerRC = reverseComplement(primerSeq);
+        for (bool reverse : {false, true})
+        {
+            const auto& seq = (reverse) ? primerRC : primerSeq;
+            bool forward;
+            for (const auto& kmer : artic::KmerScanner(seq.c_str(), seq.size(), k))
+            {
+                if (index.Find(kmer.kmer, forward) != artic::NO_AMPLICON)
+                {
+                    EXPECT_EQ(kmer.forward == forward, !reverse);
+                }
+            }
+        }
+    }
+}
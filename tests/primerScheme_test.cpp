@@ -1,6 +1,8 @@
+#include <atomic>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <string>
+#include <thread>
 
 #include <artic/log.hpp>
 #include <artic/primerScheme.hpp>
@@ -247,3 +249,192 @@ TEST(primerscheme, kmers)
     }
     */
 }
+
+// builtin schemes
+TEST(primerscheme, builtin)
+{
+    auto builtin = artic::FindBuiltinScheme("scov2/v3");
+    if (!builtin)
+        GTEST_SKIP() << "scov2/v3 was not embedded at build time";
+    EXPECT_EQ(artic::FindBuiltinScheme("not_a_scheme"), nullptr);
+
+    // the builtin scheme should match the one loaded from file
+    auto ps = artic::PrimerScheme(*builtin);
+    auto ps2 = artic::PrimerScheme(inputScheme);
+    EXPECT_EQ(ps.GetReferenceName(), refID);
+    EXPECT_EQ(ps.GetPrimerPools().size(), numPools);
+    EXPECT_EQ(ps.GetNumPrimers(), numPrimers);
+    EXPECT_EQ(ps.GetNumAlts(), numAlts);
+    EXPECT_EQ(ps.GetNumAmplicons(), numAmplicons);
+    EXPECT_EQ(ps.GetNumOverlaps(), ps2.GetNumOverlaps());
+    for (unsigned int id = 1; id <= numAmplicons; id++)
+    {
+        auto amplicon = ps.GetAmplicon(id);
+        auto amplicon2 = ps2.GetAmplicon(id);
+        EXPECT_EQ(amplicon.GetName(), amplicon2.GetName());
+        EXPECT_EQ(amplicon.GetMaxSpan(), amplicon2.GetMaxSpan());
+    }
+
+    // check it can be selected by name during validation
+    artic::SchemeArgs schemeArgs;
+    schemeArgs.schemeVersion = 0;
+    schemeArgs.builtinScheme = "scov2/v3";
+    artic::Log::Init("validate_builtin");
+    auto ps3 = artic::ValidateScheme(schemeArgs);
+    EXPECT_EQ(ps3.GetNumAmplicons(), numAmplicons);
+}
+
+// position annotation track
+TEST(primerscheme, positionTrack)
+{
+    auto ps = artic::PrimerScheme(inputScheme);
+
+    // positions outside the scheme get an empty annotation
+    auto outside = ps.GetPosition(0);
+    EXPECT_EQ(outside.ampliconID, 0);
+    EXPECT_EQ(outside.coverage, 0);
+    ASSERT_FALSE(outside.IsPrimerSite());
+
+    // check the track against the amplicons
+    for (auto amplicon : ps.GetExpAmplicons())
+    {
+        auto fP = amplicon.GetForwardPrimer();
+        auto rP = amplicon.GetReversePrimer();
+        auto fSite = ps.GetPosition(fP->GetStart());
+        ASSERT_TRUE(fSite.IsPrimerSite());
+        ASSERT_TRUE(fSite.InPrimerPool(fP->GetPrimerPoolID()));
+        ASSERT_TRUE(ps.GetPosition(rP->GetEnd() - 1).InPrimerPool(rP->GetPrimerPoolID()));
+        ASSERT_TRUE(ps.GetPosition(amplicon.GetMinSpan().first).coverage >= 1);
+    }
+    auto site = ps.GetPosition(40);
+    EXPECT_EQ(site.ampliconID, 1);
+    EXPECT_EQ(ps.GetAmpliconName(site.ampliconID), "nCoV-2019_1_LEFT_nCoV-2019_1_RIGHT");
+    ASSERT_TRUE(site.InPrimerPool(ps.GetPrimerPoolID(pool1)));
+    ASSERT_FALSE(site.InPrimerPool(ps.GetPrimerPoolID(pool2)));
+
+    // batch annotation should match the single position lookups
+    std::vector<int64_t> positions;
+    for (int64_t pos = 0; pos <= ps.GetRefEnd() + 10; pos += 7)
+        positions.emplace_back(pos);
+    std::vector<artic::SchemePosition> annotations;
+    ps.AnnotatePositions(positions, annotations);
+    ASSERT_EQ(annotations.size(), positions.size());
+    unsigned int numOverlaps = 0;
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        auto expected = ps.GetPosition(positions[i]);
+        EXPECT_EQ(annotations[i].ampliconID, expected.ampliconID);
+        EXPECT_EQ(annotations[i].coverage, expected.coverage);
+        EXPECT_EQ(annotations[i].primerPools, expected.primerPools);
+        if ((positions[i] >= ps.GetRefStart()) && (positions[i] <= ps.GetRefEnd()))
+        {
+            EXPECT_EQ(annotations[i].IsPrimerSite(), ps.CheckPrimerSite(positions[i]));
+            EXPECT_EQ(annotations[i].IsOverlap(), ps.CheckAmpliconOverlap(positions[i]));
+        }
+        if (annotations[i].IsOverlap())
+            numOverlaps++;
+    }
+    ASSERT_TRUE(numOverlaps > 0);
+}
+
+// primer cursor
+TEST(primerscheme, primerCursor)
+{
+    auto ps = artic::PrimerScheme(inputScheme);
+    auto cursor = ps.GetPrimerCursor();
+
+    // check the cursor against FindPrimers for sorted segments, with some unsorted ones mixed in
+    std::vector<std::pair<int64_t, int64_t>> segments;
+    for (int64_t start = 0; start < ps.GetRefEnd() + 100; start += 37)
+        segments.emplace_back(start, start + 50 + (start * 7919) % 450);
+    for (int64_t i = 0; i < 200; i++)
+        segments.emplace_back((i * 104729) % 30000, (i * 104729) % 30000 + 400);
+    for (auto segment : segments)
+    {
+        // some segments only hit outward facing primers, both lookups should throw for these
+        std::string expected, observed;
+        try
+        {
+            auto amplicon = ps.FindPrimers(segment.first, segment.second);
+            expected = amplicon.GetName() + (amplicon.IsProperlyPaired() ? "\tpaired" : "\tunpaired");
+        }
+        catch (std::runtime_error& err)
+        {
+            expected = err.what();
+        }
+        try
+        {
+            auto amplicon = cursor.FindPrimers(segment.first, segment.second);
+            observed = amplicon.GetName() + (amplicon.IsProperlyPaired() ? "\tpaired" : "\tunpaired");
+        }
+        catch (std::runtime_error& err)
+        {
+            observed = err.what();
+        }
+        ASSERT_EQ(observed, expected) << "segment " << segment.first << "-" << segment.second;
+    }
+
+    // check a reset cursor gives the same results as a new one
+    cursor.Reset();
+    auto pp = cursor.FindPrimers(4046, 4450);
+    ASSERT_TRUE(pp.IsProperlyPaired());
+    EXPECT_EQ(pp.GetName(), std::string("nCoV-2019_14_LEFT_nCoV-2019_14_RIGHT"));
+}
+
+// concurrent queries on a shared scheme (run with BUILD_TSAN to check for data races)
+TEST(primerscheme, concurrentQueries)
+{
+    const auto ps = artic::PrimerScheme(inputScheme);
+    const unsigned int numThreads = 16;
+
+    // get the expected answers from a single thread
+    std::vector<std::pair<int64_t, int64_t>> segments;
+    std::vector<std::string> expectedNames;
+    for (int64_t start = 400; start < 29000; start += 53)
+    {
+        segments.emplace_back(start, start + 350);
+        expectedNames.emplace_back(ps.FindPrimers(start, start + 350).GetName());
+    }
+    artic::kmermap_t expectedKmers;
+    ps.GetPrimerKmers(reference, kSize, expectedKmers);
+
+    // hammer the scheme from many threads, each with its own cursor
+    std::atomic<unsigned int> mismatches(0);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < numThreads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            auto cursor = ps.GetPrimerCursor();
+            for (size_t i = 0; i < segments.size(); i++)
+            {
+                auto segment = segments[i];
+                if (ps.FindPrimers(segment.first, segment.second).GetName() != expectedNames[i])
+                    mismatches++;
+                auto amplicon = cursor.FindPrimers(segment.first, segment.second);
+                if (amplicon.GetName() != expectedNames[i])
+                    mismatches++;
+                if (ps.CheckPrimerSite(segment.first) != ps.GetPosition(segment.first).IsPrimerSite())
+                    mismatches++;
+                if (ps.CheckAmpliconOverlap(segment.first) != ps.GetPosition(segment.first).IsOverlap())
+                    mismatches++;
+                auto id = ps.GetPosition(amplicon.GetMinSpan().first).ampliconID;
+                if (ps.GetAmpliconName(id).empty() || ps.GetAmplicon(id).GetID() != id)
+                    mismatches++;
+            }
+            if (ps.GetNumAmplicons() != ps.GetExpAmplicons().size() || ps.GetPrimerPools().size() != numPools)
+                mismatches++;
+
+            // only some of the threads build the primer k-mers, as it's slower
+            if (t % 4 == 0)
+            {
+                artic::kmermap_t kmers;
+                ps.GetPrimerKmers(reference, kSize, kmers);
+                if (kmers.size() != expectedKmers.size())
+                    mismatches++;
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+    EXPECT_EQ(mismatches.load(), 0);
+}
@@ -0,0 +1,229 @@
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <artic/log.hpp>
+#include <artic/primerScreen.hpp>
+#include <artic/refStore.hpp>
+using namespace artic;
+
+// some test parameters
+const std::string screenScheme = std::string(TEST_DATA_PATH) + "SCoV2.scheme.v3.bed";
+const std::string screenReference = std::string(TEST_DATA_PATH) + "SCoV2.reference.fasta";
+const std::string screenGenomes = std::string(TEST_DATA_PATH) + "primerScreen.test.fasta";
+const unsigned int numScreenGenomes = 10;
+
+// mutate swaps the base at a position for a different one.
+void mutate(std::string& seq, std::size_t pos) { seq[pos] = (seq[pos] == 'A') ? 'C' : 'A'; }
+
+// writeGenomes writes a FASTA of copies of the reference, some with mutations in (or near) the primer sites of the first few amplicons.
+void writeGenomes(const artic::PrimerScheme& ps, const std::string& fileName)
+{
+    artic::RefStore reference(screenReference);
+    std::string ref;
+    reference.GetSeq(ps.GetReferenceName(), 0, reference.GetSeqLen(ps.GetReferenceName()), ref);
+    std::ofstream fh(fileName);
+    for (unsigned int i = 0; i < numScreenGenomes; i++)
+    {
+        std::string genome = ref;
+
+        // 3' end of nCoV-2019_1_LEFT (30-54)
+        if (i < 5)
+            mutate(genome, 53);
+
+        // 5' end of nCoV-2019_2_LEFT (320-342)
+        if (i < 2)
+            mutate(genome, 320);
+
+        // 3' end of nCoV-2019_2_RIGHT (704-726)
+        if (i == 0)
+            mutate(genome, 704);
+
+        // deletion before nCoV-2019_1_RIGHT (385-410), which should still be found
+        if (i == 7)
+            genome.erase(100, 3);
+
+        // single base deletion in the middle of nCoV-2019_5_LEFT (1242-1264), which should count as one edit
+        if (i == 8)
+            genome.erase(1250, 1);
+
+        // Ns over nCoV-2019_3_RIGHT (1004-1028)
+        if (i == 9)
+            genome.replace(1000, 40, std::string(40, 'N'));
+        fh << ">genome_" << i << "\n"
+           << genome << "\n";
+    }
+}
+
+// getCounts returns the screening results for a primer.
+const artic::PrimerScreenCounts& getCounts(const artic::PrimerScreen& screen, const std::string& primerName, std::size_t& primerIndex)
+{
+    const auto& counts = screen.GetCounts();
+    for (primerIndex = 0; primerIndex < counts.size(); primerIndex++)
+        if (counts[primerIndex].primerName == primerName)
+            return counts[primerIndex];
+    throw std::runtime_error("primer not found in screen: " + primerName);
+}
+
+// screening primer sites against a genome collection
+TEST(primerscreen, screen)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("screen_primers");
+    artic::PrimerScheme ps(screenScheme);
+    writeGenomes(ps, screenGenomes);
+    EXPECT_THROW(artic::PrimerScreen(&ps, screenReference, {screenGenomes}, 0), std::runtime_error);
+
+    // check the input and parameter errors
+    std::ostringstream discard;
+    artic::PrimerScreen noFiles(&ps, screenReference, {}, 1, discard);
+    EXPECT_THROW(noFiles.Run(), std::runtime_error);
+    artic::PrimerScreen missingFile(&ps, screenReference, {screenGenomes + ".missing"}, 1, discard);
+    EXPECT_THROW(missingFile.Run(), std::runtime_error);
+    EXPECT_THROW(missingFile.SetThreePrimeWeighting(5, 0), std::runtime_error);
+    EXPECT_THROW(missingFile.SetRiskScore(0), std::runtime_error);
+    EXPECT_THROW(missingFile.SetRiskProportion(0), std::runtime_error);
+    EXPECT_THROW(missingFile.SetRiskProportion(1.5), std::runtime_error);
+    EXPECT_THROW(missingFile.IsAtRisk(missingFile.GetCounts().size()), std::runtime_error);
+
+    // run the screen with a single worker
+    std::ostringstream output;
+    artic::PrimerScreen screen(&ps, screenReference, {screenGenomes}, 1, output);
+    screen.Run();
+    EXPECT_EQ(screen.GetNumGenomes(), numScreenGenomes);
+    ASSERT_EQ(screen.GetCounts().size(), ps.GetNumAmplicons() * 2);
+
+    // a 3' mismatch puts a primer at risk, a 5' one doesn't
+    std::size_t primerIndex;
+    auto counts = getCounts(screen, "nCoV-2019_1_LEFT", primerIndex);
+    EXPECT_EQ(counts.mismatched, 5);
+    EXPECT_EQ(counts.threePrime, 5);
+    EXPECT_EQ(counts.atRisk, 5);
+    EXPECT_TRUE(screen.IsAtRisk(primerIndex));
+    counts = getCounts(screen, "nCoV-2019_2_LEFT", primerIndex);
+    EXPECT_EQ(counts.mismatched, 2);
+    EXPECT_EQ(counts.threePrime, 0);
+    EXPECT_EQ(counts.atRisk, 0);
+    EXPECT_FALSE(screen.IsAtRisk(primerIndex));
+
+    // the 3' end of a reverse primer is at the start of the site
+    counts = getCounts(screen, "nCoV-2019_2_RIGHT", primerIndex);
+    EXPECT_EQ(counts.threePrime, 1);
+    EXPECT_EQ(counts.atRisk, 1);
+    EXPECT_TRUE(screen.IsAtRisk(primerIndex));
+    std::size_t reverseIndex = primerIndex;
+
+    // an indel in a site is a single edit
+    counts = getCounts(screen, "nCoV-2019_5_LEFT", primerIndex);
+    EXPECT_EQ(counts.mismatched, 1);
+    EXPECT_EQ(counts.threePrime, 0);
+    EXPECT_EQ(counts.atRisk, 0);
+
+    // indels outside a site are searched past, Ns at a site are no data
+    counts = getCounts(screen, "nCoV-2019_1_RIGHT", primerIndex);
+    EXPECT_EQ(counts.mismatched, 0);
+    EXPECT_EQ(counts.noData, 0);
+    counts = getCounts(screen, "nCoV-2019_3_RIGHT", primerIndex);
+    EXPECT_EQ(counts.mismatched, 0);
+    EXPECT_EQ(counts.noData, 1);
+
+    // the rest of the primers match every genome
+    uint64_t totalMismatched = 0;
+    for (const auto& primer : screen.GetCounts())
+        totalMismatched += primer.mismatched;
+    EXPECT_EQ(totalMismatched, 9);
+
+    // there is a header plus a line per primer
+    std::istringstream lines(output.str());
+    std::string line;
+    std::size_t numLines = 0;
+    while (std::getline(lines, line))
+    {
+        EXPECT_EQ(line[0] == '#', numLines == 0);
+        numLines++;
+    }
+    EXPECT_EQ(numLines, screen.GetCounts().size() + 1);
+
+    // the risk proportion decides if a primer is reported
+    screen.SetRiskProportion(0.2);
+    EXPECT_FALSE(screen.IsAtRisk(reverseIndex));
+
+    // more workers should give the same counts
+    artic::PrimerScreen threaded(&ps, screenReference, {screenGenomes, screenGenomes}, 4, discard);
+    threaded.Run();
+    EXPECT_EQ(threaded.GetNumGenomes(), numScreenGenomes * 2);
+    for (std::size_t i = 0; i < screen.GetCounts().size(); i++)
+    {
+        EXPECT_EQ(threaded.GetCounts()[i].mismatched, screen.GetCounts()[i].mismatched * 2);
+        EXPECT_EQ(threaded.GetCounts()[i].threePrime, screen.GetCounts()[i].threePrime * 2);
+        EXPECT_EQ(threaded.GetCounts()[i].atRisk, screen.GetCounts()[i].atRisk * 2);
+        EXPECT_EQ(threaded.GetCounts()[i].noData, screen.GetCounts()[i].noData * 2);
+    }
+    std::remove(screenGenomes.c_str());
+}
+
+// the SIMD kernel should give the same results as the scalar one
+TEST(primerscreen, kernels)
+{
+    if (!artic::Log::GetClientLogger())
+        artic::Log::Init("screen_primers");
+    artic::PrimerScheme ps(screenScheme);
+
+    // write genomes with random substitutions, indels and Ns, and with trimmed ends of different lengths (so the groups of genomes have different windows)
+    artic::RefStore reference(screenReference);
+    std::string ref;
+    reference.GetSeq(ps.GetReferenceName(), 0, reference.GetSeqLen(ps.GetReferenceName()), ref);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::size_t> posDist(0, ref.size() - 1);
+    std::uniform_int_distribution<int> baseDist(0, 4);
+    std::ofstream fh(screenGenomes);
+    const unsigned int numGenomes = 23;
+    for (unsigned int i = 0; i < numGenomes; i++)
+    {
+        std::string genome = ref;
+        for (unsigned int j = 0; j < 300; j++)
+            genome[posDist(rng) % genome.size()] = "ACGTN"[baseDist(rng)];
+        for (unsigned int j = 0; j < 20; j++)
+        {
+            auto pos = posDist(rng) % genome.size();
+            if (j % 2)
+                genome.erase(pos, 1 + j % 3);
+            else
+                genome.insert(pos, std::string(1 + j % 3, "ACGT"[j % 4]));
+        }
+        genome = genome.substr((i % 3) * 20, genome.size() - (i % 5) * 60);
+        fh << ">genome_" << i << "\n"
+           << genome << "\n";
+    }
+    fh.close();
+
+    std::ostringstream discard;
+    artic::PrimerScreen scalar(&ps, screenReference, {screenGenomes}, 2, discard);
+    scalar.SetKernel(artic::KmerKernel::scalar);
+    scalar.Run();
+    EXPECT_EQ(scalar.GetNumGenomes(), numGenomes);
+    uint64_t totalMismatched = 0;
+    for (const auto& primer : scalar.GetCounts())
+        totalMismatched += primer.mismatched;
+    EXPECT_GT(totalMismatched, 0);
+    if (artic::GetKmerKernel() == artic::KmerKernel::avx2)
+    {
+        artic::PrimerScreen simd(&ps, screenReference, {screenGenomes}, 2, discard);
+        simd.SetKernel(artic::KmerKernel::avx2);
+        simd.Run();
+        for (std::size_t i = 0; i < scalar.GetCounts().size(); i++)
+        {
+            EXPECT_EQ(simd.GetCounts()[i].noData, scalar.GetCounts()[i].noData) << scalar.GetCounts()[i].primerName;
+            EXPECT_EQ(simd.GetCounts()[i].mismatched, scalar.GetCounts()[i].mismatched) << scalar.GetCounts()[i].primerName;
+            EXPECT_EQ(simd.GetCounts()[i].threePrime, scalar.GetCounts()[i].threePrime) << scalar.GetCounts()[i].primerName;
+            EXPECT_EQ(simd.GetCounts()[i].atRisk, scalar.GetCounts()[i].atRisk) << scalar.GetCounts()[i].primerName;
+        }
+    }
+    else
+        EXPECT_THROW(scalar.SetKernel(artic::KmerKernel::avx2), std::runtime_error);
+    std::remove(screenGenomes.c_str());
+}
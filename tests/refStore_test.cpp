@@ -0,0 +1,120 @@
+#include <fstream>
+#include <gtest/gtest.h>
+#include <htslib/faidx.h>
+#include <string>
+
+#include <artic/kmers.hpp>
+#include <artic/primerScheme.hpp>
+#include <artic/refStore.hpp>
+using namespace artic;
+
+// some test parameters
+const std::string refFile = std::string(TEST_DATA_PATH) + "SCoV2.reference.fasta";
+const std::string refName = "MN908947.3";
+const std::string schemeFile = std::string(TEST_DATA_PATH) + "SCoV2.scheme.v3.bed";
+const int64_t refLen = 29903;
+
+// store constructor
+TEST(refstore, constructor)
+{
+    try
+    {
+        artic::RefStore store(std::string(TEST_DATA_PATH) + "missing.fasta");
+        FAIL() << "expected a missing file error";
+    }
+    catch (std::runtime_error& err)
+    {
+        EXPECT_EQ(err.what(), std::string("supplied reference file does not exist:\t") + TEST_DATA_PATH + "missing.fasta");
+    }
+    artic::RefStore store(refFile);
+    EXPECT_EQ(store.GetNumSeqs(), 1);
+    ASSERT_TRUE(store.HasSeq(refName));
+    ASSERT_FALSE(store.HasSeq("foo"));
+    EXPECT_EQ(store.GetSeqLen(refName), refLen);
+    EXPECT_EQ(store.GetPackedSize(), ((refLen + 31) / 32) * sizeof(uint64_t));
+}
+
+// sequence decoding, checked against faidx
+TEST(refstore, seq)
+{
+    artic::RefStore store(refFile);
+    faidx_t* fai = fai_load(refFile.c_str());
+    std::string seq;
+    for (int64_t start = 0; start < refLen; start += 997)
+    {
+        int64_t end = std::min(start + 250, refLen);
+        int len;
+        char* expected = faidx_fetch_seq(fai, refName.c_str(), start, end - 1, &len);
+        store.GetSeq(refName, start, end, seq);
+        EXPECT_EQ(seq, std::string(expected));
+        EXPECT_EQ(store.CountMismatches(refName, start, expected, len), 0);
+        free(expected);
+    }
+    if (fai)
+        fai_destroy(fai);
+    store.GetSeq(refName, 30, 54, seq);
+    EXPECT_EQ(seq, "ACCAACCAACTTTCGATCTCTTGT");
+    EXPECT_EQ(store.CountMismatches(refName, 30, "ACCAACCAACTTTCGATCTCTTGA", 24), 1);
+    EXPECT_EQ(store.CountMismatches(refName, 30, "NCCAACCAACTTTCGATCTCTTGA", 24), 2);
+    EXPECT_THROW(store.GetSeq(refName, refLen - 10, refLen + 1, seq), std::runtime_error);
+    EXPECT_THROW(store.GetSeq("foo", 0, 10, seq), std::runtime_error);
+}
+
+// N runs and k-mers
+TEST(refstore, nRuns)
+{
+    std::string testFile = std::string(TEST_DATA_PATH) + "refStore.test.fasta";
+    std::string testSeq = "ACGTANNNNACGTTGCArykACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTAC";
+    std::ofstream fh(testFile);
+    fh << ">seq1 test sequence\n"
+       << testSeq.substr(0, 20) << "\n"
+       << testSeq.substr(20) << "\n"
+       << ">seq2\nacgtn\n";
+    fh.close();
+    artic::RefStore store(testFile);
+    std::remove(testFile.c_str());
+    ASSERT_EQ(store.GetNumSeqs(), 2);
+    EXPECT_EQ(store.GetSeqLen("seq1"), testSeq.size());
+
+    // decoded sequence should be uppercase with N for non-ACGT
+    std::string seq;
+    store.GetSeq("seq1", 0, testSeq.size(), seq);
+    EXPECT_EQ(seq, "ACGTANNNNACGTTGCANNNACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTAC");
+    store.GetSeq("seq1", 6, 19, seq);
+    EXPECT_EQ(seq, "NNNACGTTGCANN");
+    store.GetSeq("seq2", 0, 5, seq);
+    EXPECT_EQ(seq, "ACGTN");
+    EXPECT_EQ(store.CountMismatches("seq1", 4, "ANNNNA", 6), 4);
+}
+
+// primer sequences and k-mers from the store should match faidx
+TEST(refstore, primers)
+{
+    artic::RefStore store(refFile);
+    auto ps = artic::PrimerScheme(schemeFile);
+    faidx_t* fai = fai_load(refFile.c_str());
+    std::string seq1, seq2;
+    for (const auto& amplicon : ps.GetExpAmplicons())
+    {
+        for (auto primer : {amplicon.GetForwardPrimer(), amplicon.GetReversePrimer()})
+        {
+            primer->GetSeq(fai, ps.GetReferenceName(), seq1);
+            primer->GetSeq(store, ps.GetReferenceName(), seq2);
+            EXPECT_EQ(seq1, seq2);
+        }
+    }
+    if (fai)
+        fai_destroy(fai);
+
+    // k-mers from the file and the store should be identical
+    artic::kmermap_t kmerMap1, kmerMap2;
+    ps.GetPrimerKmers(refFile, 17, kmerMap1);
+    ps.GetPrimerKmers(store, 17, kmerMap2);
+    EXPECT_EQ(kmerMap1.size(), kmerMap2.size());
+    for (const auto& kmer : kmerMap1)
+    {
+        auto it = kmerMap2.find(kmer.first);
+        ASSERT_TRUE(it != kmerMap2.end());
+        EXPECT_EQ(it->second, kmer.second);
+    }
+}
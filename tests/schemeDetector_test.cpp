@@ -0,0 +1,100 @@
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <artic/schemeDetector.hpp>
+#include <tests/testHelpers.hpp>
+using namespace artic;
+
+// some test parameters
+const std::string detectorScheme = std::string(TEST_DATA_PATH) + "SCoV2.scheme.v3.bed";
+const std::string detectorReference = std::string(TEST_DATA_PATH) + "SCoV2.reference.fasta";
+const std::string detectorPrefix = std::string(TEST_DATA_PATH) + "schemeDetector.test";
+
+// writeSchemes writes two variants of the test scheme: one with every primer moved 150 bases along (dropping the last amplicon), and one with extra alts for some left primers, starting 10 bases further out (like V4 to V4.1).
+void writeSchemes(const std::string& shiftedFile, const std::string& extendedFile)
+{
+    std::ifstream fh(detectorScheme);
+    std::ofstream shifted(shiftedFile);
+    std::ofstream extended(extendedFile);
+    std::string line;
+    while (std::getline(fh, line))
+    {
+        std::istringstream fields(line);
+        std::string refID, primerID, pool, strand;
+        int64_t start, end;
+        fields >> refID >> start >> end >> primerID >> pool >> strand;
+        extended << line << "\n";
+        if (primerID.find("_98_") == std::string::npos)
+            shifted << refID << "\t" << start + 150 << "\t" << end + 150 << "\t" << primerID << "\t" << pool << "\t" << strand << "\n";
+        auto ampliconNum = std::stoi(primerID.substr(primerID.find('_') + 1));
+        if (ampliconNum % 10 == 0 && primerID.find("_LEFT") != std::string::npos && primerID.find("_alt") == std::string::npos)
+            extended << refID << "\t" << start - 10 << "\t" << end - 10 << "\t" << primerID << "_alt9\t" << pool << "\t" << strand << "\n";
+    }
+}
+
+// detecting the scheme used for simulated reads
+TEST(schemedetector, detect)
+{
+    writeSchemes(detectorPrefix + ".shifted.bed", detectorPrefix + ".extended.bed");
+    std::vector<artic::PrimerScheme> schemes;
+    for (const auto& schemeFile : {detectorScheme, detectorPrefix + ".shifted.bed", detectorPrefix + ".extended.bed"})
+        schemes.emplace_back(schemeFile);
+    std::vector<std::string> names = {"v3", "shifted", "extended"};
+    artic::RefStore reference(detectorReference);
+    EXPECT_THROW(artic::SchemeDetector({}, {}, reference), std::runtime_error);
+    std::vector<artic::PrimerScheme> single;
+    single.emplace_back(detectorScheme);
+    EXPECT_THROW(artic::SchemeDetector(single, {"v3"}, reference), std::runtime_error);
+    EXPECT_THROW(artic::SchemeDetector(schemes, {"v3"}, reference), std::runtime_error);
+    EXPECT_THROW(artic::SchemeDetector(schemes, names, reference, 15, 10), std::runtime_error);
+    EXPECT_THROW(artic::SchemeDetector(schemes, names, reference, 15, 100, 0), std::runtime_error);
+
+    // nothing is seen until reads are added
+    artic::SchemeDetector empty(schemes, names, reference);
+    EXPECT_EQ(empty.GetNumSchemes(), 3);
+    EXPECT_EQ(empty.GetSchemeName(1), "shifted");
+    EXPECT_THROW(empty.GetSchemeName(3), std::runtime_error);
+    EXPECT_GT(empty.GetNumKmers(), 0);
+    EXPECT_LT(empty.GetMemoryUsage(), 1024 * 1024);
+    EXPECT_EQ(empty.GetScores().front().numSeen, 0);
+    EXPECT_EQ(empty.GetConfidence(), 0);
+
+    // reads from each scheme should pick that scheme, even though the primers of the others are inside the reads
+    for (std::size_t schemeID = 0; schemeID < schemes.size(); schemeID++)
+    {
+        artic::SchemeDetector detector(schemes, names, reference);
+        auto reads = simulateAmpliconReads(schemes[schemeID], reference, 4);
+        for (const auto& read : reads)
+            detector.AddRead(read.seq);
+        EXPECT_EQ(detector.GetNumReads(), reads.size());
+        auto scores = detector.GetScores();
+        ASSERT_EQ(scores.size(), schemes.size());
+        EXPECT_EQ(scores.front().schemeID, schemeID);
+        EXPECT_GT(scores.front().containment, 0.9);
+        EXPECT_GT(detector.GetConfidence(), 0.9);
+        for (std::size_t i = 1; i < scores.size(); i++)
+        {
+            EXPECT_GT(scores[i - 1].score, scores[i].score);
+        }
+    }
+
+    // reads can be streamed from a FASTQ file, up to a limit
+    {
+        std::ofstream fh(detectorPrefix + ".fastq");
+        for (const auto& read : simulateAmpliconReads(schemes[0], reference, 4))
+            fh << "@" << read.name << "\n"
+               << read.seq << "\n+\n"
+               << std::string(read.seq.size(), 'I') << "\n";
+    }
+    artic::SchemeDetector detector(schemes, names, reference);
+    EXPECT_EQ(detector.AddReads(detectorPrefix + ".fastq", 10), 10);
+    EXPECT_EQ(detector.AddReads(detectorPrefix + ".fastq", 15), 5);
+    EXPECT_EQ(detector.GetNumReads(), 15);
+    EXPECT_THROW(detector.AddReads(detectorPrefix + ".missing.fastq"), std::runtime_error);
+    for (const auto& suffix : {".shifted.bed", ".extended.bed", ".fastq"})
+        std::remove((detectorPrefix + suffix).c_str());
+}
@@ -0,0 +1,41 @@
+#ifndef TESTHELPERS_H
+#define TESTHELPERS_H
+
+#include <string>
+#include <vector>
+
+#include <artic/kmers.hpp>
+#include <artic/primerScheme.hpp>
+#include <artic/refStore.hpp>
+
+// simulatedRead is a read simulated from an amplicon.
+struct simulatedRead
+{
+    std::string name; // the amplicon name and read number (<amplicon>_<i>)
+    std::string seq;  // the read sequence
+};
+
+// reverseComplement returns the reverse complement of a sequence.
+inline std::string reverseComplement(const std::string& seq)
+{
+    std::string rc(seq.rbegin(), seq.rend());
+    for (auto& base : rc)
+        base = artic::char2nt[3 - artic::nt2char[uint8_t(base)]];
+    return rc;
+}
+
+// simulateAmpliconReads returns reads for every amplicon in a scheme, spanning the outermost primers (every other read reverse complemented).
+inline std::vector<simulatedRead> simulateAmpliconReads(const artic::PrimerScheme& ps, const artic::RefStore& reference, unsigned int readsPerAmplicon)
+{
+    std::vector<simulatedRead> reads;
+    std::string seq;
+    for (const auto& amplicon : ps.GetExpAmplicons())
+    {
+        reference.GetSeq(ps.GetReferenceName(), amplicon.GetForwardPrimer()->GetStart(), amplicon.GetReversePrimer()->GetEnd(), seq);
+        for (unsigned int i = 0; i < readsPerAmplicon; i++)
+            reads.push_back({amplicon.GetName() + "_" + std::to_string(i), (i % 2) ? reverseComplement(seq) : seq});
+    }
+    return reads;
+}
+
+#endif